@@ -15,9 +15,17 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#endif
 #include "var.h"
 #include "functions.h"
-#include <string.h>
 
 int breakthroughBTM(int max)
 {
@@ -112,173 +120,298 @@ int breakthrough(int cdepth,int stdscore,int max)
     return best;
 }
 
-void generate_breakthrough()
+/* the breakthrough index is a mixed base 2/3 number over the fields in
+   front of the white men. btDigit lists its digits, least significant
+   first: with radix 3 the digit is 1 for a black and 2 for a white man,
+   with radix 2 only men of the given colour count. The black side uses
+   the mirrored fields with the colours swapped */
+#define BTDIGITS 15
+#define BTSIZE (128*6561)
+
+static const struct {char ip,radix,colour;} btDigit[BTDIGITS]={
+    {25,2,white},{21,2,black},{20,3,0},{17,2,black},{16,3,0},{15,3,0},
+    {12,2,black},{11,3,0},{10,3,0},{7,3,0},{6,3,0},{5,3,0},
+    {2,2,black},{1,2,black},{0,2,black}
+};
+
+/* btIndex[side][colour][k][b] is the index contribution of the men of
+   colour whose man_bits byte k (counted from bit 0 for the white side and
+   from bit 24 for the black side) is b */
+static int btIndex[2][2][4][256];
+static int btLoaded=false;  /* breakThrough holds the table */
+
+static void init_btindex(void)
 {
-    int field;
-    int i1,i2,i3,i6,i7,i8,i11,i12,i13,i16,i17,i18,i21,i22,i26;
-    int index=0;
-    int res;
-    FILE *out;
-    int max;
-    
-    tneval=0;
-    for (i1=0;i1<2;i1++)
-    for (i2=0;i2<2;i2++)
-    for (i3=0;i3<2;i3++)
-    for (i6=0;i6<3;i6++)
-    for (i7=0;i7<3;i7++)
-    for (i8=0;i8<3;i8++)
-    for (i11=0;i11<3;i11++)
-    for (i12=0;i12<3;i12++)
-    for (i13=0;i13<2;i13++)
-    for (i16=0;i16<3;i16++)
-    for (i17=0;i17<3;i17++)
-    for (i18=0;i18<2;i18++)
-    for (i21=0;i21<3;i21++)
-    for (i22=0;i22<2;i22++)
-    for (i26=0;i26<2;i26++) {
-        init_board();
-        for(field=0;field<50;field++) board[map[field]]=empty;
-        if (i1==1) board[F1]=black|man;
-        if (i2==1) board[F2]=black|man;
-        if (i3==1) board[F3]=black|man;
+    int d,w,side,c,ip,rel,v,add;
+
+    memset(btIndex,0,sizeof(btIndex));
+    w=1;
+    for(d=0;d<BTDIGITS;d++) {
+        for(side=0;side<2;side++) for(c=0;c<2;c++) {
+            if (btDigit[d].radix==3) add=(c==(white^side)) ? 2*w : w;
+            else add=(c==(btDigit[d].colour^side)) ? w : 0;
+            if (add==0) continue;
+            ip=side==0 ? btDigit[d].ip : 49-btDigit[d].ip;
+            rel=ip-24*side;
+            for(v=0;v<256;v++) if (v&(1<<(rel&7))) btIndex[side][c][rel>>3][v]+=add;
+        }
+        w*=btDigit[d].radix;
+    }
+}
 
-        if (i6==1) board[F6]=black|man;
-        if (i6==2) board[F6]=white|man;
-        if (i7==1) board[F7]=black|man;
-        if (i7==2) board[F7]=white|man;
-        if (i8==1) board[F8]=black|man;
-        if (i8==2) board[F8]=white|man;
+static int bt_index(int side)
+{
+    unsigned INT64 mw,mb;
+    int (*tw)[256],(*tb)[256];
 
-        if (i11==1) board[F11]=black|man;
-        if (i11==2) board[F11]=white|man;
-        if (i12==1) board[F12]=black|man;
-        if (i12==2) board[F12]=white|man;
-        if (i13==1) board[F13]=black|man;
+    mw=man_bits[white]>>(24*side);
+    mb=man_bits[black]>>(24*side);
+    tw=btIndex[side][white];
+    tb=btIndex[side][black];
+    return tw[0][mw&255]+tw[1][(mw>>8)&255]+tw[2][(mw>>16)&255]+tw[3][(mw>>24)&255]+
+           tb[0][mb&255]+tb[1][(mb>>8)&255]+tb[2][(mb>>16)&255]+tb[3][(mb>>24)&255];
+}
 
-        if (i16==1) board[F16]=black|man;
-        if (i16==2) board[F16]=white|man;
-        if (i17==1) board[F17]=black|man;
-        if (i17==2) board[F17]=white|man;
-        if (i18==1) board[F18]=black|man;
-        
-        if (i21==1) board[F21]=black|man;
-        if (i21==2) board[F21]=white|man;
-        if (i22==1) board[F22]=black|man;
-        
-        if (i26==1) board[F26]=white|man;
-        set_pieces();
-        
-        if (quiet(white)==true) {
-            for (max=2;max<18;max+=2) {
-                neval=0;
-                res=breakthrough(0,0,max);
-                if (res!=127) break;
+static void bt_set_board(int index)
+/* sets up the position of a white side index */
+{
+    int d,v,field;
+
+    init_board();
+    for(field=0;field<50;field++) board[map[field]]=empty;
+    for(d=0;d<BTDIGITS;d++) {
+        v=index%btDigit[d].radix;
+        index/=btDigit[d].radix;
+        if (v==0) continue;
+        if (btDigit[d].radix==3) board[map[(int)btDigit[d].ip]]=(v==1 ? black : white)|man;
+        else board[map[(int)btDigit[d].ip]]=btDigit[d].colour|man;
+    }
+    set_pieces();
+}
+
+static void bt_generate(int index,char *wtm,char *btm)
+/* breakthrough distances of one index with white and black to move */
+{
+    int max,res;
+
+    bt_set_board(index);
+    *wtm=127;
+    if (quiet(white)==true) {
+        for (max=2;max<18;max+=2) {
+            neval=0;
+            res=breakthrough(0,0,max);
+            if (res!=127) break;
+        }
+        *wtm=res;
+    }
+    *btm=127;
+    if (quiet(black)==true) {
+        neval=0;
+        *btm=breakthroughBTM(0);
+    }
+}
+
+#ifndef _WIN32
+static void bt_worker(int out,int first,int step)
+/* computes every step-th index from first and writes the pairs in order */
+{
+    char buf[2*1024];
+    int index,n=0;
+
+    for(index=first;index<BTSIZE;index+=step) {
+        bt_generate(index,&buf[n],&buf[n+1]);
+        n+=2;
+        if (n==sizeof(buf) || index+step>=BTSIZE) {
+            if (write(out,buf,n)!=n) _exit(-1);
+            n=0;
+        }
+    }
+    _exit(0);
+}
+
+static int bt_parallel(int n)
+/* fills breakThrough with n forked workers, false when that fails */
+{
+    int fd[64],i,k,index,got,r;
+    pid_t pid[64];
+    char buf[2*1024];
+
+    if (n>64) n=64;
+    for(i=0;i<n;i++) {
+        int p[2];
+        if (pipe(p)!=0) break;
+        fflush(stdout);
+        pid[i]=fork();
+        if (pid[i]<0) {close(p[0]); close(p[1]); break;}
+        if (pid[i]==0) {
+            for(k=0;k<i;k++) close(fd[k]);
+            close(p[0]);
+            bt_worker(p[1],i,n);
+        }
+        close(p[1]);
+        fd[i]=p[0];
+    }
+    if (i<n) {
+        for(k=0;k<i;k++) {close(fd[k]); kill(pid[k],SIGKILL); waitpid(pid[k],NULL,0);}
+        return(false);
+    }
+    /* worker i sends the indices i, i+n, ... so read them back round robin */
+    for(i=0;i<n;i++) {
+        index=i;
+        while (index<BTSIZE) {
+            got=0;
+            k=(BTSIZE-index+n-1)/n;
+            if (k>(int) sizeof(buf)/2) k=sizeof(buf)/2;
+            while (got<2*k) {
+                r=read(fd[i],buf+got,2*k-got);
+                if (r<=0) break;
+                got+=r;
             }
-            
-            if (quiet(white)==true && quiet(black)==true) {
-                //display_board();
-                printf("%i %i %i %llu\n",index,res,neval,tneval);
+            if (got<2*k) break;
+            for(r=0;r<k;r++,index+=n) {
+                breakThrough[index]=buf[2*r];
+                breakThrough[index+BTSIZE]=buf[2*r+1];
             }
-            breakThrough[index]=res;
-        }  else {
-            breakThrough[index]=127;
         }
-        
-        if (quiet(black)==true) {
-            neval=0;
-            res=breakthroughBTM(max);
-            if (quiet(white)==true && quiet(black)==true) {
-                //display_board();
-                printf("%i %i %i %llu\n",index,res,neval,tneval);
+        close(fd[i]);
+        waitpid(pid[i],NULL,0);
+        if (index<BTSIZE) {
+            for(k=i+1;k<n;k++) {close(fd[k]); kill(pid[k],SIGKILL); waitpid(pid[k],NULL,0);}
+            return(false);
+        }
+    }
+    return(true);
+}
+#endif
+
+#ifndef _WIN32
+static int bt_lock(void)
+/* takes tables/bt.lock, so only one process generates the table. The lock
+   is a file with the pid, written under a name of this process and linked
+   into place, so it is never seen without the pid. The lock of a process
+   that is gone is taken over. False if another one has it */
+{
+    char text[32],tmp[64];
+    int fd,n,pid,r;
+
+    sprintf(tmp,"tables/bt.%i.lock",(int) getpid());
+    sprintf(text,"%i\n",(int) getpid());
+    fd=open(tmp,O_WRONLY|O_CREAT|O_TRUNC,0644);
+    if (fd<0) return(true);  /* no lock without tables/, and no table either */
+    n=write(fd,text,strlen(text));
+    close(fd);
+    if (n!=(int) strlen(text)) {
+        remove(tmp);
+        return(true);
+    }
+    while (true) {
+        r=link(tmp,"tables/bt.lock");
+        if (r==0 || errno!=EEXIST) {
+            /* without hard links there is no lock */
+            remove(tmp);
+            return(true);
+        }
+        fd=open("tables/bt.lock",O_RDONLY);
+        if (fd<0) continue;
+        n=read(fd,text,sizeof(text)-1);
+        close(fd);
+        if (n>0) {
+            text[n]=0;
+            pid=atoi(text);
+            if (pid>0 && (kill(pid,0)==0 || errno!=ESRCH)) {
+                remove(tmp);
+                return(false);
             }
-            breakThrough[index+128*6561]=res;
-        } else {
-            breakThrough[index+128*6561]=127;
-        }    
-        index++;
+        }
+        /* gone, or an empty lock that a crash left behind */
+        remove("tables/bt.lock");
+    }
+}
+
+static void bt_unlock(void)
+{
+    remove("tables/bt.lock");
+}
+#else
+#define bt_lock() true
+#define bt_unlock()
+#endif
+
+static void bt_build(void)
+/* computes the breakthrough table, in parallel where fork is available,
+   and saves it as tables/bt.bin */
+{
+    int index,ok=false,fd;
+    BTYPE save[93];
+    FILE *out=NULL;
+    char tmp[64];
+
+    memcpy(save,board,sizeof(save));
+    tneval=0;
+#ifndef _WIN32
+    {
+        long n=sysconf(_SC_NPROCESSORS_ONLN);
+        if (n>1) ok=bt_parallel((int) n);
+    }
+#endif
+    if (ok==false) {
+        for(index=0;index<BTSIZE;index++) {
+            bt_generate(index,&breakThrough[index],&breakThrough[index+BTSIZE]);
+        }
     }
-    out=fopen("tables/bt.bin","wb");
+    memcpy(board,save,sizeof(save));
+    set_pieces();
+    btLoaded=true;
+
+    /* written under a name of this process first, so a reader never sees
+       half a table */
+#ifndef _WIN32
+    sprintf(tmp,"tables/bt.%i.tmp",(int) getpid());
+    fd=open(tmp,O_WRONLY|O_CREAT|O_EXCL,0644);
+    if (fd>=0 && (out=fdopen(fd,"wb"))==NULL) close(fd);
+#else
+    strcpy(tmp,"tables/bt.tmp");
+    out=fopen(tmp,"wb");
+#endif
     if (out!=NULL) {
-        fwrite(breakThrough,sizeof(char),2*128*6561,out);
-    } else printf("write error\n");
-    fclose(out);
+        if (fwrite(breakThrough,sizeof(char),2*BTSIZE,out)==2*BTSIZE) {
+            fclose(out);
+            if (rename(tmp,"tables/bt.bin")==0) return;
+            remove("tables/bt.bin");
+            if (rename(tmp,"tables/bt.bin")==0) return;
+        } else fclose(out);
+        remove(tmp);
+    }
+    dprint("could not write tables/bt.bin\n");
+}
 
+void generate_breakthrough()
+/* computes the breakthrough table and saves it, unless another process is
+   doing that */
+{
+    if (bt_lock()==false) {
+        dprint("tables/bt.bin is being generated by another process\n");
+        return;
+    }
+    bt_build();
+    bt_unlock();
 }
 
 int btEval(color)
 {
     int index;
     int mm,om;
-    int tmp;
         
+    if (btLoaded==false) return 0;
     if (pieces[white|crown]!=0 || pieces[black|crown]!=0) return 0;
-    index=0;
-    if (board[F26]==(white|man)) index+=1;
-    
-    if (board[F22]==(black|man)) index+=2*1;
-    if (board[F21]==(black|man)) index+=4*1;
-    if (board[F21]==(white|man)) index+=4*2;
-
-    if (board[F18]==(black|man)) index+=12*1;
-    if (board[F17]==(black|man)) index+=24*1;
-    if (board[F17]==(white|man)) index+=24*2;
-    if (board[F16]==(black|man)) index+=72*1;
-    if (board[F16]==(white|man)) index+=72*2;
-
-    if (board[F13]==(black|man)) index+=216*1;
-    if (board[F12]==(black|man)) index+=432*1;
-    if (board[F12]==(white|man)) index+=432*2;
-    if (board[F11]==(black|man)) index+=1296*1;
-    if (board[F11]==(white|man)) index+=1296*2;
-
-    if (board[F8]==(black|man)) index+=3888*1;
-    if (board[F8]==(white|man)) index+=3888*2;
-    if (board[F7]==(black|man)) index+=11664*1;
-    if (board[F7]==(white|man)) index+=11664*2;
-    if (board[F6]==(black|man)) index+=34992*1;
-    if (board[F6]==(white|man)) index+=34992*2;
-    
-    if (board[F3]==(black|man)) index+=104976*1;
-    if (board[F2]==(black|man)) index+=209952*1;
-    if (board[F1]==(black|man)) index+=419904*1;
-    
+    index=bt_index(0);
     if (color==white) {
         mm=breakThrough[index];
     } else {
         om=breakThrough[index+128*6561];
     }
     //dprint("%i %i\n",index,btw);
-    index=0;
-    if (board[F25]==(black|man)) index+=1;
-    
-    if (board[F29]==(white|man)) index+=2*1;
-    if (board[F30]==(white|man)) index+=4*1;
-    if (board[F30]==(black|man)) index+=4*2;
-
-    if (board[F33]==(white|man)) index+=12*1;
-    if (board[F34]==(white|man)) index+=24*1;
-    if (board[F34]==(black|man)) index+=24*2;
-    if (board[F35]==(white|man)) index+=72*1;
-    if (board[F35]==(black|man)) index+=72*2;
-
-    if (board[F38]==(white|man)) index+=216*1;
-    if (board[F39]==(white|man)) index+=432*1;
-    if (board[F39]==(black|man)) index+=432*2;
-    if (board[F40]==(white|man)) index+=1296*1;
-    if (board[F40]==(black|man)) index+=1296*2;
-
-    if (board[F43]==(white|man)) index+=3888*1;
-    if (board[F43]==(black|man)) index+=3888*2;
-    if (board[F44]==(white|man)) index+=11664*1;
-    if (board[F44]==(black|man)) index+=11664*2;
-    if (board[F45]==(white|man)) index+=34992*1;
-    if (board[F45]==(black|man)) index+=34992*2;
-    
-    if (board[F48]==(white|man)) index+=104976*1;
-    if (board[F49]==(white|man)) index+=209952*1;
-    if (board[F50]==(white|man)) index+=419904*1;
-
+    index=bt_index(1);
     if (color==white) {
         om=breakThrough[index+128*6561];
     } else {
@@ -322,16 +455,42 @@ int btEval(color)
     return 0;
 }
 
-void loadBreakThrough()
+static int bt_read(void)
+/* reads tables/bt.bin, true if it is complete */
 {
     FILE *in;
-    
+    int n=0;
+
     in=my_fopen("tables/bt.bin","rb");
     if (in!=NULL) {
-        fread(breakThrough,sizeof(char),2*128*6561,in);
+        n=fread(breakThrough,sizeof(char),2*BTSIZE,in);
         fclose(in);
-    } else {
-        dprint("MSGBOX|tb not found\n");
-        exit(0);
     }
+    btLoaded=(n==2*BTSIZE);
+    return(btLoaded);
+}
+
+void loadBreakThrough()
+/* loads tables/bt.bin. A missing table is generated first, which takes a
+   while. That is done here, before the program starts any threads, since
+   the generator forks. If another process is generating it, its table is
+   waited for */
+{
+    init_btindex();
+    if (bt_read()==true) return;
+    if (bt_lock()==false) {
+        dprint("tables/bt.bin is being generated by another process, waiting for it\n");
+        fflush(stdout);
+#ifndef _WIN32
+        while (bt_lock()==false) sleep(5);
+#endif
+        if (bt_read()==true) {
+            bt_unlock();
+            return;
+        }
+    }
+    dprint("tables/bt.bin not found, generating it now. This takes a while\n");
+    fflush(stdout);
+    bt_build();
+    bt_unlock();
 }
@@ -0,0 +1,357 @@
+/*
+ * Copyright 1996 by Michel D. Grimminck
+ *
+ * All Rights Reserved
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright notice appear in all copies and that
+ * both that copyright notice and this permission notice appear in
+ * supporting documentation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/* engine input and output.
+   With COMM_THREADS a reader thread takes the commands from stdin, or in
+   windows mode from com/win.in, and sets stopflag when a command arrives
+   during a search; the search itself only tests stopflag. A writer thread
+   writes the windows interface files. Without threads commands are read
+   where they are needed and evalboard polls com/win.in */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include "var.h"
+#include "functions.h"
+#ifdef COMM_THREADS
+#include <pthread.h>
+#endif
+
+static int comNumber=0;
+
+void win_write(char *buffer)
+/* append buffer to the windows interface file, hand the file over at a newline */
+{
+    FILE *out;
+    char ren[256];
+
+    out=fopen("com/tmp.tmp","a");
+    if (out==NULL) {printf("warning: can not open interface file\n"); return;}
+    fprintf(out,"%s",buffer);
+    fclose(out);
+    if (strchr(buffer,10)!=NULL || strchr(buffer,13)!=NULL) {
+        sprintf(ren,"com/%i.txt",comNumber);
+        rename("com/tmp.tmp",ren);
+        comNumber++;
+    }
+}
+
+#ifdef COMM_THREADS
+/* ring of strings from producer to consumer threads. pending counts the
+   strings put but not yet finished with by the consumer */
+typedef struct {
+    char *line[COMMQUEUE];
+    int head,tail,pending;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} tpQueue;
+
+static tpQueue cmdq={{NULL},0,0,0,PTHREAD_MUTEX_INITIALIZER,PTHREAD_COND_INITIALIZER};
+static tpQueue outq={{NULL},0,0,0,PTHREAD_MUTEX_INITIALIZER,PTHREAD_COND_INITIALIZER};
+static int comm_running=false;
+static volatile int comm_busy=false;  /* a command is being executed */
+static FILE *comm_in=NULL;  /* read end of the command pipe in terminal mode */
+static int pipe_out=-1;
+static char *cmd_text=NULL;  /* text of the current windows command */
+static int (*comm_hook)(char *)=NULL;  /* sees every terminal line first */
+static struct _clock *comm_clock;  /* of the main thread, for stop */
+
+static void queue_put(tpQueue *q,char *line)
+{
+    pthread_mutex_lock(&q->mutex);
+    while ((q->tail+1)%COMMQUEUE==q->head) pthread_cond_wait(&q->cond,&q->mutex);
+    q->line[q->tail]=line;
+    q->tail=(q->tail+1)%COMMQUEUE;
+    q->pending++;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+static char *queue_get(tpQueue *q)
+{
+    char *line;
+
+    pthread_mutex_lock(&q->mutex);
+    while (q->head==q->tail) pthread_cond_wait(&q->cond,&q->mutex);
+    line=q->line[q->head];
+    q->head=(q->head+1)%COMMQUEUE;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+    return(line);
+}
+
+static void queue_done(tpQueue *q)
+{
+    pthread_mutex_lock(&q->mutex);
+    q->pending--;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+static char *read_line(FILE *f)
+/* a line of any length including its newline, NULL at end of file */
+{
+    int n=0,size=256;
+    char *line;
+
+    line=malloc(size);
+    while (fgets(line+n,size-n,f)!=NULL) {
+        n+=strlen(line+n);
+        if (line[n-1]=='\n') return(line);
+        size*=2;
+        line=realloc(line,size);
+    }
+    if (n>0) return(line);
+    free(line);
+    return(NULL);
+}
+
+static void write_all(int fd,char *text)
+{
+    int n,len;
+
+    len=strlen(text);
+    while (len>0) {
+        n=write(fd,text,len);
+        if (n<=0) return;
+        text+=n; len-=n;
+    }
+}
+
+static void *stdin_reader(void *arg)
+/* forward the terminal input to the command pipe; "stop" ends a search.
+   Lines the hook takes are not forwarded */
+{
+    char *line;
+    char word[16];
+
+    while ((line=read_line(stdin))!=NULL) {
+        if (comm_hook!=NULL && comm_hook(line)==true) {
+            free(line);
+            continue;
+        }
+        if (comm_busy==true && sscanf(line,"%15s",word)==1 && strcmp(word,"stop")==0) {
+            clock_stop(comm_clock);
+        }
+        write_all(pipe_out,line);
+        if (line[strlen(line)-1]!='\n') write_all(pipe_out,"\n");
+        free(line);
+    }
+    close(pipe_out);
+    return(arg);
+}
+
+static void *win_reader(void *arg)
+/* queue the contents of every com/win.in as one command, any command
+   ends a running search */
+{
+    FILE *in;
+    char *text;
+    long n;
+
+    while (true) {
+        in=fopen("com/win.in","r");
+        if (in==NULL) {
+            usleep(10000);
+            continue;
+        }
+        fclose(in);
+        rename("com/win.in","com/win.in2");
+        in=fopen("com/win.in2","r");
+        if (in==NULL) continue;
+        fseek(in,0,SEEK_END);
+        n=ftell(in);
+        rewind(in);
+        text=malloc(n+1);
+        n=fread(text,1,n,in);
+        text[n]=0;
+        fclose(in);
+        unlink("com/win.in2");
+        if (comm_busy==true) clock_stop(comm_clock);
+        queue_put(&cmdq,text);
+    }
+    return(arg);
+}
+
+static void *win_writer(void *arg)
+/* write the queued windows interface output */
+{
+    char *buffer;
+
+    while (true) {
+        buffer=queue_get(&outq);
+        win_write(buffer);
+        free(buffer);
+        queue_done(&outq);
+    }
+    return(arg);
+}
+
+static void comm_flush(void)
+/* at exit: wait until the writer has written everything */
+{
+    pthread_mutex_lock(&outq.mutex);
+    while (outq.pending>0) pthread_cond_wait(&outq.cond,&outq.mutex);
+    pthread_mutex_unlock(&outq.mutex);
+}
+#endif
+
+void comm_init(void)
+/* start the reader and writer threads, after the -windows option is known */
+{
+#ifdef COMM_THREADS
+    pthread_t thread;
+    int fd[2];
+
+    comm_clock=search_clock();
+    if (windows==true) {
+        if (pthread_create(&thread,NULL,win_writer,NULL)!=0) return;
+        pthread_detach(thread);
+        atexit(comm_flush);
+        if (pthread_create(&thread,NULL,win_reader,NULL)!=0) return;
+        pthread_detach(thread);
+    } else {
+        if (pipe(fd)!=0) return;
+        comm_in=fdopen(fd[0],"r");
+        pipe_out=fd[1];
+        if (pthread_create(&thread,NULL,stdin_reader,NULL)!=0) {
+            fclose(comm_in); close(pipe_out);
+            comm_in=NULL;
+            return;
+        }
+        pthread_detach(thread);
+    }
+    comm_running=true;
+#endif
+}
+
+FILE *comm_getcommand(char *input)
+/* wait for the next command, put its first word in input and return the
+   file to read its arguments from. End of input reads as quit */
+{
+    FILE *in;
+
+#ifdef COMM_THREADS
+    if (comm_running==true) {
+        comm_busy=false;
+        if (windows==true) {
+            cmd_text=queue_get(&cmdq);
+            queue_done(&cmdq);
+            in=fmemopen(cmd_text,strlen(cmd_text),"r");
+        }
+        else in=comm_in;
+        if (in==NULL || fscanf(in,"%s",input)!=1) strcpy(input,"quit");
+        comm_busy=true;
+        return(in);
+    }
+#endif
+    if (windows==true) in=winGetFile();
+    else in=stdin;
+    if (fscanf(in,"%s",input)!=1) strcpy(input,"quit");
+    return(in);
+}
+
+char *comm_getline(char *buffer,int size)
+/* wait for the next terminal line, for the line based protocols.
+   NULL at the end of the input */
+{
+#ifdef COMM_THREADS
+    if (comm_running==true && windows==false) {
+        char *r;
+
+        comm_busy=false;
+        r=fgets(buffer,size,comm_in);
+        comm_busy=true;
+        return(r);
+    }
+#endif
+    return(fgets(buffer,size,stdin));
+}
+
+void comm_sethook(int (*hook)(char *))
+/* with COMM_THREADS the reader thread gives every terminal line to hook
+   before it is forwarded, lines for which hook returns true are dropped.
+   This is how a protocol acts on a running search. NULL removes the hook */
+{
+#ifdef COMM_THREADS
+    comm_hook=hook;
+#endif
+}
+
+void comm_donecommand(FILE *in)
+/* the command read from in has been executed */
+{
+#ifdef COMM_THREADS
+    if (comm_running==true) {
+        if (windows==true) {
+            if (in!=NULL) fclose(in);
+            free(cmd_text);
+            cmd_text=NULL;
+        }
+        return;
+    }
+#endif
+    if (windows==true && in!=NULL) {
+        fclose(in);
+        unlink("com/win.in2");
+    }
+}
+
+void comm_output(char *buffer)
+/* send buffer to the windows interface */
+{
+#ifdef COMM_THREADS
+    if (comm_running==true && windows==true) {
+        queue_put(&outq,strdup(buffer));
+        return;
+    }
+#endif
+    win_write(buffer);
+}
+
+int comm_vscanf(char *format,va_list arglist)
+/* read the answer to a question from the windows/terminal interface */
+{
+    FILE *in;
+    int n;
+
+#ifdef COMM_THREADS
+    if (comm_running==true) {
+        char *text;
+
+        if (windows==false) return(vfscanf(comm_in,format,arglist));
+        text=queue_get(&cmdq);
+        queue_done(&cmdq);
+        n=vsscanf(text,format,arglist);
+        free(text);
+        return(n);
+    }
+#endif
+    if (windows==false) return(vscanf(format,arglist));
+    while (true) {
+        in=fopen("com/win.in","r");
+        if (in==NULL) {
+            usleep(10000);
+            continue;
+        }
+        n=vfscanf(in,format,arglist);
+        fclose(in);
+        unlink("com/win.in");
+        return(n);
+    }
+}
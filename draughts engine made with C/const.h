@@ -9,6 +9,19 @@
 #define true 1
 #define false 0
 
+/* storage class of the search state in var.c: with USE_THREADS every
+   thread that searches is an engine instance of its own, see engine.c */
+#ifdef USE_THREADS
+#define LOCAL __thread
+#else
+#define LOCAL
+#endif
+
+/* input reader and interface writer threads, see comm.c */
+#if defined(USE_THREADS) && !defined(_WIN32)
+#define COMM_THREADS
+#endif
+
 /* kill method */
 #define KILLER 1
 #define HISTORY 2
@@ -19,10 +32,12 @@
 #define MAXREF 5
 #define NHASH 10000 /* 160000 40000 */
 #define MAXBOOK 50000 /* 25000  5000 */
-#define MAXEVAL 300000 /* 25000 10000 */
+#define EVALHASH 8 /* default eval cache size in Mb */
+#define MANHASH 32768 /* man-structure cache, power of 2 */
 #define MAXCOMMENT 256
 #define MOVEL 64
 #define MPV 25
+#define MAXMULTIPV 16 /* most lines of multipv analysis */
 #define MAXNM 128
 #define MAXEXTEND 5
 #define NPAT 1200
@@ -55,6 +70,33 @@
 #define WIN 200000
 #define DRAW 0
 #define INF 400000
+#define ASPWINDOW 150  /* first aspiration half width */
+#define ASPLIMIT 20000  /* no aspiration beyond this score */
+#define IIDDEPTH 800  /* internal iterative deepening without hash move from here */
+#define IIDREDUCE 300  /* depth reduction of the iterative deepening search */
+#define COMMQUEUE 256  /* queued commands and interface output lines */
+#define HUBLINE 8192  /* longest hub protocol line */
+#define DXPPORT 27531  /* default DXP port */
+#define DXPMSG 256  /* longest DXP message */
+#define ENGINESTACK (16*1024*1024)  /* stack of an engine thread, dragon_new */
+#define HASHLOCKS 1024  /* locks of a shared hash table, a power of 2 */
+#define SERVEWORKERS 64  /* most engines of the analysis server */
+#define SERVETIME 1.0  /* seconds for a job that gives no time or depth */
+#define SERVEID 64  /* longest job id */
+#define BATCHTHREADS 8  /* most threads of one evaluate_batch */
+#define BATCHMIN 2048  /* fewest positions per evaluate_batch thread */
+#define TCMOVES 30  /* moves to go assumed when a time control does not say */
+#define TIMERSTEP 5  /* ms between timer thread checks */
+#define TIMEHARD 2.0  /* hard stop at this times the allocated time */
+#define TIMEDROP 150  /* score drop between iterations that counts as unstable */
+#define TIMESTABLE 0.7  /* time factor for a best move that does not change */
+#define TIMEUNSTABLE 0.35  /* extra time factor per unit of instability */
+#define TIMEMAXFACTOR 1.4  /* most extra time for an unstable search */
+#define TIMEFACTOR 1.35  /* the next iteration may end at this times the allocated time */
+#define LMRDEPTH 32  /* late move reduction table size in ply */
+#define LMRMOVES 3  /* moves searched before reducing */
+#define LMRDIV 2.25  /* divider of the log(depth)*log(movenr) reduction */
+#define LMRHIST 64  /* PROBKILL history below which a move is reduced one more ply */
 #define NONE -1
 #define UNKNOWN (INF+22354)
 #define PN_INF 5000000
@@ -154,6 +196,10 @@
 #define BTYPE unsigned char
 #define INT64 long long
 #define DBINDEX INT64
+#define DB_MAXPIECES 9     /* largest endgame database */
+#define DB_MAXTYPE 7       /* most pieces of one type (white/black man/king) in a database */
+#define DB_GROUP 4         /* successors tryPos locates and prefetches at a time */
+#define DB_FITS(wm,wc,bm,bc) ((wm)+(wc)+(bm)+(bc)<=DB_MAXPIECES && (wm)<=DB_MAXTYPE && (wc)<=DB_MAXTYPE && (bm)<=DB_MAXTYPE && (bc)<=DB_MAXTYPE)
 
 #define MAPPEDMEMORY
 
@@ -160,6 +160,7 @@
 
 
 #include <stdio.h>
+#include <string.h>
 #include "const.h"
 #include "var.h"
 #include "functions.h"
@@ -167,6 +168,15 @@
 #ifdef USE_ZLIB
 #include "/usr/include/zlib.h"
 #endif
+#ifdef USE_THREADS
+#include <pthread.h>
+#endif
+#ifdef USE_SHM
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #define DB_INDEX_FILE "endgame2.ini"
 #define DB_UNKNOWN 3
@@ -176,10 +186,17 @@
 #define DB_VERIFY 200
 #define QMAX 700000000000LLU
 #define QNAME "tmpgen/q%i"
+#define SNAME "tmpgen/s%i"
+#define STREAMBUCKETS 256      // most sub-slices of a streamed pass
 
 #define WDL 0
 #define DTW 1
 
+#define DBLOADERS 2             // number of background loading threads
+#define DB_USAGE_FILE "files/dbusage.bin"
+#define DB_SHARED_DIR "/dev/shm/dragon"
+#define DB_SHARED_ALIGN (2048LL*1024LL)   // file sizes are rounded up to a huge page
+
 #define MPLY 252   // maximal plydepth in database
 /* uncomment to create databases by forward searches only. This is very slow
    and for testing only.
@@ -216,6 +233,16 @@ INT64 qsize[1024],qmax[2];
 /* file pointer to queues */
 FILE *qfile[1024];  
 
+/* A slice of more than db_streamsize bytes (0: the mem64 RAM) is too large
+   to be written at random. The queue passes over it file the positions to
+   visit in sub-slices, index ranges of a quarter of that size, and then
+   visit them sub-slice by sub-slice, so that every page is paged in once
+   per pass */
+DBINDEX db_streamsize=0;
+static FILE *sfile[STREAMBUCKETS];
+static int nstream,scur;
+static DBINDEX sspan;
+
 // total amount of allocated memory in the memory handler
 DBINDEX allocatedMemory;   
 
@@ -238,6 +265,38 @@ int mode=WDL;
    the board is reversed.
 */
 
+/* Databases marked PRE are loaded in the background, in priority order. Until a
+   slice is loaded its mem64db[] entry is LOADING and probes return UNKNOWN.
+ */
+#define LOADING -2
+typedef struct {
+    int wman,wcrown,bman,bcrown,ws,bs;
+    INT64 priority;
+} tpPreload;
+
+tpPreload preload[4096];
+int preloadCount=0;         // number of slices in the queue
+int preloadNext=0;          // next slice to be loaded
+int preloadRunning=0;       // number of active loader threads
+
+// number of probes per material balance, accumulated over all games
+int db_history[4096+16];
+
+
+#ifdef USE_THREADS
+pthread_mutex_t preload_mutex=PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t preload_cond=PTHREAD_COND_INITIALIZER;       // a loader finished a slice
+pthread_mutex_t demand_mutex=PTHREAD_MUTEX_INITIALIZER;     // serializes loading on demand
+#endif
+
+/* With db_shared set, PRE slices are attached read-only from decompressed files in
+   db_shared_dir (published once per host by 'dragon -dbpublish'), so that all
+   engine processes share one physical copy. The directory may be a tmpfs such as
+   /dev/shm or a hugetlbfs mount. Slices that are not published are loaded privately.
+ */
+int db_shared=false;
+char db_shared_dir[256]=DB_SHARED_DIR;
+
 #define DEFMAX 200000
 int defMem64[DEFMAX];
 DBINDEX defPOS[DEFMAX];
@@ -381,13 +440,82 @@ void close_queue(int q)
 }
 
 
+static int stream_slice(DBINDEX size)
+// returns true if a slice of size positions is generated in sub-slices
+{
+    DBINDEX bytes=size;
+
+    if (mode==WDL) bytes=size/4;
+    return(bytes>(db_streamsize>0 ? db_streamsize : mem64_RAM()));
+}
+
+static void stream_open(DBINDEX size)
+// opens the sub-slice files for a slice of size positions
+{
+    char sname[100];
+    int i;
+
+    sspan=(db_streamsize>0 ? db_streamsize : mem64_RAM())/4;
+    if (mode==WDL) sspan*=4;
+    if (sspan<1) sspan=1;
+    if ((size+sspan-1)/sspan>STREAMBUCKETS) sspan=(size+STREAMBUCKETS-1)/STREAMBUCKETS;
+    nstream=(int) ((size+sspan-1)/sspan);
+    for(i=0;i<nstream;i++) {
+        sprintf(sname,SNAME,i);
+        sfile[i]=fopen(sname,"w+b");
+        if (sfile[i]==NULL) {printf("fatal: can not open sub-slice %s\n",sname); abort();}
+    }
+    scur=-1;
+}
+
+static void stream_add(DBINDEX index)
+// files the current board, which has the given index, in its sub-slice
+{
+    unsigned char c[25];
+    FILE *f;
+
+    f=sfile[index/sspan];
+    compress_board(c,board);
+    fwrite(&index,sizeof(DBINDEX),1,f);
+    fwrite(c,25,1,f);
+}
+
+static int stream_next(DBINDEX *index)
+// sets up the next filed board, sub-slice by sub-slice. Returns false when
+// all are done, the files are then removed
+{
+    unsigned char c[25];
+    char sname[100];
+
+    if (scur<0) {
+        scur=0;
+        if (nstream>0) rewind(sfile[0]);
+    }
+    while (scur<nstream) {
+        if (fread(index,sizeof(DBINDEX),1,sfile[scur])==1 && fread(c,25,1,sfile[scur])==1) {
+            decompress_board(board,c);
+            return(true);
+        }
+        fclose(sfile[scur]);
+        sprintf(sname,SNAME,scur);
+        unlink(sname);
+        scur++;
+        if (scur<nstream) {
+            rewind(sfile[scur]);
+            printf("sub-slice %i/%i          \r",scur+1,nstream);
+            fflush(stdout);
+        }
+    }
+    return(false);
+}
+
 char *database_short_name(int wman,int wcrown,int bman,int bcrown)
 {
 // returns the core filename of a database (without directory or extension), without
 // slices and wdl.
 // example filename: XXOvOOOO
 
-    static char name[40];
+    static LOCAL char name[40];
     int a=0,i;
 
     for(i=0;i<wcrown;i++) name[a++]='X';
@@ -404,7 +532,7 @@ char *database_nameExt(int wman,int wcrown,int bman,int bcrown,int ws,int bs,int
 // returns the core filename of a database (without directory or extension)
 // example filename: wld7-XXOvOOOO-45
 {
-    static char name[40];
+    static LOCAL char name[40];
     int a=0,i;
 
 	if (metric==WDL) {
@@ -460,7 +588,7 @@ char *verify_name(int wman,int wcrown,int bman,int bcrown,int ws,int bs)
 // returns the full filename of a verified indication, including extension
 // example filename: verify-wld7-XXOvOOOO-45.txt
 {
-    static char name[40];
+    static LOCAL char name[40];
     sprintf(name,"verify/%s.txt",database_name(wman,wcrown,bman,bcrown,ws,bs));
     return(name);
 }
@@ -499,17 +627,17 @@ void database_count(char *id,int *wman,int *wcrown,int *bman,int *bcrown)
     printf("s:%i %i\n",n,*wman);
 }
 
-int load_database(int wman,int wcrown,int bman,int bcrown,int ws,int bs)
-// loads a database into memory
+static int load_slice(int wman,int wcrown,int bman,int bcrown,int ws,int bs,int quiet)
+// loads a database slice into memory. The slice becomes visible to the probes
+// (mem64db[] is set) only after it is completely loaded.
 // returns true if succesfull
 {
     char db_file[100],*id;
-    DBINDEX i;
     int nr;
+    int handle;
     DBINDEX size;
     FILE *db;
     int use_compression=false;
-    char *p;
 
     id=database_name(wman,wcrown,bman,bcrown,ws,bs);
 #ifdef USE_ZLIB
@@ -519,7 +647,6 @@ int load_database(int wman,int wcrown,int bman,int bcrown,int ws,int bs)
 #endif
     size=db_count(wman,wcrown,bman,bcrown,ws,bs);
     nr=database_nr(white,wman,wcrown,bman,bcrown,ws,bs);
-    if (mem64db[nr] !=-1) return (true);  //already loaded
 
     pos_count[nr]=size;
     bytesize[nr]=(size+3);
@@ -533,29 +660,31 @@ int load_database(int wman,int wcrown,int bman,int bcrown,int ws,int bs)
         return(false);
     }
         
-    mem64db[nr]=mem64_allocate(bytesize[nr]);
-    if (mem64db[nr]<0) {
+    mem64_lock();
+    handle=mem64_allocate(bytesize[nr]);
+    if (handle<0) {
         printf("fatal: no memory for database (%i Mb)\n",bytesize[nr]/1024/1024);
         exit(1);
     }
     allocatedMemory+=sizeof(unsigned char)*bytesize[nr];
+    mem64_unlock();
 
     strcat(id,"             ");
     id[16]=0;  // fix length: 123v5678-90.
     
-    printf("loading %s         \r",id);
-    fflush(stdout);
-    /* make sure that the memory is mapped in ram to prevent excessive swapping */
-    
-    for(i=0;i<bytesize[nr];i+=256) {
-        p=mem64_pointer(mem64db[nr],i,true);
-        *p=0;
+    if (quiet==false) {
+        printf("loading %s         \r",id);
+        fflush(stdout);
     }
+    /* make sure that the memory is mapped in ram to prevent excessive swapping */
+    mem64_touch(handle,bytesize[nr]);
     
     if (use_compression==false) {
-        mem64_load(mem64db[nr],db_file);
+        mem64_load(handle,db_file);
     }
+    mem64db[nr]=handle;
 
+    if (quiet==true) return(true);
     if (windows==true) {
         winprint("\n");
         winprint("PROGRESS|*|*|*|*|loading %s\n",id);
@@ -567,6 +696,303 @@ int load_database(int wman,int wcrown,int bman,int bcrown,int ws,int bs)
     return(true);
 }
 
+int load_database(int wman,int wcrown,int bman,int bcrown,int ws,int bs)
+// loads a database into memory. A slice queued for background loading is
+// taken out of the queue, or waited for if a loader already has it.
+// returns true if succesfull
+{
+    int nr,k,n;
+    tpPreload pl;
+
+    nr=database_nr(white,wman,wcrown,bman,bcrown,ws,bs);
+    if (mem64db[nr]==LOADING) {
+#ifdef USE_THREADS
+        pthread_mutex_lock(&preload_mutex);
+#endif
+        for(k=preloadNext;k<preloadCount;k++) {
+            if (database_nr(white,preload[k].wman,preload[k].wcrown,preload[k].bman,preload[k].bcrown,preload[k].ws,preload[k].bs)==nr) break;
+        }
+        if (k<preloadCount) {
+            pl=preload[k];
+            for(n=k;n>preloadNext;n--) preload[n]=preload[n-1];
+            preload[preloadNext++]=pl;
+        }
+#ifdef USE_THREADS
+        else while (mem64db[nr]==LOADING) pthread_cond_wait(&preload_cond,&preload_mutex);
+        pthread_mutex_unlock(&preload_mutex);
+#endif
+        if (k>=preloadCount) return(mem64db[nr]>=0);
+    }
+    else if (mem64db[nr]!=-1) return (true);  //already loaded
+    return(load_slice(wman,wcrown,bman,bcrown,ws,bs,false));
+}
+
+void load_db_history(void)
+/* reads the accumulated probe counts, used to order the background loading */
+{
+    int i;
+    FILE *in;
+
+    for(i=0;i<4096;i++) db_history[i]=0;
+    in=fopen(DB_USAGE_FILE,"rb");
+    if (in==NULL) return;
+    fclose(in);
+    if (bin_load(DB_USAGE_FILE,sizeof(int),db_history)!=4096) {
+        for(i=0;i<4096;i++) db_history[i]=0;
+    }
+}
+
+void fold_db_usage(void)
+/* adds the probes of this thread, counted in db_usage, to db_history and
+   clears db_usage. Called between iterations, so the probes themselves
+   only write counters of their own thread */
+{
+    int i;
+
+    for(i=0;i<4096;i++) if (db_usage[i]!=0) {
+#ifdef USE_THREADS
+        __atomic_fetch_add(&db_history[i],db_usage[i],__ATOMIC_RELAXED);
+#else
+        db_history[i]+=db_usage[i];
+#endif
+        db_usage[i]=0;
+    }
+}
+
+void save_db_history(void)
+{
+    fold_db_usage();
+    bin_save(DB_USAGE_FILE,4096,sizeof(int),db_history);
+}
+
+static void *preload_thread(void *arg)
+/* loads queued slices until the queue is empty */
+{
+    int k;
+    tpPreload *pl;
+
+    while (true) {
+#ifdef USE_THREADS
+        pthread_mutex_lock(&preload_mutex);
+#endif
+        k=preloadNext;
+        if (k<preloadCount) preloadNext++;
+#ifdef USE_THREADS
+        pthread_mutex_unlock(&preload_mutex);
+#endif
+        if (k>=preloadCount) break;
+        pl=&preload[k];
+        load_slice(pl->wman,pl->wcrown,pl->bman,pl->bcrown,pl->ws,pl->bs,true);
+#ifdef USE_THREADS
+        pthread_mutex_lock(&preload_mutex);
+        pthread_cond_broadcast(&preload_cond);
+        pthread_mutex_unlock(&preload_mutex);
+#endif
+    }
+#ifdef USE_THREADS
+    pthread_mutex_lock(&preload_mutex);
+    preloadRunning--;
+    if (preloadRunning==0) {
+        dprint("databases loaded (%i slices, total memory = %4u Mb)\n",preloadCount,(int) (allocatedMemory/1024/1024));
+    }
+    pthread_mutex_unlock(&preload_mutex);
+#endif
+    return(NULL);
+}
+
+static char *shared_name(int wman,int wcrown,int bman,int bcrown,int ws,int bs)
+{
+    static LOCAL char name[400];
+
+    sprintf(name,"%s/%s.raw",db_shared_dir,database_name(wman,wcrown,bman,bcrown,ws,bs));
+    return(name);
+}
+
+static DBINDEX shared_size(int wman,int wcrown,int bman,int bcrown,int ws,int bs)
+/* size in bytes of a database slice */
+{
+    DBINDEX size;
+
+    size=db_count(wman,wcrown,bman,bcrown,ws,bs);
+    if (mode==WDL) return((size+3)/4);
+    return(size+3);
+}
+
+static int attach_shared(int wman,int wcrown,int bman,int bcrown,int ws,int bs)
+/* maps a published slice read-only into mem64. returns true if succesfull */
+{
+#ifdef USE_SHM
+    int fd,nr,handle;
+    struct stat st;
+    DBINDEX size;
+    char *p;
+
+    nr=database_nr(white,wman,wcrown,bman,bcrown,ws,bs);
+    size=shared_size(wman,wcrown,bman,bcrown,ws,bs);
+    fd=open(shared_name(wman,wcrown,bman,bcrown,ws,bs),O_RDONLY);
+    if (fd<0) return(false);
+    if (fstat(fd,&st)!=0 || st.st_size<size) {
+        close(fd);
+        return(false);
+    }
+    p=mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+    close(fd);
+    if (p==MAP_FAILED) return(false);
+    handle=mem64_attach(p,size);
+    if (handle<0) {
+        munmap(p,st.st_size);
+        return(false);
+    }
+    pos_count[nr]=db_count(wman,wcrown,bman,bcrown,ws,bs);
+    bytesize[nr]=size;
+    mem64db[nr]=handle;
+    return(true);
+#else
+    return(false);
+#endif
+}
+
+static int publish_slice(int wman,int wcrown,int bman,int bcrown,int ws,int bs)
+/* decompresses a slice into db_shared_dir. The file is written under a temporary
+   name and renamed when complete, so attaching engines never see a partial slice.
+   returns true if the slice is published */
+{
+#ifdef USE_SHM
+    char db_file[100],tmp_file[410],*name;
+    int fd;
+    DBINDEX size,fsize;
+    char *p;
+    struct stat st;
+
+    name=shared_name(wman,wcrown,bman,bcrown,ws,bs);
+    size=shared_size(wman,wcrown,bman,bcrown,ws,bs);
+    if (stat(name,&st)==0 && st.st_size>=size) return(true);  // already published
+    if (!availableOnDisk(wman,wcrown,bman,bcrown,ws,bs)) return(false);
+#ifdef USE_ZLIB
+    sprintf(db_file,"databases/%s.raw.gz",database_name(wman,wcrown,bman,bcrown,ws,bs));
+#else
+    sprintf(db_file,"databases/%s.raw",database_name(wman,wcrown,bman,bcrown,ws,bs));
+#endif
+    sprintf(tmp_file,"%s.tmp",name);
+    fsize=(size+DB_SHARED_ALIGN-1)/DB_SHARED_ALIGN*DB_SHARED_ALIGN;
+    fd=open(tmp_file,O_RDWR|O_CREAT|O_TRUNC,0644);
+    if (fd<0) {
+        printf("cannot create %s\n",tmp_file);
+        return(false);
+    }
+    if (ftruncate(fd,fsize)!=0) {
+        close(fd);
+        unlink(tmp_file);
+        return(false);
+    }
+    p=mmap(NULL,fsize,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    close(fd);
+    if (p==MAP_FAILED) {
+        unlink(tmp_file);
+        return(false);
+    }
+    if (mem64_loadRaw(p,size,db_file)==0) {
+        printf("load failure on %s\n",db_file);
+        munmap(p,fsize);
+        unlink(tmp_file);
+        return(false);
+    }
+    munmap(p,fsize);
+    if (rename(tmp_file,name)!=0) {
+        unlink(tmp_file);
+        return(false);
+    }
+    dprint("published %s      (Size = %4u Mb)\n",name,(int) (size/1024/1024));
+    return(true);
+#else
+    return(false);
+#endif
+}
+
+void publish_databases(void)
+/* decompresses all PRE databases of 'DB_INDEX_FILE' into db_shared_dir, for
+   engines started with -dbshared */
+{
+    FILE *in;
+    char db[10];
+    char state[10];
+    int wm,wk,bm,bk,ws,bs;
+    int n=0;
+
+#ifdef USE_SHM
+    mkdir(db_shared_dir,0755);
+#else
+    dprint("shared databases are not supported in this build\n");
+    return;
+#endif
+    in=my_fopen(DB_INDEX_FILE,"r");
+    if (in==NULL) {
+        printf("error: database index file not found\n");
+        return;
+    }
+    while (!feof(in)) {
+        if (fscanf(in,"%s %s\n",db,state)!=2) break;
+        if (strcmp(state,"PRE")!=0) continue;
+        wm=db[0]-'0'; wk=db[1]-'0'; bm=db[2]-'0'; bk=db[3]-'0';
+        for (ws=0;ws<countSliceWhite(wm,wk,bm,bk);ws++) {
+            for (bs=0;bs<countSliceBlack(wm,wk,bm,bk);bs++) {
+                if (publish_slice(wm,wk,bm,bk,ws,bs)==true) n++;
+            }
+        }
+    }
+    fclose(in);
+    dprint("%i database slices published in %s\n",n,db_shared_dir);
+}
+
+static void preload_add(int wman,int wcrown,int bman,int bcrown)
+/* queues all slices of a database for background loading. Small databases
+   come first; of equal size, the most probed in earlier games come first. */
+{
+    int ws,bs,nr,k;
+    tpPreload pl;
+
+    pl.wman=wman; pl.wcrown=wcrown; pl.bman=bman; pl.bcrown=bcrown;
+    for (ws=0;ws<countSliceWhite(wman,wcrown,bman,bcrown);ws++) {
+        for (bs=0;bs<countSliceBlack(wman,wcrown,bman,bcrown);bs++) {
+            nr=database_nr(white,wman,wcrown,bman,bcrown,ws,bs);
+            if (mem64db[nr]!=-1 || preloadCount>=4096) continue;
+            if (db_shared==true && attach_shared(wman,wcrown,bman,bcrown,ws,bs)==true) continue;
+            mem64db[nr]=LOADING;
+            pl.ws=ws; pl.bs=bs;
+            pl.priority=db_count(wman,wcrown,bman,bcrown,ws,bs)/(1+db_history[wman+8*wcrown+64*bman+512*bcrown]);
+#ifdef USE_THREADS
+            pthread_mutex_lock(&preload_mutex);
+#endif
+            for(k=preloadCount;k>preloadNext && preload[k-1].priority>pl.priority;k--) preload[k]=preload[k-1];
+            preload[k]=pl;
+            preloadCount++;
+#ifdef USE_THREADS
+            pthread_mutex_unlock(&preload_mutex);
+#endif
+        }
+    }
+}
+
+static void preload_start(void)
+/* starts the loader threads. Without thread support, the queue is loaded
+   before returning. */
+{
+#ifdef USE_THREADS
+    pthread_t thread;
+    int i;
+
+    pthread_mutex_lock(&preload_mutex);
+    for (i=preloadRunning;i<DBLOADERS && preloadNext<preloadCount;i++) {
+        if (pthread_create(&thread,NULL,preload_thread,NULL)!=0) break;
+        pthread_detach(thread);
+        preloadRunning++;
+    }
+    pthread_mutex_unlock(&preload_mutex);
+#else
+    preload_thread(NULL);
+#endif
+}
+
 void load_databaseFull(int wman,int wcrown,int bman,int bcrown)
 // loads all slices of the given database
 {
@@ -629,6 +1055,7 @@ void read_all_databases(int maxpieces)
     for (i=0;i<4096*81;i++) {
         loadDatabaseOnDemand[i]=false;
     }
+    load_db_history();
     
     /* read all selected databases */
     /*
@@ -661,7 +1088,7 @@ void read_all_databases(int maxpieces)
         bk=db[3]-'0';
      
         if (strcmp(state,"PRE")==0) {
-            load_databaseFull(wm,wk,bm,bk);
+            preload_add(wm,wk,bm,bk);
         }
         if (strcmp(state,"DEM")==0) {
             for (ws=0;ws<countSliceWhite(wm,wk,bm,bk);ws++) {
@@ -675,6 +1102,7 @@ void read_all_databases(int maxpieces)
         }
     }
     fclose(in);
+    preload_start();
     winprint("\n");
     //winprint("PROGRESS|*|*|*|*|\n",id);
 }
@@ -689,8 +1117,8 @@ int database_nr(int color,int wman,int wcrown,int bman,int bcrown,int ws,int bs)
     return(nr);
 }
 
-int findWS(int wman,int wcrown,int bman,int bcrown)
-/* returns the white slice number of the current position
+int findWS_board(BTYPE *b,int wman,int wcrown,int bman,int bcrown)
+/* returns the white slice number of board 'b'
 */
 {
 	int wm=white|man;
@@ -698,19 +1126,19 @@ int findWS(int wman,int wcrown,int bman,int bcrown)
 	if (wman==0) return(0);
 	if (wman+wcrown+bman+bcrown<=5) return(0);
 	
-	if (board[F6]==wm || board[F7]==wm || board[F8]==wm || board[F9]==wm || board[F10]==wm) return(8);
-	if (board[F11]==wm || board[F12]==wm || board[F13]==wm || board[F14]==wm || board[F15]==wm) return(7);
-	if (board[F16]==wm || board[F17]==wm || board[F18]==wm || board[F19]==wm || board[F20]==wm) return(6);
-	if (board[F21]==wm || board[F22]==wm || board[F23]==wm || board[F24]==wm || board[F25]==wm) return(5);
-	if (board[F26]==wm || board[F27]==wm || board[F28]==wm || board[F29]==wm || board[F30]==wm) return(4);
-	if (board[F31]==wm || board[F32]==wm || board[F33]==wm || board[F34]==wm || board[F35]==wm) return(3);
-	if (board[F36]==wm || board[F37]==wm || board[F38]==wm || board[F39]==wm || board[F40]==wm) return(2);
-	if (board[F41]==wm || board[F42]==wm || board[F43]==wm || board[F44]==wm || board[F45]==wm) return(1);
-	if (board[F46]==wm || board[F47]==wm || board[F48]==wm || board[F49]==wm || board[F50]==wm) return(0);
+	if (b[F6]==wm || b[F7]==wm || b[F8]==wm || b[F9]==wm || b[F10]==wm) return(8);
+	if (b[F11]==wm || b[F12]==wm || b[F13]==wm || b[F14]==wm || b[F15]==wm) return(7);
+	if (b[F16]==wm || b[F17]==wm || b[F18]==wm || b[F19]==wm || b[F20]==wm) return(6);
+	if (b[F21]==wm || b[F22]==wm || b[F23]==wm || b[F24]==wm || b[F25]==wm) return(5);
+	if (b[F26]==wm || b[F27]==wm || b[F28]==wm || b[F29]==wm || b[F30]==wm) return(4);
+	if (b[F31]==wm || b[F32]==wm || b[F33]==wm || b[F34]==wm || b[F35]==wm) return(3);
+	if (b[F36]==wm || b[F37]==wm || b[F38]==wm || b[F39]==wm || b[F40]==wm) return(2);
+	if (b[F41]==wm || b[F42]==wm || b[F43]==wm || b[F44]==wm || b[F45]==wm) return(1);
+	if (b[F46]==wm || b[F47]==wm || b[F48]==wm || b[F49]==wm || b[F50]==wm) return(0);
 }
 
-int findBS(int wman,int wcrown,int bman,int bcrown)
-/* returns the black slice number of the current position
+int findBS_board(BTYPE *b,int wman,int wcrown,int bman,int bcrown)
+/* returns the black slice number of board 'b'
 */
 {
 	int bm=black|man;
@@ -718,15 +1146,29 @@ int findBS(int wman,int wcrown,int bman,int bcrown)
 	if (bman==0) return(0);
 	
 	if (wman+wcrown+bman+bcrown<=5) return(0);
-	if (board[F41]==bm || board[F42]==bm || board[F43]==bm || board[F44]==bm || board[F45]==bm) return(8);
-	if (board[F36]==bm || board[F37]==bm || board[F38]==bm || board[F39]==bm || board[F40]==bm) return(7);
-	if (board[F31]==bm || board[F32]==bm || board[F33]==bm || board[F34]==bm || board[F35]==bm) return(6);
-	if (board[F26]==bm || board[F27]==bm || board[F28]==bm || board[F29]==bm || board[F30]==bm) return(5);
-	if (board[F21]==bm || board[F22]==bm || board[F23]==bm || board[F24]==bm || board[F25]==bm) return(4);
-	if (board[F16]==bm || board[F17]==bm || board[F18]==bm || board[F19]==bm || board[F20]==bm) return(3);
-	if (board[F11]==bm || board[F12]==bm || board[F13]==bm || board[F14]==bm || board[F15]==bm) return(2);
-	if (board[F6]==bm || board[F7]==bm || board[F8]==bm || board[F9]==bm || board[F10]==bm) return(1);
-	if (board[F1]==bm || board[F2]==bm || board[F3]==bm || board[F4]==bm || board[F5]==bm) return(0);
+	if (b[F41]==bm || b[F42]==bm || b[F43]==bm || b[F44]==bm || b[F45]==bm) return(8);
+	if (b[F36]==bm || b[F37]==bm || b[F38]==bm || b[F39]==bm || b[F40]==bm) return(7);
+	if (b[F31]==bm || b[F32]==bm || b[F33]==bm || b[F34]==bm || b[F35]==bm) return(6);
+	if (b[F26]==bm || b[F27]==bm || b[F28]==bm || b[F29]==bm || b[F30]==bm) return(5);
+	if (b[F21]==bm || b[F22]==bm || b[F23]==bm || b[F24]==bm || b[F25]==bm) return(4);
+	if (b[F16]==bm || b[F17]==bm || b[F18]==bm || b[F19]==bm || b[F20]==bm) return(3);
+	if (b[F11]==bm || b[F12]==bm || b[F13]==bm || b[F14]==bm || b[F15]==bm) return(2);
+	if (b[F6]==bm || b[F7]==bm || b[F8]==bm || b[F9]==bm || b[F10]==bm) return(1);
+	if (b[F1]==bm || b[F2]==bm || b[F3]==bm || b[F4]==bm || b[F5]==bm) return(0);
+}
+
+int findWS(int wman,int wcrown,int bman,int bcrown)
+/* returns the white slice number of the current position
+*/
+{
+    return(findWS_board(board,wman,wcrown,bman,bcrown));
+}
+
+int findBS(int wman,int wcrown,int bman,int bcrown)
+/* returns the black slice number of the current position
+*/
+{
+    return(findBS_board(board,wman,wcrown,bman,bcrown));
 }
 
 int database_retreive_value(int color,int wman,int wcrown,int bman,int bcrown,int ws,int bs)
@@ -741,7 +1183,6 @@ int database_retreive_value(int color,int wman,int wcrown,int bman,int bcrown,in
     DBINDEX index,dindex;
     int score;
     unsigned char *db;
-    static int counter=0;
     int w;
     int handle;
     
@@ -773,42 +1214,20 @@ int database_retreive_value(int color,int wman,int wcrown,int bman,int bcrown,in
 	}
 }
 
-int database_valueDTW(int color,int wman,int wcrown,int bman,int bcrown)
-/* retreives the value of a DTW database entry from disk. The the piece count
-   and slice numbers need to be specified for performance reasons.
-      
-   Returns a value from the perspective of 'color':
-
-    0  lose in 0
-    1  win in 1 ply
-    2  lose in 2 ply
-    3  win in 3
-    ..
-    etc
-    254 definite draw
-    UNKNOWN unknown
-
-   */
+static int database_locateDTW(int color,int wman,int wcrown,int bman,int bcrown,char *db_filename,DBINDEX *index)
+/* finds the uncompressed DTW file and the index of the current board position,
+   decompressing the database first if needed. Returns false if the database is
+   not available. */
 {
-    DBINDEX index,dindex;
-    int score;
-    unsigned char *db;
-    static int counter=0;
-    int w;
-    int handle;
-    char db_filename[100],*id;
+    char *id;
     int wm,wc,bm,bc,ws,bs;
     int nr;
     int ws1,bs1;
-    
-    if (use_db==false) return(UNKNOWN);
+    FILE *in;
 
     ws1=findWS(wman,wcrown,bman,bcrown);
     bs1=findBS(wman,wcrown,bman,bcrown);
 
-    FILE *in;
-    int result;
-    
     if (color==white) {
         wm=wman;
         wc=wcrown;
@@ -824,11 +1243,9 @@ int database_valueDTW(int color,int wman,int wcrown,int bman,int bcrown)
         bs=ws1;
         ws=bs1;
     }
-    /* no pieces: return LOSE */
-    if (wm==0 && wc==0) return(0);
     nr=database_nr(white,wm,wc,bm,bc,ws,bs);
     if (dtwStatus[nr]==1) {
-        return(UNKNOWN);
+        return(false);
     }
     if (dtwStatus[nr]==0) {   
         //status unknown: check if available uncompressed
@@ -843,7 +1260,7 @@ int database_valueDTW(int color,int wman,int wcrown,int bman,int bcrown)
             }
             else {
                 dtwStatus[nr]=1;
-                return(UNKNOWN);
+                return(false);
             }
         } else {
             // available
@@ -852,14 +1269,46 @@ int database_valueDTW(int color,int wman,int wcrown,int bman,int bcrown)
         }
     }
     // At this point we know the database is available uncompressed on disk   
-    index=database_linear_index(color);
-    if (index<0) {
-        printf("fatal: exception 1, %llu\n",dindex);
+    *index=database_linear_index(color);
+    if (*index<0) {
+        printf("fatal: exception 1, %llu\n",*index);
         exit(1);
     }
 
     id=database_nameExt(wm,wc,bm,bc,ws,bs,DTW);
     sprintf(db_filename,"dtw/%s.raw",id);
+    return(true);
+}
+
+int database_valueDTW(int color,int wman,int wcrown,int bman,int bcrown)
+/* retreives the value of a DTW database entry from disk. The the piece count
+   and slice numbers need to be specified for performance reasons.
+      
+   Returns a value from the perspective of 'color':
+
+    0  lose in 0
+    1  win in 1 ply
+    2  lose in 2 ply
+    3  win in 3
+    ..
+    etc
+    254 definite draw
+    UNKNOWN unknown
+
+   */
+{
+    DBINDEX index;
+    char db_filename[100];
+    FILE *in;
+    int result;
+    
+    if (use_db==false) return(UNKNOWN);
+
+    /* no pieces: return LOSE */
+    if (color==white && wman==0 && wcrown==0) return(0);
+    if (color==black && bman==0 && bcrown==0) return(0);
+    if (database_locateDTW(color,wman,wcrown,bman,bcrown,db_filename,&index)==false) return(UNKNOWN);
+
     result=UNKNOWN;
     in=fopen(db_filename,"rb");
     if (in==NULL) { printf("Unexpected error\n"); exit(1); }
@@ -867,11 +1316,67 @@ int database_valueDTW(int color,int wman,int wcrown,int bman,int bcrown)
     result=fgetc(in);
     fclose(in);    
     if (result<0) {
-        dprint("MSGBOX|Decompression error: %s\n",id);
+        dprint("MSGBOX|Decompression error: %s\n",db_filename);
     }
     return(result);
 }
 
+void database_valueDTW_batch(int color,int level,int nmoves,int *score)
+/* database_valueDTW() for all nmoves successors in movelist[level][], 'color' being
+   the player to move after the successor move. The files and indices are located
+   first; the probes are then read ordered by file and offset, so every file is
+   opened once and read front to back instead of once per successor.
+   Successors too large for the databases get UNKNOWN.
+*/
+{
+    char filename[MAXNM][100];
+    DBINDEX index[MAXNM];
+    int order[MAXNM];
+    int m,i,j,n=0,t;
+    int wman,wcrown,bman,bcrown;
+    FILE *in=NULL;
+    char *current=NULL;
+
+    for(m=0;m<nmoves;m++) {
+        score[m]=UNKNOWN;
+        if (use_db==false) continue;
+        do_move(movelist[level][m]);
+        wman=pieces[white|man]; wcrown=pieces[white|crown];
+        bman=pieces[black|man]; bcrown=pieces[black|crown];
+        if ((color==white && wman+wcrown==0) || (color==black && bman+bcrown==0)) {
+            score[m]=0;
+        } else if (DB_FITS(wman,wcrown,bman,bcrown)) {
+            if (database_locateDTW(color,wman,wcrown,bman,bcrown,filename[m],&index[m])==true) {
+                /* insertion sort on (file,index) */
+                for(i=n;i>0;i--) {
+                    t=strcmp(filename[order[i-1]],filename[m]);
+                    if (t<0 || (t==0 && index[order[i-1]]<=index[m])) break;
+                    order[i]=order[i-1];
+                }
+                order[i]=m;
+                n++;
+            }
+        }
+        undo_move(movelist[level][m]);
+    }
+
+    for(j=0;j<n;j++) {
+        m=order[j];
+        if (current==NULL || strcmp(current,filename[m])!=0) {
+            if (in!=NULL) fclose(in);
+            in=fopen(filename[m],"rb");
+            if (in==NULL) { printf("Unexpected error\n"); exit(1); }
+            current=filename[m];
+        }
+        fseek(in,index[m],SEEK_SET);
+        score[m]=fgetc(in);
+        if (score[m]<0) {
+            dprint("MSGBOX|Decompression error: %s\n",filename[m]);
+        }
+    }
+    if (in!=NULL) fclose(in);
+}
+
 int read_value(int handle,DBINDEX index)
 // Very fast read from the database for a know database handle and position index.
 {
@@ -905,6 +1410,47 @@ int read_value(int handle,DBINDEX index)
 	}
 }
 
+int database_index_batch(int color,int level,int first,int nmoves,int bs,int *handle,DBINDEX *index)
+/* computes the database handle and index of the successors first..nmoves-1 in
+   movelist[level][] and prefetches their entries, without reading any of them.
+   handle[] and index[] are indexed by move number. 'color' is the player to
+   move after the successor move. When bs>=0 it is used as black slice for every
+   successor, otherwise the slices are determined per successor.
+
+   handle[m] is set to -2 when 'color' has no pieces left (a loss), and to -1 when the
+   slice is not in memory. Doing all the index work first lets the memory latency of
+   the probes overlap, which pays off for slices much larger than the cpu cache.
+   Returns the number of successors that can be read with read_value().
+*/
+{
+    int m,nr,ws1,bs1,found=0;
+    int wman,wcrown,bman,bcrown;
+
+    for(m=first;m<nmoves;m++) {
+        do_move(movelist[level][m]);
+        wman=pieces[white|man]; wcrown=pieces[white|crown];
+        bman=pieces[black|man]; bcrown=pieces[black|crown];
+        handle[m]=-1;
+        index[m]=0;
+        if ((color==white && wman+wcrown==0) || (color==black && bman+bcrown==0)) {
+            handle[m]=-2;
+        } else if (DB_FITS(wman,wcrown,bman,bcrown)) {
+            ws1=findWS(wman,wcrown,bman,bcrown);
+            bs1=(bs>=0)?bs:findBS(wman,wcrown,bman,bcrown);
+            nr=database_nr(color,wman,wcrown,bman,bcrown,ws1,bs1);
+            if (mem64db[nr]>=0) {
+                handle[m]=mem64db[nr];
+                index[m]=database_linear_index(color);
+                if (mode==WDL) mem64_prefetch(handle[m],index[m]/4);
+                else mem64_prefetch(handle[m],index[m]);
+                found++;
+            }
+        }
+        undo_move(movelist[level][m]);
+    }
+    return(found);
+}
+
 void store_value(int handle,DBINDEX index,int score)
 // Very fast write-to database for a know database handle and position index.
 {
@@ -1227,6 +1773,8 @@ DBINDEX tryPos(int nr,DBINDEX index,int player,int iteration,int bs,int ws,int m
 {
     int m,cur,bestwin,count,bestlose,lose,ws1,bs1,m0,score;
     int nmoves,nmoves0;
+    int handle[MAXNM];
+    DBINDEX sindex[MAXNM];
     DBINDEX found=0;
     
     nmoves0=move_list(0,white);
@@ -1235,13 +1783,16 @@ DBINDEX tryPos(int nr,DBINDEX index,int player,int iteration,int bs,int ws,int m
     bestlose=-1;
     lose=0;
     
+    /* locate and prefetch the successors a group at a time: the loop ends
+       at the first one that does not lose, mostly the first of all */
     bs1=findBS(pieces[white|man],pieces[white|crown],pieces[black|man],pieces[black|crown]);
     for(m0=0;m0<nmoves0;m0++) {
-        do_move(movelist[0][m0]);
-        //set_pieces();
-
-        ws1=findWS(pieces[white|man],pieces[white|crown],pieces[black|man],pieces[black|crown]);
-        score=database_retreive_value(black,pieces[white|man],pieces[white|crown],pieces[black|man],pieces[black|crown],ws1,bs1);
+        if (m0%DB_GROUP==0) {
+            database_index_batch(black,0,m0,m0+DB_GROUP<nmoves0 ? m0+DB_GROUP : nmoves0,bs1,handle,sindex);
+        }
+        if (handle[m0]==-2) score=0;
+        else if (handle[m0]<0) score=255;
+        else score=read_value(handle[m0],sindex[m0]);
         
         if (score<MPLY) {
             if (score>minIteration) {
@@ -1252,7 +1803,6 @@ DBINDEX tryPos(int nr,DBINDEX index,int player,int iteration,int bs,int ws,int m
                 lose++;
             } 
         }
-        undo_move(movelist[0][m0]);
         if (lose !=(m0+1)) {
             break;
         }
@@ -1295,6 +1845,8 @@ DBINDEX iterateFromQueue(int nr,int nr2,int wman,int wcrown,int bman,int bcrown,
 
     int singleColorMode=false;
     int goForward=false;
+    int streamed;
+    DBINDEX size2;
     
     if (wcrown>1) singleColorMode=true;
     singleColorMode=false;
@@ -1316,6 +1868,9 @@ DBINDEX iterateFromQueue(int nr,int nr2,int wman,int wcrown,int bman,int bcrown,
     
     if (bytesize>0.45*mem64_RAM() && qsize[qIn]>0.0005*size) goForward=true;  
     if (qsize[qIn]>0.05*size) goForward=true;
+    /* a slice larger than RAM: the random access of the backward search
+       would page continuously, the forward pass walks it in order */
+    if (stream_slice(size)==true) goForward=true;
     
     if (goForward==true) {
         /* slow forward search, but good if you are low on memory */
@@ -1394,18 +1949,30 @@ DBINDEX iterateFromQueue(int nr,int nr2,int wman,int wcrown,int bman,int bcrown,
     if (qsize[q]>0) {
         init_queue_read(q);
         init_queue_add(512*player+iteration);
-                
+        size=db_count(wman,wcrown,bman,bcrown,ws,bs);
+        streamed=stream_slice(size);
+        if (streamed==true) {
+            /* visit the queue in sub-slice order */
+            stream_open(size);
+            for(i=0;i<qsize[q];i++) {
+                local=read_from_queue(q);
+                for(j=0;j<50;j++) board[map[j]]=local[map[j]];
+                stream_add(database_linear_index(white));
+            }
+        }
             
         for(i=0;i<qsize[q];i++) {
             if ((i&1023)==0) {
                 printf("backtracking %i/2:  %0.4f  n=%s (da: %llu Mb)         \r",iteration+player,(float)i/(qsize[q]+1),neatNumber(qsize[q]),mem64_diskActivity/1024/1024);
                 fflush(stdout);
                 }
-            local=read_from_queue(q);
-
-            for(j=0;j<50;j++) board[map[j]]=local[map[j]];
-            //display_board(); printf("2\n");
-            index=database_linear_index(white);
+            if (streamed==true) stream_next(&index);
+            else {
+                local=read_from_queue(q);
+                for(j=0;j<50;j++) board[map[j]]=local[map[j]];
+                //display_board(); printf("2\n");
+                index=database_linear_index(white);
+            }
             cur=read_value(mem64db[nr],index);
             if (cur>MPLY && cur!=254) {
                 set_pieces();
@@ -1441,6 +2008,7 @@ DBINDEX iterateFromQueue(int nr,int nr2,int wman,int wcrown,int bman,int bcrown,
                 }
             }
         }
+        if (streamed==true) stream_next(&index);  /* removes the sub-slices */
         close_queue(512*player+iteration);
         close_queue(q);
     }
@@ -1449,6 +2017,9 @@ DBINDEX iterateFromQueue(int nr,int nr2,int wman,int wcrown,int bman,int bcrown,
     init_queue_add(512*nplayer+iteration+1);
     init_board();
     qIn=512*player+iteration;
+    size2=db_count(bman,bcrown,wman,wcrown,bs,ws);
+    streamed=stream_slice(size2);
+    if (streamed==true) stream_open(size2);
     
     for(i=0;i<qsize[qIn];i++) {
         
@@ -1471,7 +2042,11 @@ DBINDEX iterateFromQueue(int nr,int nr2,int wman,int wcrown,int bman,int bcrown,
 
             if (findBS(pieces[white|man],pieces[white|crown],pieces[black|man],pieces[black|crown]) == ws && 
                 findWS(pieces[white|man],pieces[white|crown],pieces[black|man],pieces[black|crown]) == bs) {
-                cur=read_value(mem64db[nr2],index);
+                if (streamed==true) {
+                    stream_add(index);
+                    cur=254;
+                }
+                else cur=read_value(mem64db[nr2],index);
             } else {
                 cur=254;
             }
@@ -1483,6 +2058,15 @@ DBINDEX iterateFromQueue(int nr,int nr2,int wman,int wcrown,int bman,int bcrown,
             undo_move(movelist[1][m]);
         }
     }
+    /* the predecessors in sub-slice order */
+    if (streamed==true) while (stream_next(&index)==true) {
+        cur=read_value(mem64db[nr2],index);
+        if (cur>MPLY && cur!=254) {
+            store_value(mem64db[nr2],index,iteration+1);
+            checkMax(iteration+1);
+            add_to_queue(512*nplayer+iteration+1);
+        }
+    }
     
     close_queue(512*nplayer+iteration+1);
     close_queue(512*player+iteration);
@@ -1493,17 +2077,29 @@ DBINDEX iterateFromQueue(int nr,int nr2,int wman,int wcrown,int bman,int bcrown,
     if (qsize[q]>=0) {
         init_queue_read(q);
         init_queue_add(512*nplayer+iteration+1);
-        
+        streamed=stream_slice(size2);
+        if (streamed==true) {
+            /* visit the queue in sub-slice order */
+            stream_open(size2);
+            for(i=0;i<qsize[q];i++) {
+                local=read_from_queue(q);
+                for(j=0;j<50;j++) board[map[j]]=local[map[j]];
+                stream_add(database_linear_index(white));
+            }
+        }
         
         for(i=0;i<qsize[q];i++) {
             if ((i&1023)==0) {
                 printf("backtracking %i/4:  %0.4f  n=%s (da: %llu Mb)         \r",iteration+player,(float)i/(qsize[q]+1),neatNumber(qsize[q]),mem64_diskActivity/1024/1024);
                 fflush(stdout);
                 }
-            local=read_from_queue(q);
-            for(j=0;j<50;j++) board[map[j]]=local[map[j]];
-            //display_board(); printf("4\n");
-            index=database_linear_index(white);
+            if (streamed==true) stream_next(&index);
+            else {
+                local=read_from_queue(q);
+                for(j=0;j<50;j++) board[map[j]]=local[map[j]];
+                //display_board(); printf("4\n");
+                index=database_linear_index(white);
+            }
             cur=read_value(mem64db[nr2],index);
             if (cur>MPLY && cur!=254) {
                 store_value(mem64db[nr2],index,iteration+1);
@@ -1511,6 +2107,7 @@ DBINDEX iterateFromQueue(int nr,int nr2,int wman,int wcrown,int bman,int bcrown,
                 add_to_queue(512*nplayer+iteration+1);
             }
         }
+        if (streamed==true) stream_next(&index);  /* removes the sub-slices */
         close_queue(512*nplayer+iteration+1);
         close_queue(q);
     }
@@ -1831,6 +2428,10 @@ void create_database(int wman,int wcrown,int bman,int bcrown,int ws,int bs,int l
     int mirror;  /* mirror is set to 1 for symmetric databases, 2 otherwise */
 
     if (level<0) return;
+    if (wman+wcrown+bman+bcrown>DB_MAXPIECES || wman>DB_MAXTYPE || wcrown>DB_MAXTYPE || bman>DB_MAXTYPE || bcrown>DB_MAXTYPE) {
+        printf("database %i%i%i%i too large: at most %i pieces, %i of each type\n",wman,wcrown,bman,bcrown,DB_MAXPIECES,DB_MAXTYPE);
+        return;
+    }
         
     if (ws<0) ws=0;
     if (bs<0) bs=0;
@@ -2690,59 +3291,98 @@ int database_valueWDL(int color,int wman,int wcrown,int bman,int bcrown)
    wman,wcrown,bman,bcrown: the number of these pieces on the board.
    In general these are known, so it speeds up the access.
    
-   Call only for positions with 8 or less pieces
+   Call only for positions that pass DB_FITS()
 */
+{
+    return(database_probeWDL(board,color,wman,wcrown,bman,bcrown));
+}
+
+int probe_value(int handle,DBINDEX index)
+/* read_value() for the probe path: reentrant, and lock-free for resident pages */
+{
+    DBINDEX dindex;
+    int score;
+
+    if (mode==WDL) {
+        dindex=index/4;
+        score=(mem64_read(handle,dindex)>>(6-2*(index-4*dindex)))&3;
+        if (score==2) score=254;
+        if (score==3) score=255;
+        return(score);
+    }
+    return(mem64_read(handle,index));
+}
+
+static int probe_result(int score,int color,int wman,int wcrown,int bman,int bcrown)
+/* counts a probe with database value score and returns it as WIN, DRAW or
+   LOSE seen from white */
+{
+    ndat++;
+    if (color==white) db_usage[wman+8*wcrown+64*bman+512*bcrown]++;
+    else db_usage[bman+8*bcrown+64*wman+512*wcrown]++;
+    if (color==white) {
+        if (score==DB_DRAW) return(DRAW);
+        if (score==DB_WIN) return(WIN);
+        if (score==DB_LOSE) return(LOSE);
+    }
+    else {
+        if (score==DB_DRAW) return(DRAW);
+        if (score==DB_WIN) return(LOSE);
+        if (score==DB_LOSE) return(WIN);
+    }
+
+    return(score);
+}
+
+int database_probeWDL(BTYPE *b,int color,int wman,int wcrown,int bman,int bcrown)
+/* database_valueWDL() for board 'b'. Safe to call from several search threads:
+   probes of loaded slices run without locks, loading a slice on demand is
+   serialized. */
 {
     DBINDEX index;
     int score,nr;
     int ws,bs;
-    unsigned char *db;
+    int handle;
     
     if (use_db==false) return(UNKNOWN);
-    ws=findWS(wman,wcrown,bman,bcrown);
-    bs=findBS(wman,wcrown,bman,bcrown);
+    ws=findWS_board(b,wman,wcrown,bman,bcrown);
+    bs=findBS_board(b,wman,wcrown,bman,bcrown);
     nr=database_nr(color,wman,wcrown,bman,bcrown,ws,bs);
     
-    
-    if (mem64db[nr]<0) {
+    handle=mem64db[nr];
+    if (handle==LOADING) return(UNKNOWN);  // still being loaded in the background
+    if (handle<0) {
         // database not available in memory
-        if (loadDatabaseOnDemand[nr]==true) {
+        if (loadDatabaseOnDemand[nr]==false) return(UNKNOWN);  // not preloaded, and do not load on demand
+#ifdef USE_THREADS
+        pthread_mutex_lock(&demand_mutex);
+#endif
+        if (mem64db[nr]<0 && loadDatabaseOnDemand[nr]==true) {
             if (color==white && availableOnDisk(wman,wcrown,bman,bcrown,ws,bs)==true) {
                 load_database(wman,wcrown,bman,bcrown,ws,bs);
             } else if (color==black && availableOnDisk(bman,bcrown,wman,wcrown,bs,ws)==true) {
                 load_database(bman,bcrown,wman,wcrown,bs,ws);
             } else { // not available on disk, so don't try again
                 loadDatabaseOnDemand[nr]=false;
-                return(UNKNOWN);
             }
-        } else {  // not preloaded, and do not load on demand
-            return(UNKNOWN);
         }
+#ifdef USE_THREADS
+        pthread_mutex_unlock(&demand_mutex);
+#endif
+        handle=mem64db[nr];
+        if (handle<0) return(UNKNOWN);
     }
     
-    index=database_linear_index(color);
-    score=read_value(mem64db[nr],index);
-    ndat++; 
- 
-    if (color==white) {
-        db_usage[wman+8*wcrown+64*bman+512*bcrown]++;
-    } else {
-        db_usage[bman+8*bcrown+64*wman+512*wcrown]++;
-    }
- 
-    
-    if (color==white) {
-        if (score==DB_DRAW) return(DRAW);
-        if (score==DB_WIN) return(WIN);
-        if (score==DB_LOSE) return(LOSE);
-    }
-    else {
-        if (score==DB_DRAW) return(DRAW);
-        if (score==DB_WIN) return(LOSE);
-        if (score==DB_LOSE) return(WIN);
-    }
+    index=database_linear_index_board(b,color);
+    return(probe_result(probe_value(handle,index),color,wman,wcrown,bman,bcrown));
+}
 
-    return(score);
+int database_valueWDL_at(int color,int handle,DBINDEX index)
+/* database_valueWDL() of board[] at its slice handle and index, as found
+   by database_index_batch() */
+{
+    return(probe_result(probe_value(handle,index),color,pieces[white|man],pieces[white|crown],
+                        pieces[black|man],pieces[black|crown]));
 }
 
 extern DBINDEX mult(int,int);
@@ -2860,6 +3500,8 @@ verify {wm wc} {bm} {bc}                    Verify consistency of\n\
                                             given and sub-databases.\n\
 wdl                                         Generate win/draw/lose databases\n\
 dtw                                         Generate distance to win databases\n\
+stream {Mb}                                 Generate slices larger than this\n\
+                                            in sub-slices (0=RAM, default)\n\
 find {value} {wm wc} {bm} {bc} {ws} {bs}    find positions with\n\
                                             given value: 0=lose, 1=win in 1,\n\
                                             2=lose in 1,etc. 255=draw.\n\
@@ -2880,12 +3522,13 @@ htmlall {n1} {n2}                           Save database statistics as html\n\
 \n\
         Database limitations:\n\
         - No database may be deeper than %i moves\n\
-        - The largest database may contain only 8 pieces\n\
-        - There may be at most 5 pieces of each type (white/black man/king)\n\
+        - The largest database may contain only %i pieces\n\
+        - There may be at most %i pieces of each type (white/black man/king)\n\
+        - Slices that do not fit in RAM are generated in sub-slices\n\
         \n\
         The database-generator is released under the Gnu public License\n\
         Source can be found at: http://www.xs4all.nl/~mdgsoft/draughts\n\
-        \n",MPLY);
+        \n",MPLY,DB_MAXPIECES,DB_MAXTYPE);
             printf("Index size:%i bit\n\n",8*sizeof(DBINDEX));
     
         }
@@ -2971,6 +3614,11 @@ htmlall {n1} {n2}                           Save database statistics as html\n\
     			setMode(DTW);
     		}
         }
+        else if (strcmp(input,"stream")==0) {
+            int mb;
+            scanf("%i",&mb);
+            db_streamsize=1024LL*1024LL*mb;
+        }
         else if (strcmp(input,"htmlall")==0) {
             int in1,in2;
             scanf("%i%i",&in1,&in2);
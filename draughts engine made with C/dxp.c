@@ -0,0 +1,298 @@
+/*
+ * Copyright 1996 by Michel D. Grimminck
+ *
+ * All Rights Reserved
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright notice appear in all copies and that
+ * both that copyright notice and this permission notice appear in
+ * supporting documentation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/* DamExchange protocol (DXP) over TCP. Messages are text ended by a 0
+   byte, the first character is the type:
+     R  GAMEREQ  version(2) name(32) follower color(W/Z) minutes(3)
+                 moves(3) start(A=initial, B=color(1) and 50 fields ewzWZ)
+     A  GAMEACC  name(32) code(0=accepted)
+     M  MOVE     seconds(4) from(2) to(2) ncaptured(2) captured(2 each)
+     E  GAMEEND  reason(0=unknown 1=I lose 2=draw 3=I win) stop code(1)
+     B  BACKREQ  answered by K BACKACC code 1 (not supported)
+     C  CHAT
+   dxp_listen is the follower, it plays the games an initiator asks for;
+   dxp_connect is the initiator of one game from the current position.
+   "stop" on the terminal ends the running search, the move is sent */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "var.h"
+#include "functions.h"
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+
+static int dxp_send(int fd,char *msg)
+/* send msg with its terminating 0 */
+{
+    int n,len;
+
+    len=strlen(msg)+1;
+    while (len>0) {
+        n=send(fd,msg,len,0);
+        if (n<=0) return(false);
+        msg+=n; len-=n;
+    }
+    return(true);
+}
+
+static int dxp_recv(int fd,char *msg,int size)
+/* read the next message, false if the connection is closed */
+{
+    int n=0;
+    char c;
+
+    while (recv(fd,&c,1,0)==1) {
+        if (c==0) {
+            msg[n]=0;
+            return(true);
+        }
+        if (n<size-1) msg[n++]=c;
+    }
+    return(false);
+}
+
+static int dxp_num(char *s)
+/* the 2 digit number at s */
+{
+    char temp[3];
+
+    temp[0]=s[0]; temp[1]=s[1]; temp[2]=0;
+    return(atoi(temp));
+}
+
+static void dxp_board(char *s,int color)
+/* the board as the color to move and 50 DXP fields */
+{
+    int i;
+
+    get_board_string(s,color);
+    for(i=0;i<51;i++) {
+        if (s[i]=='b') s[i]='z';
+        else if (s[i]=='B') s[i]='Z';
+    }
+}
+
+static int dxp_setboard(char *s)
+/* inverse of dxp_board, returns the color to move or -1 */
+{
+    char temp[52];
+    int i;
+
+    for(i=0;i<51 && s[i]!=0;i++) {
+        if (s[i]=='z') temp[i]='b';
+        else if (s[i]=='Z') temp[i]='B';
+        else temp[i]=s[i];
+    }
+    temp[i]=0;
+    if (i<51) return(-1);
+    return(set_board_string(temp));
+}
+
+static int dxp_end(int fd,int reason)
+/* send GAMEEND and wait for the one that answers it. False if the
+   connection is closed or is to be closed */
+{
+    char msg[DXPMSG];
+
+    sprintf(msg,"E%c0",reason);
+    if (dxp_send(fd,msg)==false) return(false);
+    do {
+        if (dxp_recv(fd,msg,DXPMSG)==false) return(false);
+    } while (msg[0]!='E');
+    return(msg[2]!='1');
+}
+
+static int dxp_game(int fd,int mycolor,int minutes,int moves)
+/* play a game from the current board, false if the connection is gone */
+{
+    char msg[DXPMSG],bestmove[MOVEL],pondermove[MOVEL];
+    int sq[MOVEL],nsq,n,m,j,mymoves=0;
+    float at,used=0;
+    double t;
+
+    while (true) {
+        n=move_list(0,game_color);
+        if (game_color==mycolor) {
+            if (n==0) return(dxp_end(fd,'1'));
+            if (game_history_nr>=199) return(dxp_end(fd,'2'));
+            at=tc_alloc(60.0F*minutes-used,moves>0 ? moves-mymoves : 0,0);
+            t=wall_time();
+            stopflag=false;
+            think(mycolor,at,INF,bestmove,pondermove,NULL);
+            stopflag=false;
+            t=wall_time()-t;
+            used+=t;
+            mymoves++;
+            m=bestmove[0];
+            if (m==4) sprintf(msg,"M%04i%02i%02i00",(int) t,invmap[(int) bestmove[1]]+1,invmap[(int) bestmove[3]]+1);
+            else {
+                sprintf(msg,"M%04i%02i%02i%02i",(int) t,invmap[(int) bestmove[1]]+1,invmap[(int) bestmove[m-1]]+1,(m-3)/3);
+                for(j=3;j<m-2;j+=3) sprintf(msg+strlen(msg),"%02i",invmap[(int) bestmove[j]]+1);
+            }
+            if (dxp_send(fd,msg)==false) return(false);
+            xstore_history(bestmove,"");
+            do_move(bestmove);
+            continue;
+        }
+        if (dxp_recv(fd,msg,DXPMSG)==false) return(false);
+        switch (msg[0]) {
+        case 'M':
+            if (strlen(msg)<11) break;
+            sq[0]=dxp_num(msg+5);
+            sq[1]=dxp_num(msg+7);
+            j=dxp_num(msg+9);
+            for(nsq=2;nsq-2<j && nsq<MOVEL && strlen(msg)>=13+2*(nsq-2);nsq++) sq[nsq]=dxp_num(msg+11+2*(nsq-2));
+            m=find_move_squares(0,n,sq,nsq);
+            if (m<0) {
+                dprint("dxp: illegal move %s\n",msg);
+                return(dxp_end(fd,'0'));
+            }
+            xstore_history(movelist[0][m],"");
+            do_move(movelist[0][m]);
+            break;
+        case 'E':
+            /* answer with our view of the result */
+            j=msg[1];
+            if (j=='1') j='3';
+            else if (j=='3') j='1';
+            sprintf(msg+1,"%c%c",j,msg[2]==0 ? '0' : msg[2]);
+            if (dxp_send(fd,msg)==false) return(false);
+            return(msg[2]!='1');
+        case 'B':
+            if (dxp_send(fd,"K1")==false) return(false);
+            break;
+        case 'C':
+            dprint("dxp: %s\n",msg+1);
+            break;
+        }
+    }
+}
+
+void dxp_listen(int port)
+/* DXP follower: accept an initiator on port of interface dxp_address
+   (the loopback one unless set by "dxpaddr") and play the games it asks
+   for until it ends the connection */
+{
+    struct sockaddr_in addr;
+    char msg[DXPMSG],name[40];
+    int lfd,fd,on=1,mycolor,minutes,moves;
+
+    lfd=socket(AF_INET,SOCK_STREAM,0);
+    if (lfd<0) {dprint("dxp: no socket\n"); return;}
+    setsockopt(lfd,SOL_SOCKET,SO_REUSEADDR,&on,sizeof(on));
+    memset(&addr,0,sizeof(addr));
+    addr.sin_family=AF_INET;
+    if (strcmp(dxp_address,"any")==0) addr.sin_addr.s_addr=htonl(INADDR_ANY);
+    else if (inet_pton(AF_INET,dxp_address,&addr.sin_addr)!=1) {
+        dprint("dxp: bad address %s\n",dxp_address);
+        close(lfd);
+        return;
+    }
+    addr.sin_port=htons(port);
+    if (bind(lfd,(struct sockaddr *) &addr,sizeof(addr))!=0 || listen(lfd,1)!=0) {
+        dprint("dxp: can not listen on port %i\n",port);
+        close(lfd);
+        return;
+    }
+    dprint("dxp: waiting on %s port %i\n",dxp_address,port);
+    fflush(stdout);
+    fd=accept(lfd,NULL,NULL);
+    close(lfd);
+    if (fd<0) return;
+    while (dxp_recv(fd,msg,DXPMSG)==true) {
+        if (msg[0]=='C') dprint("dxp: %s\n",msg+1);
+        if (msg[0]!='R') continue;
+        if (strlen(msg)<43) continue;
+        mycolor=(msg[35]=='Z') ? black : white;
+        sscanf(msg+36,"%3d",&minutes);
+        sscanf(msg+39,"%3d",&moves);
+        if (msg[42]=='B') {
+            if (dxp_setboard(msg+43)<0) {
+                if (dxp_send(fd,"A                                3")==false) break;
+                continue;
+            }
+            game_color=(msg[43]=='Z') ? black : white;
+            init_history();
+            game_history_firstcolor=game_color;
+        }
+        else init_board();
+        dprint("dxp: game against %.32s, %i minutes for %i moves\n",msg+3,minutes,moves);
+        sprintf(name,"Dragon %s",VERSION);
+        sprintf(msg,"A%-32.32s0",name);
+        if (dxp_send(fd,msg)==false) break;
+        if (dxp_game(fd,mycolor,minutes,moves)==false) break;
+        display_board();
+    }
+    close(fd);
+    dprint("dxp: connection closed\n");
+}
+
+void dxp_connect(char *host,int port,int mycolor,int minutes,int moves)
+/* DXP initiator: play one game from the current board as mycolor
+   against the follower on host:port */
+{
+    struct addrinfo hints,*res;
+    char msg[DXPMSG],name[40],pos[52],service[16];
+    int fd;
+
+    memset(&hints,0,sizeof(hints));
+    hints.ai_family=AF_UNSPEC;
+    hints.ai_socktype=SOCK_STREAM;
+    sprintf(service,"%i",port);
+    if (getaddrinfo(host,service,&hints,&res)!=0) {
+        dprint("dxp: unknown host %s\n",host);
+        return;
+    }
+    fd=socket(res->ai_family,res->ai_socktype,res->ai_protocol);
+    if (fd<0 || connect(fd,res->ai_addr,res->ai_addrlen)!=0) {
+        dprint("dxp: can not connect to %s:%i\n",host,port);
+        if (fd>=0) close(fd);
+        freeaddrinfo(res);
+        return;
+    }
+    freeaddrinfo(res);
+    sprintf(name,"Dragon %s",VERSION);
+    dxp_board(pos,game_color);
+    sprintf(msg,"R01%-32.32s%c%03i%03iB%s",name,mycolor==white ? 'Z' : 'W',minutes,moves,pos);
+    if (dxp_send(fd,msg)==true && dxp_recv(fd,msg,DXPMSG)==true) {
+        if (msg[0]=='A' && msg[33]=='0') {
+            dprint("dxp: game against %.32s\n",msg+1);
+            init_history();
+            game_history_firstcolor=game_color;
+            dxp_game(fd,mycolor,minutes,moves);
+            display_board();
+        }
+        else dprint("dxp: game refused\n");
+    }
+    close(fd);
+}
+#else
+void dxp_listen(int port)
+{
+    dprint("dxp: not supported on this system\n");
+}
+
+void dxp_connect(char *host,int port,int mycolor,int minutes,int moves)
+{
+    dprint("dxp: not supported on this system\n");
+}
+#endif
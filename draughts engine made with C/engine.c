@@ -0,0 +1,368 @@
+/*
+ * Copyright 1996 by Michel D. Grimminck
+ *
+ * All Rights Reserved
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright notice appear in all copies and that
+ * both that copyright notice and this permission notice appear in
+ * supporting documentation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/* engine start up and the engine library, for programs that want more
+   than one engine:
+     d_init()                          once, loads what all engines share:
+                                       databases, patterns, tables, parameters
+     h=dragon_new(hashsize,share)      an engine with its own hash table,
+                                       or the one of engine share
+     dragon_set_position(h,pos)        W/B and 50 fields, or a FEN
+     dragon_set_multipv(h,lines)       lines for sprint_multipv in report
+     dragon_search_async(h,maxtime,maxdepth,report,data)
+     dragon_wait(h,move,ponder)        the move and reply in hub notation
+     dragon_stop(h), dragon_free(h)
+   With USE_THREADS every engine is a thread of its own and the search
+   state is thread-local (LOCAL in var.c), so engines search at the same
+   time. Without threads all handles are the program itself and
+   dragon_search_async returns when the search is done */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "var.h"
+#include "functions.h"
+#ifdef USE_THREADS
+#include <pthread.h>
+#endif
+
+#define ENGINE_IDLE 0
+#define ENGINE_SETPOS 1
+#define ENGINE_SEARCH 2
+#define ENGINE_QUIT 3
+#define ENGINE_SHARE 4
+
+struct _dragon {
+    int hashsize;
+    tpDragon *share;            /* engine whose hash table this one uses */
+    tpTranspos *table;          /* the hash table */
+    int multipv;
+    int command;                /* ENGINE_..., back to ENGINE_IDLE when done */
+    int stop;                   /* dragon_stop for the current search */
+    char position[HUBLINE];
+    float maxtime;
+    int maxdepth;
+    void (*report)(tpDragon *,void *,int,int,double,INT64,char *);
+    void *data;
+    int ok,score;
+    char move[MOVEL*4],ponder[MOVEL*4];
+    struct _clock *clock;       /* of the engine thread */
+#ifdef USE_THREADS
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#endif
+};
+
+static LOCAL tpDragon *self;  /* the engine of this thread */
+
+void setHash(int n)
+{
+    if (transpos!=NULL) {
+        free(transpos);
+    }
+    transpos=(tpTranspos*) calloc(sizeof(tpTranspos),n);
+    if (transpos!=NULL) {
+        tablesize=n;
+    } else {
+        transpos=(tpTranspos*) calloc(sizeof(tpTranspos),5001);
+        n=5001;
+    }
+    init_hash();
+    winprint("\n");
+    winprint("HASHSIZE %i\n",tablesize);
+}
+
+void d_init(void)
+{
+    int i,dbssize=0;
+    extern int npattree,npat;
+
+    dprint("%s\n",VERSION);
+    init_var();
+    main_clock=search_clock();
+    load_parameters();
+    init_databases();
+    mem64_init(true);
+    init_patterns();
+    init_board();
+    set_position(parameters[13],parameters[14]);
+    init_tstats();
+    init_tables();
+    init_lmr();
+    //init_tpat();
+    init_takeback();
+    initDetectPatterns();
+    init_shots();
+    loadBreakThrough();
+    setHash(NHASH);
+    setEvalHash(EVALHASH);
+    #ifdef MAPPEDMEMORY
+    /* XXX*/
+    #else
+    {
+        extern DBINDEX bytesize[4096];
+
+        for(i=0;i<4096;i++) if (database[i]!=NULL) dbssize+=bytesize[i];
+    }
+    #endif
+    dprint("hashtables:%.1f Mb\n",(float) tablesize*sizeof(transpos[0])/1024/1024);
+    dprint("evaltables:%.1f Mb\n",(float) (evalmask+1)*sizeof(evaltable[0])/1024/1024);
+    dprint("patterns:%.1f Mb\n",(float) (npattree*28+npat*sizeof(tpat[0]))/1024/1024);
+    dprint("databases:%.1f Mb\n",(float) dbssize/1024/1024);
+    for(i=1;i<16;i++) dprint("%i ",param_a[i]);
+    dprint("\n");
+    for(i=1;i<16;i++) dprint("%i ",param_b[i]);
+    dprint("\n");
+    for(i=1;i<16;i++) dprint("%i ",param_c[i]);
+    dprint("\n");
+}
+
+static void engine_report(int depth,int score,double t,INT64 nodes)
+/* think report, handed to the report function of the engine */
+{
+    char pv[MPV*MOVEL*4];
+
+    sprint_pv_hub(pv,PV[0]);
+    self->report(self,self->data,depth,score,t,nodes,pv);
+}
+
+static void engine_run(tpDragon *h,int command)
+/* execute command on the state of this thread */
+{
+    char bestmove[MOVEL],pondermove[MOVEL];
+    int color;
+
+    if (command==ENGINE_SHARE) {
+        share_hash(transpos,tablesize);
+        return;
+    }
+    if (command==ENGINE_SETPOS) {
+        if (strchr(h->position,':')!=NULL) color=set_board_fen(h->position);
+        else color=set_board_string(h->position);
+        h->ok=(color>=0);
+        if (color<0) return;
+        game_color=color;
+        init_history();
+        game_history_firstcolor=color;
+        return;
+    }
+    multipv=h->multipv;
+    h->score=think(game_color,h->maxtime,h->maxdepth,bestmove,pondermove,h->report!=NULL ? engine_report : NULL);
+    sprint_move_hub(h->move,bestmove);
+    sprint_move_hub(h->ponder,pondermove);
+}
+
+#ifdef USE_THREADS
+static void *engine_thread(void *arg)
+/* an engine: set up the search state of this thread, then execute the
+   commands of its handle */
+{
+    tpDragon *h=arg;
+    int p,command;
+
+    self=h;
+    for(p=0;p<93;p++) blocked[p]=true;
+    if (h->share!=NULL) share_hash(h->share->table,h->share->hashsize);
+    else setHash(h->hashsize);
+    h->table=transpos;
+    h->hashsize=tablesize;
+    setEvalHash(EVALHASH);
+    init_board();
+    pthread_mutex_lock(&h->mutex);
+    h->clock=search_clock();
+    h->command=ENGINE_IDLE;
+    pthread_cond_broadcast(&h->cond);
+    while (true) {
+        while (h->command==ENGINE_IDLE) pthread_cond_wait(&h->cond,&h->mutex);
+        command=h->command;
+        if (command==ENGINE_QUIT) break;
+        stopflag=h->stop;
+        pthread_mutex_unlock(&h->mutex);
+        engine_run(h,command);
+        pthread_mutex_lock(&h->mutex);
+        stopflag=false;
+        h->command=ENGINE_IDLE;
+        pthread_cond_broadcast(&h->cond);
+    }
+    pthread_mutex_unlock(&h->mutex);
+    fold_db_usage();
+    if (h->share==NULL) free(transpos);
+    free(evaltable);
+    return(NULL);
+}
+
+static void engine_command(tpDragon *h,int command,int wait)
+/* hand command to the engine after the running one, with the mutex held */
+{
+    while (h->command!=ENGINE_IDLE) pthread_cond_wait(&h->cond,&h->mutex);
+    h->command=command;
+    pthread_cond_broadcast(&h->cond);
+    if (wait==true) while (h->command!=ENGINE_IDLE) pthread_cond_wait(&h->cond,&h->mutex);
+}
+#endif
+
+tpDragon *dragon_new(int hashsize,tpDragon *share)
+/* a new engine at the initial position with a hash table of hashsize
+   entries (0 for the default), or if share is not NULL with the hash
+   table of engine share, which is then to be freed last. NULL if the
+   engine can not be started */
+{
+    tpDragon *h;
+
+    h=(tpDragon *) calloc(1,sizeof(tpDragon));
+    if (h==NULL) return(NULL);
+    h->hashsize=hashsize>0 ? hashsize : NHASH;
+    h->share=share;
+    h->multipv=1;
+#ifdef USE_THREADS
+    {
+        pthread_attr_t attr;
+        int r;
+
+        if (share!=NULL) {
+            /* from now on the owner takes the hash locks too */
+            pthread_mutex_lock(&share->mutex);
+            engine_command(share,ENGINE_SHARE,true);
+            pthread_mutex_unlock(&share->mutex);
+        }
+        pthread_mutex_init(&h->mutex,NULL);
+        pthread_cond_init(&h->cond,NULL);
+        h->command=ENGINE_SETPOS;  /* until the thread is set up */
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr,ENGINESTACK);
+        r=pthread_create(&h->thread,&attr,engine_thread,h);
+        pthread_attr_destroy(&attr);
+        if (r!=0) {
+            pthread_mutex_destroy(&h->mutex);
+            pthread_cond_destroy(&h->cond);
+            free(h);
+            return(NULL);
+        }
+        pthread_mutex_lock(&h->mutex);
+        while (h->command!=ENGINE_IDLE) pthread_cond_wait(&h->cond,&h->mutex);
+        pthread_mutex_unlock(&h->mutex);
+    }
+#else
+    if (tablesize!=h->hashsize) setHash(h->hashsize);
+    h->clock=search_clock();
+    init_board();
+#endif
+    return(h);
+}
+
+void dragon_set_multipv(tpDragon *h,int lines)
+/* the number of best lines the next searches find */
+{
+    if (lines<1) lines=1;
+    if (lines>MAXMULTIPV) lines=MAXMULTIPV;
+    h->multipv=lines;
+}
+
+int dragon_set_position(tpDragon *h,char *pos)
+/* set up pos, after the running search. False if pos is not valid */
+{
+    int ok;
+
+#ifdef USE_THREADS
+    /* the engine may still be reading the position of another caller */
+    pthread_mutex_lock(&h->mutex);
+    while (h->command!=ENGINE_IDLE) pthread_cond_wait(&h->cond,&h->mutex);
+    strncpy(h->position,pos,HUBLINE-1);
+    h->position[HUBLINE-1]=0;
+    engine_command(h,ENGINE_SETPOS,true);
+    ok=h->ok;
+    pthread_mutex_unlock(&h->mutex);
+#else
+    strncpy(h->position,pos,HUBLINE-1);
+    h->position[HUBLINE-1]=0;
+    engine_run(h,ENGINE_SETPOS);
+    ok=h->ok;
+#endif
+    return(ok);
+}
+
+void dragon_search_async(tpDragon *h,float maxtime,int maxdepth,
+                         void (*report)(tpDragon *,void *,int,int,double,INT64,char *),void *data)
+/* start a search of the position for at most maxtime seconds (0 is until
+   dragon_stop) and maxdepth plies. report, if not NULL, gets every
+   finished iteration as (h,data,depth,score,time,nodes,pv) on the thread
+   of the engine */
+{
+#ifdef USE_THREADS
+    pthread_mutex_lock(&h->mutex);
+    while (h->command!=ENGINE_IDLE) pthread_cond_wait(&h->cond,&h->mutex);
+#endif
+    h->maxtime=maxtime;
+    h->maxdepth=maxdepth>0 ? 100*maxdepth : INF;
+    h->report=report;
+    h->data=data;
+    h->stop=false;
+    h->move[0]=h->ponder[0]=0;
+    h->score=-INF;
+#ifdef USE_THREADS
+    engine_command(h,ENGINE_SEARCH,false);
+    pthread_mutex_unlock(&h->mutex);
+#else
+    self=h;
+    stopflag=false;
+    engine_run(h,ENGINE_SEARCH);
+    stopflag=false;
+#endif
+}
+
+int dragon_wait(tpDragon *h,char *move,char *ponder)
+/* wait for the search to end, the move and the expected reply go to move
+   and ponder (MOVEL*4 characters, empty if there is none). Returns the
+   score */
+{
+#ifdef USE_THREADS
+    pthread_mutex_lock(&h->mutex);
+    while (h->command!=ENGINE_IDLE) pthread_cond_wait(&h->cond,&h->mutex);
+    pthread_mutex_unlock(&h->mutex);
+#endif
+    if (move!=NULL) strcpy(move,h->move);
+    if (ponder!=NULL) strcpy(ponder,h->ponder);
+    return(h->score);
+}
+
+void dragon_stop(tpDragon *h)
+/* end the running search, it still reports its move */
+{
+#ifdef USE_THREADS
+    pthread_mutex_lock(&h->mutex);
+    if (h->command==ENGINE_SEARCH) {
+        h->stop=true;
+        clock_stop(h->clock);
+    }
+    pthread_mutex_unlock(&h->mutex);
+#endif
+}
+
+void dragon_free(tpDragon *h)
+/* stop the engine and release it */
+{
+#ifdef USE_THREADS
+    dragon_stop(h);
+    pthread_mutex_lock(&h->mutex);
+    engine_command(h,ENGINE_QUIT,false);
+    pthread_mutex_unlock(&h->mutex);
+    pthread_join(h->thread,NULL);
+    pthread_mutex_destroy(&h->mutex);
+    pthread_cond_destroy(&h->cond);
+#endif
+    free(h);
+}
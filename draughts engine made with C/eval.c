@@ -18,6 +18,9 @@
 #include "var.h"
 #include "functions.h"
 #include <math.h>
+#ifdef USE_THREADS
+#include <pthread.h>
+#endif
 
 
 #ifdef DEBUG
@@ -30,7 +33,7 @@ int mobility_eval[40]={-100,-30,-22,-16,-12,-8,-4,0,4,7,10,13,16,18,20,22,24,25,
 
 int near_promo[22]={500,1700,1555,1220,1195,1190,425,410,395,380,365,350,335,320,305,290,275,260,245,230,215,200};
 
-int positional[50]={
+LOCAL int positional[50]={  /* per thread, set_position makes it per stage */
                        0,   0,   0,   0,   0,
                        50,  30,  30,  30,  30,
                        6,   4,   4,   4,  12,
@@ -184,13 +187,13 @@ int pattern[49][8];
 int pattern_type[49];
 short pat_value[918];
 
-void set_eval()
+void set_stage(int s)
+/* loads the parameter set of stage s: 0=endgame, 1=middlegame, 2=opening */
 {
-    int totalman,i;
+    int i;
 
-    totalman=pieces[white|man]+pieces[black|man]+pieces[white|crown]+pieces[black|crown];
-    if (totalman>=0 && totalman<=14) {
-        stage=0;
+    stage=s;
+    if (s==0) {
         for(i=1;i<100;i++) parameters[i]=param_c[i];
         /*if (eval_type==1) {
             parameters[1]=16;
@@ -199,16 +202,25 @@ void set_eval()
             parameters[4]=4;
         }*/
     }
-    else if (totalman>=15 && totalman<=28) {
-        stage=1;
-        for(i=1;i<100;i++) parameters[i]=param_b[i];
-    }
-    else if (totalman>=29 && totalman<=40) {
-        stage=2;
-        for(i=1;i<100;i++) parameters[i]=param_a[i];
-    }
-    else printf("uhhh\n");
+    else if (s==1) for(i=1;i<100;i++) parameters[i]=param_b[i];
+    else for(i=1;i<100;i++) parameters[i]=param_a[i];
     set_position(parameters[13],parameters[14]);
+    init_mancache();
+}
+
+void set_eval()
+{
+    int totalman;
+
+    totalman=pieces[white|man]+pieces[black|man]+pieces[white|crown]+pieces[black|crown];
+    if (totalman>=0 && totalman<=14) set_stage(0);
+    else if (totalman>=15 && totalman<=28) set_stage(1);
+    else if (totalman>=29 && totalman<=40) set_stage(2);
+    else {
+        printf("uhhh\n");
+        set_position(parameters[13],parameters[14]);
+        init_mancache();
+    }
     inDatabases=false;
     //if (databaseIsLoaded(pieces[black|man],pieces[black|crown],pieces[white|man],pieces[white|crown],0,0)==true) inDatabases=true;
     //if (databaseIsLoaded(pieces[white|man],pieces[white|crown],pieces[black|man],pieces[black|crown],0,0)==true) inDatabases=true;
@@ -255,6 +267,194 @@ void set_position(int a,int b)
     for(i=0;i<50;i++) {
         positional[i]=(a*position_fields[0][i]+b*position_fields[1][i])/64;
     }
+    init_psq();
+}
+
+static LOCAL int psq_ready=false;
+
+void init_psq(void)
+/* builds the per piece/field square tables from positional[], crown_positional[],
+   position_fields[4][] and counter[]; black uses the mirrored field 49-ip so the
+   sums match what evalboard sees on its reversed board */
+{
+    int ip,q,op;
+    short *t;
+
+    for(q=0;q<8;q++) for(ip=0;ip<93;ip++) psq_tab[q][ip][0]=psq_tab[q][ip][1]=psq_tab[q][ip][2]=psq_tab[q][ip][3]=0;
+    for(ip=0;ip<50;ip++) for(q=2;q<6;q++) {
+        t=psq_tab[q][map[ip]];
+        if ((q&1)==white) op=ip; else op=49-ip;
+        if ((q&crown)!=0) t[0]=crown_positional[op];
+        else {
+            t[0]=positional[op];
+            t[1]=position_fields[4][op];
+            t[2]=counter[op];
+            t[3]=op/5;
+        }
+    }
+    psq_ready=true;
+    psq_sum();
+}
+
+void psq_sum(void)
+/* recomputes the incremental square-table sums from scratch */
+{
+    int ip,q,c;
+    short *t;
+
+    if (psq_ready==false) init_psq();
+    psq_eval[0]=psq_eval[1]=psq_center[0]=psq_center[1]=psq_tempo[0]=psq_tempo[1]=0;
+    man_key=man_bits[0]=man_bits[1]=pos_key=0;
+    for(c=0;c<2;c++) psq_wing[c][0]=psq_wing[c][1]=psq_wing[c][2]=psq_wing[c][3]=0;
+    for(ip=0;ip<50;ip++) {
+        q=board[map[ip]];
+        if (q<2 || q>5) continue;
+        t=psq_tab[q][map[ip]];
+        c=q&1;
+        psq_eval[c]+=t[0]; psq_center[c]+=t[1]; psq_wing[c][t[2]]++; psq_tempo[c]+=t[3];
+        man_key^=man_rnd[q][map[ip]]; man_bits[c]^=man_bit[q][map[ip]];
+        pos_key^=pos_rnd[q][map[ip]];
+    }
+}
+
+static void batch_run(unsigned char *positions,int size,int n,int *scores)
+/* evaluates the records on the board of this thread, which is left at the
+   last of them. Only the fields that differ from the previous position
+   are updated, so batches of related positions are cheap */
+{
+    unsigned char cur[25],*p;
+    int i,k,precise;
+
+    compress_board(cur,board);
+    for(k=0;k<n;k++) {
+        p=positions+(long) k*size;
+        for(i=0;i<25;i++) if (p[i]!=cur[i]) {
+            set_field(map[2*i],p[i]>>4);
+            set_field(map[2*i+1],p[i]&15);
+            cur[i]=p[i];
+        }
+        scores[k]=evalboard(p[25],-INF,INF,&precise);
+    }
+}
+
+static void batch_here(unsigned char *positions,int size,int n,int *scores)
+/* batch_run on the board of the caller, which is restored afterwards */
+{
+    unsigned char saved[25],cur[25];
+    int i;
+
+    compress_board(saved,board);
+    batch_run(positions,size,n,scores);
+    compress_board(cur,board);
+    for(i=0;i<25;i++) if (saved[i]!=cur[i]) {
+        set_field(map[2*i],saved[i]>>4);
+        set_field(map[2*i+1],saved[i]&15);
+    }
+}
+
+#ifdef USE_THREADS
+typedef struct {
+    unsigned char *positions;
+    int size,n,*scores;
+    /* the evaluation state of the caller */
+    int parameters[100],stage,inDatabases,ignoreDB1,ignoreDB2,game_color,startMan;
+    pthread_t thread;
+    int started;
+} tpBatch;
+
+static void *batch_thread(void *arg)
+/* a slice of evaluate_batch on a board of its own, with the parameters
+   and database state of the caller */
+{
+    tpBatch *b=arg;
+    int i;
+
+    for(i=0;i<93;i++) blocked[i]=true;
+    init_board();
+    for(i=0;i<100;i++) parameters[i]=b->parameters[i];
+    stage=b->stage;
+    inDatabases=b->inDatabases;
+    ignoreDB1=b->ignoreDB1;
+    ignoreDB2=b->ignoreDB2;
+    game_color=b->game_color;
+    startMan=b->startMan;
+    set_position(parameters[13],parameters[14]);
+    init_mancache();
+    batch_run(b->positions,b->size,b->n,b->scores);
+    return(NULL);
+}
+#endif
+
+void evaluate_batch(unsigned char *positions,int size,int n,int *scores)
+/* evaluates n packed positions, size bytes apart, each holding compress_board
+   output followed by the side to move, with the parameter stage of the
+   caller. With USE_THREADS the positions are split over up to batch_threads
+   threads, each on a board of its own, and the board of the caller is not
+   touched. Without threads they are evaluated on the board of the caller,
+   which is restored afterwards */
+{
+#ifdef USE_THREADS
+    tpBatch job[BATCHTHREADS];
+    pthread_attr_t attr;
+    int t,nt,lo,i;
+
+    if (n<=0) return;
+    nt=n/BATCHMIN;
+    if (nt>batch_threads) nt=batch_threads;
+    if (nt>BATCHTHREADS) nt=BATCHTHREADS;
+    if (nt<1) nt=1;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr,ENGINESTACK);
+    for(t=0,lo=0;t<nt;t++) {
+        job[t].positions=positions+(long) lo*size;
+        job[t].size=size;
+        job[t].n=(int) ((long) n*(t+1)/nt)-lo;
+        job[t].scores=scores+lo;
+        for(i=0;i<100;i++) job[t].parameters[i]=parameters[i];
+        job[t].stage=stage;
+        job[t].inDatabases=inDatabases;
+        job[t].ignoreDB1=ignoreDB1;
+        job[t].ignoreDB2=ignoreDB2;
+        job[t].game_color=game_color;
+        job[t].startMan=startMan;
+        job[t].started=(pthread_create(&job[t].thread,&attr,batch_thread,&job[t])==0);
+        lo+=job[t].n;
+    }
+    pthread_attr_destroy(&attr);
+    for(t=0;t<nt;t++) {
+        if (job[t].started==true) pthread_join(job[t].thread,NULL);
+        else batch_here(job[t].positions,size,job[t].n,job[t].scores);
+    }
+#else
+    batch_here(positions,size,n,scores);
+#endif
+}
+
+/* man-structure cache: field_control, mobility_w and btEval only look at the
+   men, so in crown-free positions they are shared by every node with the same
+   structure and side to move */
+struct _mancache {
+    unsigned INT64 bits[2];
+    char valid,color;
+    short control,bt;
+    short mobil[2],nactive[2],nblock[2];
+} LOCAL mancache[MANHASH];
+
+void init_mancache(void)
+{
+    int i;
+
+    for(i=0;i<MANHASH;i++) mancache[i].valid=false;
+}
+
+static struct _mancache *man_entry(int color)
+{
+    return(&mancache[(man_key+color)&(MANHASH-1)]);
+}
+
+static int man_hit(struct _mancache *m,int color)
+{
+    return(m->valid==true && m->color==color && m->bits[0]==man_bits[0] && m->bits[1]==man_bits[1]);
 }
 
 int handle_pattern(int command,char *local,int color)
@@ -435,6 +635,14 @@ int theoretic(int color)
    Returns one of the following:
    WIN/DRAW/LOSE/UNKNOWN
 */
+{
+    return(theoretic_indexed(color,-1,0));
+}
+
+int theoretic_indexed(int color,int handle,DBINDEX index)
+/* theoretic() of a successor for which database_index_batch() found the
+   slice handle and index: with handle>=0 the database is read there
+   instead of locating the slice again */
 {
     int p,eval;
     int wman=0,bman=0,wcrown=0,bcrown=0;
@@ -446,8 +654,9 @@ int theoretic(int color)
     if (color==white && (wman+wcrown)==0) return(LOSE);
     if (color==black && (bman+bcrown)==0) return(LOSE);
 
-    if (wman+wcrown+bman+bcrown<8 && use_db==true) {
-        eval=database_valueWDL(color,wman,wcrown,bman,bcrown);
+    if (DB_FITS(wman,wcrown,bman,bcrown) && use_db==true) {
+        if (handle>=0) eval=database_valueWDL_at(color,handle,index);
+        else eval=database_valueWDL(color,wman,wcrown,bman,bcrown);
         if (eval!=UNKNOWN) {
             if (color==white) return(eval);
             else return(-eval);
@@ -466,6 +675,15 @@ int theoretic(int color)
     return(UNKNOWN);
 }
 
+static int dtw_score(int eval)
+/* converts a raw DTW database value into a distance to win/lose score */
+{
+    if (eval==UNKNOWN) return(UNKNOWN);
+    if (eval==DB_DRAW) return(0);
+    if ((eval & 1)==0) return(LOSE+(eval >>1));
+    return(WIN-((eval+1) >>1));
+}
+
 int theoreticDTW(int color)
 /* tries to determen the distance to win/lose value of the board position, without
    searching.
@@ -495,16 +713,24 @@ int theoreticDTW(int color)
     if (color==white && (wman+wcrown)==0) return(LOSE);
     if (color==black && (bman+bcrown)==0) return(LOSE);
 
-    if (wman+wcrown+bman+bcrown<8) {
+    if (DB_FITS(wman,wcrown,bman,bcrown)) {
         eval=database_valueDTW(color,wman,wcrown,bman,bcrown);
-        if (eval==UNKNOWN) return(UNKNOWN);
-        if (eval==DB_DRAW) return(0);
-        if ((eval & 1)==0) return(LOSE+(eval >>1));
-        return(WIN-((eval+1) >>1));
+        return(dtw_score(eval));
     }
     return(UNKNOWN);
 }
 
+void theoreticDTW_batch(int color,int level,int nmoves,int *score)
+/* theoreticDTW() for all nmoves successors in movelist[level][], with 'color'
+   to move after the successor move. The database probes are batched, see
+   database_valueDTW_batch(). */
+{
+    int m;
+
+    database_valueDTW_batch(color,level,nmoves,score);
+    for(m=0;m<nmoves;m++) score[m]=dtw_score(score[m]);
+}
+
 int material(int color)
 /* evaluates board for player 'color' in a materialistic way.
    Color is to move. A man is 1000 points.
@@ -931,9 +1157,11 @@ int evalboard(int color,int alfa,int beta,int *precise)
     int center,i,p,ip,mat=0,c,totalman,parscore=0,mscore;
     int bbbr,bbbl,fffr,fffl,fl,fr,bl,br,bbl,bbr,ffr,ffl,l,r,f,b;
     int mman,eman,mcrown,ecrown,pat,control=0,dyn=0,eval[2]={0,0},mobil[2];
-    static BTYPE temp[93];
+    static LOCAL BTYPE temp[93];
     BTYPE *local;
     int exact,pos=0,count[10],nactive[2],nblock[2];
+    struct _mancache *mc=NULL;
+    int mhit=false;
     int largeCenter[2];
     int t1,t2;
 #ifdef DEBUG
@@ -942,15 +1170,16 @@ int evalboard(int color,int alfa,int beta,int *precise)
     neval++;
     tneval++;
     
-    t1=0; t2=0;
-    for(ip=0;ip<50;ip++) {
-        if (board[map[ip]]==(white|man)) {
-            t1+=ip/5;
-        }
-        if (board[map[ip]]==(black|man)) {
-            t2+=(49-ip)/5;
-        }
+#ifdef DEBUG
+    {
+        int e0=psq_eval[0],e1=psq_eval[1],c0=psq_center[0],c1=psq_center[1],w0=psq_tempo[0],w1=psq_tempo[1];
+
+        psq_sum();
+        if (e0!=psq_eval[0] || e1!=psq_eval[1] || c0!=psq_center[0] || c1!=psq_center[1] || w0!=psq_tempo[0] || w1!=psq_tempo[1])
+            dprint("incremental eval out of sync\n");
     }
+#endif
+    t1=psq_tempo[white]; t2=psq_tempo[black];
     /*
     if (pieces[white|man]==3 && pieces[black|man]==3 && pieces[white|crown]==0 && pieces[black|crown]==0) {
         printf("%i %i %i\n",t1,t2,t1-t2+color);
@@ -961,10 +1190,12 @@ int evalboard(int color,int alfa,int beta,int *precise)
     }*/
     
     *precise=false;
+    if (search_deadline>0 && (tneval & 4095)==0 && wall_time()>search_deadline) stopflag=true;
     if (windows==true) {
         if ((tneval & 65535)==0) {
             winprint("\n");
             winprint("PROGRESS|*|*|*|%i|*\n",tneval);
+#ifndef COMM_THREADS
             if (windows==true) {
                 /* see if search should be aborted */
                 FILE *in;
@@ -974,6 +1205,7 @@ int evalboard(int color,int alfa,int beta,int *precise)
                     stopflag=true;
                 }
             }
+#endif
         }
     }
     /* material */
@@ -998,7 +1230,14 @@ int evalboard(int color,int alfa,int beta,int *precise)
     }
     totalman=mman+mcrown+eman+ecrown;
     /*    if (mman==4 && mcrown==0 && eman==4 && ecrown==0) new_table_entry(MISC,color,AB,0,0,10);*/
+    if (mcrown==0 && ecrown==0) {
+        mc=man_entry(color);
+        mhit=man_hit(mc,color);
+        if (mhit==true) outman++; else mc->valid=false;
+    }
     /* field control/promotion */
+    if (mhit==true) control=mc->control;
+    else
         if (totalman<28) if (mcrown==0 && ecrown==0) control=field_control(color); else control=0;
 
     /* mobility */
@@ -1007,7 +1246,6 @@ int evalboard(int color,int alfa,int beta,int *precise)
 #ifdef DEBUG
         dprint("color:%i\n",c);
 #endif
-        largeCenter[c]=0;
         if ((color^c)==white) local=board;
         else {
             local=temp;
@@ -1016,10 +1254,22 @@ int evalboard(int color,int alfa,int beta,int *precise)
         if (c==0) set_xray(local);
         else if (c==1) reverse_xray();
 
-        mobil[c]=mobility_w(local,&nactive[c],&nblock[c]);
+        if (mhit==true) {
+            mobil[c]=mc->mobil[c]; nactive[c]=mc->nactive[c]; nblock[c]=mc->nblock[c];
+        }
+        else {
+            mobil[c]=mobility_w(local,&nactive[c],&nblock[c]);
+            if (mc!=NULL) {
+                mc->mobil[c]=mobil[c]; mc->nactive[c]=nactive[c]; mc->nblock[c]=nblock[c];
+            }
+        }
 
         if (mobil[c]<24) mobil[c]=mobility_eval[mobil[c]]; else mobil[c]=32;
-        count[0]=count[1]=count[2]=count[3]=0;
+        /* additive square-table terms are maintained by do_move/undo_move */
+        count[0]=psq_wing[color^c][0]; count[1]=psq_wing[color^c][1];
+        count[2]=psq_wing[color^c][2]; count[3]=psq_wing[color^c][3];
+        eval[c]+=psq_eval[color^c];
+        largeCenter[c]=psq_center[color^c];
 #ifdef DEBUG
         fl0=eval[c];
 #endif
@@ -1028,13 +1278,7 @@ int evalboard(int color,int alfa,int beta,int *precise)
             olde=eval[c];
 #endif
             p=map[ip];
-            if (local[p]==crown) eval[c]+=crown_positional[ip];
             if (local[p]==man) {
-                /* position score */
-                count[counter[ip]]++;
-                eval[c]+=positional[ip];
-                largeCenter[c]+=position_fields[4][ip];
-                
                 if (eval_type==99) {
                     if (xray_b[p]==0) eval[c]+=40+2*progress[ip];
                     else if (xray_b[p]==1) eval[c]+=8+2*progress[ip];
@@ -1459,8 +1703,17 @@ int evalboard(int color,int alfa,int beta,int *precise)
     //dprint("c1: %i\n",largeCenter[1]);
     //dprint("c2: %i\n",(largeCenter[color]-largeCenter[color^1])*(22-totalman)*2);
     if (eval_type==0) pos+=(largeCenter[color]-largeCenter[color^1])*9;
+    if (mc!=NULL && mhit==false) {
+        mc->bits[0]=man_bits[0]; mc->bits[1]=man_bits[1];
+        mc->color=color;
+        mc->control=control;
+        mc->bt=btEval(color);
+        mc->valid=true;
+        inman++;
+    }
     if (eval_type<2) {
-        pos+=btEval(color);
+        if (mc!=NULL) pos+=mc->bt;
+        else pos+=btEval(color);
         //if (btEval(color)!=0) {
         //    display_board();
         //    printf("c: %i, ev: %i, bt: %i i/%i/%i\n\n",color,mat+pos+parscore,btEval(color),mat,pos,parscore);
@@ -1503,7 +1756,7 @@ int evalboard(int color,int alfa,int beta,int *precise)
 #define BRANDNEW 16
 
 #define MIN(a,b) (a<b?a:b)
-int abc_1=0, abc_2=0;
+LOCAL int abc_1=0, abc_2=0;
 
 int field_control(int color)
 /* returns the field control score for 'color' */
@@ -17,20 +17,45 @@
 
 
 #include "const.h"
+#include <stdarg.h>
 extern void display_board(void);
 extern void init_board(void);
+extern int set_board_string(char *);
+extern int set_board_fen(char *);
+extern void get_board_string(char *,int);
 extern void init_var(void);
 extern int load_board(char *);
 extern void print_movelist(int,int);
 extern int move_list(int,int);
 extern void do_move(char *);
 extern void undo_move(char *);
+extern void set_field(int,int);
+extern void evaluate_batch(unsigned char *,int,int,int *);
 extern int alfabeta(int,int,int,int,int,int,int *);
+extern int search_root(int,int,int,int *);
+extern void bench(int);
+extern void start_timer(double);
+extern void stop_timer(void);
+struct _clock;
+extern struct _clock *search_clock(void);
+extern void clock_stop(struct _clock *);
+extern void ponder_hit(struct _clock *);
+extern int think(int,float,int,char *,char *,void (*)(int,int,double,INT64));
+extern int root_excluded(char *);
+extern int search_multipv(int,int,int);
+extern void print_multipv(int,float);
+extern int sprint_multipv(int,char *,int *);
 extern void print_pv(void);
 extern void print_move(char *);
 extern void fprint_move(FILE *,char *);
+extern void sprint_move(char *,char *);
+extern void sprint_move_hub(char *,char *);
+extern void sprint_pv_hub(char *,char [MPV][MOVEL]);
+extern int find_move_squares(int,int,int *,int);
+extern int parse_move(int,int,char *);
 extern void init_stats(void);
 extern void init_tstats(void);
+extern void init_lmr(void);
 extern void print_stats(void);
 extern int evalboard(int,int,int,int *);
 extern void movecopy(char *,char*);
@@ -42,6 +67,10 @@ extern int theoretic(int);
 extern int theoreticDTW(int);
 extern void storemove(int,char *);
 extern void init_hash(void);
+extern void share_hash(struct _transpos *,int);
+extern int setEvalHash(int);
+extern int retreive_eval(int);
+extern void store_eval(int,int);
 extern int play(int,float,int,int);
 extern int material(int);
 extern int movecmp(char *,char *);
@@ -53,17 +82,26 @@ extern void set_pieces(void);
 extern int quiet(int);
 extern int has_promote(int);
 extern void findkiller(int,int);
+extern int find_move(int,int,char *);
+extern int find_hashmove(int,int,char *);
 extern int dynamic(int,int);
 extern void reverse_board(BTYPE *,BTYPE *);
 extern void copy_board(BTYPE *,BTYPE *);
 extern int check_database(char *,int,int);
+extern void tune_add(int,int);
+extern void tune(char *,int);
+extern void load_parameters(void);
+extern void save_parameters(void);
+extern void init_patterns(void);
 extern int text_to_move(char *,int,char *);
 extern unsigned int hash_key(int);
 extern int active(int,int,int,int);
 extern void init_book(void);
+extern void init_tables(void);
 extern void book_info(void);
 extern int try_book(int,int);
 extern void store_history(char *,int,int);
+extern void xstore_history(char *,char *);
 extern void take_back(int);
 extern void show_history(int);
 extern int try_move(int,int,int);
@@ -77,17 +115,26 @@ extern retreive_hash(int,int *,int *,int *,char *);
 extern void set_col(int,int);
 extern void res_col(void);
 extern void set_eval(void);
+extern void set_stage(int);
 extern void set_position(int,int);
+extern void init_psq(void);
+extern void init_mancache(void);
+extern void psq_sum(void);
 extern void init_tpat(void);
 extern int tpat_reconize(int);
 extern void plearn(int,int);
 extern float alloc_time(int);
+extern double wall_time(void);
+extern float tc_alloc(float,int,float);
 extern FILE *my_fopen(char *,char *);
+extern int bin_load(char *,int,void *);
+extern int bin_save(char *,int,int,void *);
 extern int is_repetition(int);
 extern void init_rephash(void);
 extern char *neatNumber(DBINDEX);
 extern DBINDEX db_count(int,int,int,int,int,int);
 extern DBINDEX database_linear_index(int);
+extern DBINDEX database_linear_index_board(BTYPE *,int);
 extern void mem64_test();
 extern void mem64_exit();
 extern void mem64_init(int);
@@ -100,6 +147,7 @@ extern void init_takeback(void);
 extern void print_move_damExchange(char *,int);
 extern void detectPatterns(BTYPE *);
 extern void initDetectPatterns(void);
+extern void init_shots(void);
 extern void init_history(void);
 extern void print_xray(int);
 extern void analyseGame(int,int,float,int,int);
@@ -120,7 +168,51 @@ extern int breakthroughBTM();
 extern void readTestPositions();
 extern void tryGlobalHash(int);
 extern FILE *winGetFile();
+extern void win_write(char *);
+extern void comm_init(void);
+extern FILE *comm_getcommand(char *);
+extern void comm_donecommand(FILE *);
+extern void comm_output(char *);
+extern int comm_vscanf(char *,va_list);
+extern char *comm_getline(char *,int);
+extern void comm_sethook(int (*)(char *));
+extern void hub_loop(void);
+extern void dxp_listen(int);
+extern void dxp_connect(char *,int,int,int,int);
+typedef struct _dragon tpDragon;
+extern void setHash(int);
+extern void d_init(void);
+extern tpDragon *dragon_new(int,tpDragon *);
+extern void dragon_set_multipv(tpDragon *,int);
+extern int dragon_set_position(tpDragon *,char *);
+extern void dragon_search_async(tpDragon *,float,int,void (*)(tpDragon *,void *,int,int,double,INT64,char *),void *);
+extern int dragon_wait(tpDragon *,char *,char *);
+extern void dragon_stop(tpDragon *);
+extern void dragon_free(tpDragon *);
+extern void serve_loop(char *,int,int);
 extern char *database_short_name(int,int,int,int);
 extern void decompressGZfile(char *,char *);
 extern int database_valueDTW(int,int,int,int,int);
 extern int database_nr(int, int,int,int,int, int,int);
+extern int database_index_batch(int,int,int,int,int,int *,DBINDEX *);
+extern void database_valueDTW_batch(int,int,int,int *);
+extern void theoreticDTW_batch(int,int,int,int *);
+extern void mem64_prefetch(int,INT64);
+extern void mem64_lock(void);
+extern void mem64_unlock(void);
+extern void mem64_touch(int,INT64);
+extern int mem64_load(int,char *);
+extern void load_db_history(void);
+extern void save_db_history(void);
+extern void fold_db_usage(void);
+extern int mem64_attach(char *,INT64);
+extern INT64 mem64_loadRaw(char *,INT64,char *);
+extern void publish_databases(void);
+extern int mem64_read(int,INT64);
+extern int probe_value(int,DBINDEX);
+extern int database_probeWDL(BTYPE *,int,int,int,int,int);
+extern int database_valueWDL_at(int,int,DBINDEX);
+extern int theoretic_indexed(int,int,DBINDEX);
+extern int findWS_board(BTYPE *,int,int,int,int);
+extern int findBS_board(BTYPE *,int,int,int,int);
+extern int read_value(int,DBINDEX);
@@ -0,0 +1,238 @@
+/*
+ * Copyright 1996 by Michel D. Grimminck
+ *
+ * All Rights Reserved
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright notice appear in all copies and that
+ * both that copyright notice and this permission notice appear in
+ * supporting documentation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/* Hub protocol front end (dragon -hub), for tournament managers and GUIs
+   that drive engines the way Scan's hub does. A line is a command
+   followed by key=value arguments:
+     hub                      answered by id and wait
+     init                     ready
+     pos pos=X moves="..."    X is W/B and 50 fields of wbWBe, or a FEN
+     level time= inc= moves= move-time= depth= infinite
+     go think|ponder|analyze  info lines, then done move= ponder=
+     stop, ponder-hit         act on a running go
+     ping, new-game, set-param, quit
+   With COMM_THREADS the reader thread hands stop and ponder-hit to the
+   search. Without threads they are read after the search, and a go
+   ponder searches as go think */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "var.h"
+#include "functions.h"
+#ifdef COMM_THREADS
+#include <pthread.h>
+#endif
+
+static float hub_time=0,hub_inc=0,hub_movetime=0;
+static int hub_moves=0,hub_depth=0,hub_infinite=false;
+
+#ifdef COMM_THREADS
+/* the reader sees the commands before the main thread does, so both
+   number the go commands: stop and ponder-hit belong to the last go */
+static pthread_mutex_t hub_mutex=PTHREAD_MUTEX_INITIALIZER;
+static int seen_go=0;  /* go commands read by the reader thread */
+static int run_go=0;   /* go being searched, 0 for none */
+static int hit_go=0,stop_go=0;
+static struct _clock *hub_clock;  /* of the thread running hub_loop */
+
+static int hub_hook(char *line)
+/* reader thread: take stop and ponder-hit */
+{
+    char word[16];
+    int r=false;
+
+    if (sscanf(line,"%15s",word)!=1) return(false);
+    pthread_mutex_lock(&hub_mutex);
+    if (strcmp(word,"go")==0) seen_go++;
+    else if (strcmp(word,"stop")==0) {
+        stop_go=seen_go;
+        if (run_go==seen_go) clock_stop(hub_clock);
+        r=true;
+    }
+    else if (strcmp(word,"ponder-hit")==0) {
+        hit_go=seen_go;
+        if (run_go==seen_go) ponder_hit(hub_clock);
+        r=true;
+    }
+    pthread_mutex_unlock(&hub_mutex);
+    return(r);
+}
+#endif
+
+static int hub_arg(char *args,char *key,char *value,int size)
+/* copy the value of key=value or key="value" in args to value, empty for
+   a key without value. Returns false if args has no key */
+{
+    char *p=args;
+    int n=0,len=strlen(key);
+
+    while ((p=strstr(p,key))!=NULL) {
+        if ((p==args || isspace(p[-1])) && (p[len]=='=' || p[len]==0 || isspace(p[len]))) break;
+        p+=len;
+    }
+    if (p==NULL) return(false);
+    p+=len;
+    if (*p=='=') {
+        p++;
+        if (*p=='"') {
+            p++;
+            while (*p!=0 && *p!='"' && n<size-1) value[n++]=*p++;
+        }
+        else while (*p!=0 && !isspace(*p) && n<size-1) value[n++]=*p++;
+    }
+    value[n]=0;
+    return(true);
+}
+
+static void hub_info(int depth,int score,double t,INT64 nodes)
+/* think report of a finished iteration */
+{
+    char text[MPV*MOVEL*4];
+
+    sprint_pv_hub(text,PV[0]);
+    printf("info depth=%i score=%.2f nodes=%llu time=%.2f nps=%.0f pv=\"%s\"\n",
+           depth/100,score/1000.0F,nodes,t,t>0 ? nodes/t : 0.0,text);
+    fflush(stdout);
+}
+
+static void hub_pos(char *args)
+/* pos [start] [pos=X] [moves="..."] */
+{
+    char value[HUBLINE],word[MOVEL];
+    char *p;
+    int color,m,n;
+
+    if (hub_arg(args,"pos",value,HUBLINE)==true) {
+        if (strchr(value,':')!=NULL) color=set_board_fen(value);
+        else color=set_board_string(value);
+        if (color<0) {
+            printf("error message=\"bad position %s\"\n",value);
+            return;
+        }
+        game_color=color;
+        init_history();
+        game_history_firstcolor=color;
+    }
+    else init_board();
+    if (hub_arg(args,"moves",value,HUBLINE)==true) {
+        p=value;
+        while (sscanf(p,"%63s%n",word,&n)==1) {
+            p+=n;
+            m=parse_move(0,move_list(0,game_color),word);
+            if (m<0) {
+                printf("error message=\"illegal move %s\"\n",word);
+                return;
+            }
+            xstore_history(movelist[0][m],"");
+            do_move(movelist[0][m]);
+        }
+    }
+}
+
+static void hub_level(char *args)
+/* a level line replaces the whole time control */
+{
+    char value[64];
+
+    hub_time=hub_inc=hub_movetime=0;
+    hub_moves=hub_depth=0;
+    hub_infinite=hub_arg(args,"infinite",value,64);
+    if (hub_arg(args,"time",value,64)==true) hub_time=atof(value);
+    if (hub_arg(args,"inc",value,64)==true) hub_inc=atof(value);
+    if (hub_arg(args,"moves",value,64)==true) hub_moves=atoi(value);
+    if (hub_arg(args,"move-time",value,64)==true) hub_movetime=atof(value);
+    if (hub_arg(args,"depth",value,64)==true) hub_depth=atoi(value);
+}
+
+static void hub_go(char *args,int gonr)
+/* go think|ponder|analyze, answered by done */
+{
+    char value[64],text[MOVEL*4];
+    char bestmove[MOVEL],pondermove[MOVEL];
+    float maxtime=0;
+    int maxdepth=INF,ponder;
+
+    ponder=hub_arg(args,"ponder",value,64);
+    if (hub_depth>0) maxdepth=100*hub_depth;
+    if (hub_infinite==true || hub_arg(args,"analyze",value,64)==true) maxtime=0;
+    else if (hub_movetime>0) maxtime=hub_movetime;
+    else if (hub_time>0) maxtime=tc_alloc(hub_time,hub_moves,hub_inc);
+#ifdef COMM_THREADS
+    pthread_mutex_lock(&hub_mutex);
+    run_go=gonr;
+    pondering=(ponder==true && hit_go!=gonr);
+    stopflag=(stop_go==gonr);
+    pthread_mutex_unlock(&hub_mutex);
+#else
+    stopflag=false;
+#endif
+    think(game_color,maxtime,maxdepth,bestmove,pondermove,hub_info);
+#ifdef COMM_THREADS
+    pthread_mutex_lock(&hub_mutex);
+    run_go=0;
+    pondering=false;
+    pthread_mutex_unlock(&hub_mutex);
+#endif
+    stopflag=false;
+    if (bestmove[0]==0) {
+        printf("done\n");
+        return;
+    }
+    sprint_move_hub(text,bestmove);
+    printf("done move=%s",text);
+    if (pondermove[0]!=0) {
+        sprint_move_hub(text,pondermove);
+        printf(" ponder=%s",text);
+    }
+    printf("\n");
+}
+
+void hub_loop(void)
+/* answer hub commands until quit or the end of the input */
+{
+    char line[HUBLINE],cmd[32];
+    char *args;
+    int ngo=0;
+
+#ifdef COMM_THREADS
+    hub_clock=search_clock();
+    comm_sethook(hub_hook);
+#endif
+    while (comm_getline(line,HUBLINE)!=NULL) {
+        if (sscanf(line,"%31s",cmd)!=1) continue;
+        args=strstr(line,cmd)+strlen(cmd);
+        if (strcmp(cmd,"hub")==0) {
+            printf("id name=Dragon version=\"%s\" author=\"Michel Grimminck\" country=Netherlands\n",VERSION);
+            printf("wait\n");
+        }
+        else if (strcmp(cmd,"init")==0) printf("ready\n");
+        else if (strcmp(cmd,"ping")==0) printf("pong\n");
+        else if (strcmp(cmd,"new-game")==0) init_board();
+        else if (strcmp(cmd,"pos")==0) hub_pos(args);
+        else if (strcmp(cmd,"level")==0) hub_level(args);
+        else if (strcmp(cmd,"go")==0) hub_go(args,++ngo);
+        else if (strcmp(cmd,"quit")==0) break;
+        else if (strcmp(cmd,"stop")!=0 && strcmp(cmd,"ponder-hit")!=0 && strcmp(cmd,"set-param")!=0) {
+            printf("error message=\"unknown command %s\"\n",cmd);
+        }
+        fflush(stdout);
+    }
+#ifdef COMM_THREADS
+    comm_sethook(NULL);
+#endif
+}
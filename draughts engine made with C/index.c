@@ -27,9 +27,9 @@
 #include <stdio.h>
 #include "var.h"
 #include "const.h"
+#include "functions.h"
+
 
-int list[8][12];
-    
 /*
 DBINDEX fac(int a)
 {
@@ -43,11 +43,8 @@ DBINDEX fac(int a)
 }
 */
 
-int MULT[64][64];
-int I2[64];
-int I3[64];
-int I4[64];
-int I5[64];
+DBINDEX MULT[64][64];
+DBINDEX IC[DB_MAXTYPE+1][64];   /* IC[k][a]= a over k, for the combinatorial index of k pieces */
 
 int SLW[50]={
     0,0,0,0,0,
@@ -100,10 +97,7 @@ void init_index()
         }
     }
     for (a=0;a<=50;a++) {
-        I2[a]= a*(a-1)/2;
-        I3[a]= a*(a-1)*(a-2)/6;
-        I4[a]= a*(a-1)*(a-2)*(a-3)/24;
-        I5[a]= a*(a-1)*(a-2)*(a-3)*(a-4)/120;
+        for (i=0;i<=DB_MAXTYPE;i++) IC[i][a]=mult(a,a-i);
     }
 }
 
@@ -137,16 +131,31 @@ DBINDEX db_count(int wman,int wcrown,int bman,int bcrown,int ws,int bs)
     return(cwc*cbc*cwm*cbm);
 }
 
-/*
-#define I2(a) a*(a-1)/2
-#define I3(a) a*(a-1)*(a-2)/6
-#define I4(a) a*(a-1)*(a-2)*(a-3)/24
-#define I5(a) a*(a-1)*(a-2)*(a-3)*(a-4)/120
+static DBINDEX comb_index(int *l,int n,int descending)
+/* combinatorial index of n pieces on the squares l[0..n-1]. The squares are
+   sorted: descending (l[0] largest) or ascending.
+   For n=3 descending this is  (l0 over 3)+(l1 over 2)+l2
 */
+{
+    DBINDEX r=0;
+    int k;
+
+    if (descending==true) for(k=0;k<n;k++) r+=IC[n-k][l[k]];
+    else for(k=0;k<n;k++) r+=IC[k+1][l[k]];
+    return(r);
+}
 
 DBINDEX database_linear_index(int color)
 /* reads the 'board' array and determens the index function (not in bytes)
 */
+{
+    return(database_linear_index_board(board,color));
+}
+
+DBINDEX database_linear_index_board(BTYPE *b,int color)
+/* index function of board 'b'. Uses no global state, so it may be called from
+   several threads at once.
+*/
 {
     // index=blackmanindex.whitemanindex.blackcrownindex.whitecrownindex
     #define WM white|man
@@ -157,17 +166,18 @@ DBINDEX database_linear_index(int color)
     int npwm=0,npbm=0,npwc=0,npbc=0;  //number of white man, crown, etc.
     int p;
     int ws=0,bs=0;     // white,black slice
-    int iwc;   // local index white crown
-    int ibc;   // local index black crown
-    int iwm;
-    int ibm;
+    DBINDEX iwc;   // local index white crown
+    DBINDEX ibc;   // local index black crown
+    DBINDEX iwm;
+    DBINDEX ibm;
     int small=false;
     
     DBINDEX p1,p2,p3;
     DBINDEX index;
     int maxPosWman,maxPosBman;
+    int list[8][12];
     
-    if (color==white) for(p=0;p<50;p++) switch(board[map[p]]) {
+    if (color==white) for(p=0;p<50;p++) switch(b[map[p]]) {
             case white|man:{
                     list[white|man][npwm++]=49-p;
                     if (SLW[p]>ws) ws=SLW[p];
@@ -183,7 +193,7 @@ DBINDEX database_linear_index(int color)
             case black|crown:{
                     list[black|crown][npbc++]=p;break;}
             }
-    else for(p=49;p>=0;p--) switch(board[map[p]]) {
+    else for(p=49;p>=0;p--) switch(b[map[p]]) {
             case black|man:{
                     list[white|man][npwm++]=p;
                     if (SLW[49-p]>ws) ws=SLW[49-p];
@@ -209,118 +219,13 @@ DBINDEX database_linear_index(int color)
         else { p1=MULT[45][45-npwm+12]*p2; }
     }	
     //printf("%i %i %i\n",p1,npwm,small);
-    switch(npwc) {
-    	case 0: {
-    	    iwc=0;
-    	    break;
-    	}
-    	case 1: {
-        	iwc=list[WC][0];
-        	break;
-    	}
-    	case 2: {
-    	    iwc=I2[list[WC][0]]+list[WC][1];
-    	    break;
-    	}
-    	case 3: {
-    	    iwc=I3[list[WC][0]]+I2[list[WC][1]]+list[WC][2];
-    	    break;
-    	}
-    	case 4: {
-    	    iwc=I4[list[WC][0]]+I3[list[WC][1]]+I2[list[WC][2]]+list[WC][3];
-    	    break;
-    	}
-    	case 5: {
-    	    iwc=I5[list[WC][0]]+I4[list[WC][1]]+I3[list[WC][2]]+I2[list[WC][3]]+list[WC][4];
-    	    break;
-    	}
-    }
-    
-    switch(npbc) {
-    	case 0: {
-    	    ibc=0;
-    	    break;
-    	}
-    	case 1: {
-        	ibc=list[BC][0];
-        	break;
-    	}
-    	case 2: {
-    	    ibc=I2[list[BC][1]]+list[BC][0];
-    	    break;
-    	}
-    	case 3: {
-    	    ibc=I3[list[BC][2]]+I2[list[BC][1]]+list[BC][0];
-    	    break;
-    	}
-    	case 4: {
-    	    ibc=I4[list[BC][3]]+I3[list[BC][2]]+I2[list[BC][1]]+list[BC][0];
-    	    break;
-    	}
-    	case 5: {
-    	    ibc=I5[list[BC][4]]+I4[list[BC][3]]+I3[list[BC][2]]+I2[list[BC][1]]+list[BC][0];
-    	    break;
-    	}
-    }
-
-    switch(npwm) {
-    	case 0: {
-    	    iwm=0;
-    	    break;
-    	}
-    	case 1: {
-        	iwm=list[WM][0];
-        	break;
-    	}
-    	case 2: {
-    	    iwm=I2[list[WM][0]]+list[WM][1];
-    	    break;
-    	}
-    	case 3: {
-    	    iwm=I3[list[WM][0]]+I2[list[WM][1]]+list[WM][2];
-    	    break;
-    	}
-    	case 4: {
-    	    iwm=I4[list[WM][0]]+I3[list[WM][1]]+I2[list[WM][2]]+list[WM][3];
-    	    break;
-    	}
-    	case 5: {
-    	    iwm=I5[list[WM][0]]+I4[list[WM][1]]+I3[list[WM][2]]+I2[list[WM][3]]+list[WM][4];
-    	    break;
-    	}
-    }
+    iwc=comb_index(list[WC],npwc,true);
+    ibc=comb_index(list[BC],npbc,false);
+    iwm=comb_index(list[WM],npwm,true);
    	if (npwm>0 && small==false) iwm-=MULT[ws][ws-npwm+12];
-
-    switch(npbm) {
-    	case 0: {
-    	    ibm=0;
-    	    break;
-    	}
-    	case 1: {
-        	ibm=list[BM][0];
-        	break;
-    	}
-    	case 2: {
-    	    ibm=I2[list[BM][1]]+list[BM][0];
-    	    break;
-    	}
-    	case 3: {
-    	    ibm=I3[list[BM][2]]+I2[list[BM][1]]+list[BM][0];
-    	    break;
-    	}
-    	case 4: {
-    	    ibm=I4[list[BM][3]]+I3[list[BM][2]]+I2[list[BM][1]]+list[BM][0];
-    	    break;
-    	}
-    	case 5: {
-    	    ibm=I5[list[BM][4]]+I4[list[BM][3]]+I3[list[BM][2]]+I2[list[BM][1]]+list[BM][0];
-    	    break;
-    	}
-    }
-   	
+    ibm=comb_index(list[BM],npbm,false);
    	if (npbm>0 && small==false) ibm-=MULT[bs][bs-npbm+12];
 
-    
     index=(ibm*p1)+(iwm*p2)+(ibc*p3)+iwc;
     //printf(": %llu  %llu  %llu  %llu, slw=%i, slb=%i\n",ibm,iwm,ibc,iwc,ws,bs);
     //printf("id:%llu\n",index);
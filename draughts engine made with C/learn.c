@@ -16,6 +16,13 @@
 
 #include <time.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
 #include "functions.h"
 #include "var.h"
 
@@ -303,11 +310,13 @@ int check_database(char *file,int min,int max)
     int total,count=0,games=0,playmove;
     float q=0;
     int result; //1=white wins, 0=draw, -1=black wins
+    int known;  // game has a result tag
     in=my_fopen(file,"r");
     if (in==NULL) {printf("error opening database\n"); return(0);}
 
     do {
         result=0;
+        known=false;
         playmove=0;
         col=2;
         /* read leader */
@@ -319,9 +328,9 @@ int check_database(char *file,int min,int max)
                 ungetc(n,in);
                 fgets(field,2048,in);
                 printf("%s\n",field);
-                if (strncmp(field,"[Result \"1-0\"]",14)==0) result=1;
-                if (strncmp(field,"[Result \"1/2-1/2\"]",18)==0) result=0;
-                if (strncmp(field,"[Result \"0-1\"]",14)==0) result=-1;
+                if (strncmp(field,"[Result \"1-0\"]",14)==0) {result=1; known=true;}
+                if (strncmp(field,"[Result \"1/2-1/2\"]",18)==0) {result=0; known=true;}
+                if (strncmp(field,"[Result \"0-1\"]",14)==0) {result=-1; known=true;}
                 //printf("%s",field);
             }
         } while (n!='1');
@@ -396,6 +405,7 @@ int check_database(char *file,int min,int max)
                         add_book_entry(col,res,0,true);
                     }
                     if (parameters[0]==-4) store_history(move,0,0);
+                    if (parameters[0]==-8 && known==true && quiet(col)==true && theoretic(col)==UNKNOWN) tune_add(col,result);
                     if (parameters[0]==-7 && quiet(col)==true && pieces[white|man]>2 && pieces[white|crown]==0 && pieces[black|man]>2 && pieces[black|crown]==0) {
                         BTYPE temp[93];
                         int nr1,nr2,nmoves1,nmoves2;
@@ -498,3 +508,291 @@ void readTestPositions()
     }
     printf("total time: %f\n",(clock()-tstart)/CLOCKS_PER_SEC);
 }
+
+/* Texel style tuning of the stage parameters. Quiet positions from
+   games with a known result are collected by check_database (mode -8),
+   the evaluation is mapped to a win probability with 1/(1+exp(-K*e))
+   and the log-loss against the game results is minimised by coordinate
+   descent. The loss is computed in parallel by worker processes, each
+   owning a slice of the positions. */
+
+#define TUNEPARAMS 16   /* parameters 1..16 of each stage are tuned */
+#define MAXWORKERS 64
+#define TUNELIMIT 250   /* tuned values stay within -TUNELIMIT..TUNELIMIT */
+#define TUNEPASSES 20   /* maximal number of passes per step size */
+
+typedef struct {
+    unsigned char board[25];
+    char color;     /* board and color form the evaluate_batch record */
+    char result;    /* 1=white wins, 0=draw, -1=black wins */
+    char stage;
+} tpTunePos;
+
+static tpTunePos *tunepos=NULL;
+static int ntunepos=0,maxtunepos=0;
+static int *tunescore=NULL;
+
+void tune_add(int color,int result)
+/* adds the current position to the tuning set */
+{
+    int total;
+
+    if (ntunepos==maxtunepos) {
+        tpTunePos *p;
+        maxtunepos=maxtunepos ? 2*maxtunepos : 65536;
+        p=realloc(tunepos,maxtunepos*sizeof(tpTunePos));
+        if (p==NULL) {printf("tune: out of memory\n"); exit(-1);}
+        tunepos=p;
+    }
+    total=pieces[white|man]+pieces[white|crown]+pieces[black|man]+pieces[black|crown];
+    compress_board(tunepos[ntunepos].board,board);
+    tunepos[ntunepos].color=color;
+    tunepos[ntunepos].result=result;
+    if (total<=14) tunepos[ntunepos].stage=0;
+    else if (total<=28) tunepos[ntunepos].stage=1;
+    else tunepos[ntunepos].stage=2;
+    ntunepos++;
+}
+
+static void tune_sort(void)
+/* groups the positions by stage, keeping game order within a stage so
+   that consecutive positions differ in few fields */
+{
+    tpTunePos *sorted;
+    int i,s,n=0;
+
+    sorted=malloc(ntunepos*sizeof(tpTunePos));
+    if (sorted==NULL) return;
+    for(s=0;s<3;s++) for(i=0;i<ntunepos;i++) if (tunepos[i].stage==s) sorted[n++]=tunepos[i];
+    free(tunepos);
+    tunepos=sorted;
+    maxtunepos=ntunepos;
+}
+
+static double tune_loss(int lo,int hi,double K)
+/* summed log-loss of the positions lo..hi-1 */
+{
+    int i,j,e;
+    double p,y,sum=0.0;
+
+    for(i=lo;i<hi;i=j) {
+        for(j=i;j<hi && tunepos[j].stage==tunepos[i].stage;j++);
+        set_stage(tunepos[i].stage);
+        evaluate_batch(tunepos[i].board,sizeof(tpTunePos),j-i,&tunescore[i]);
+    }
+    for(i=lo;i<hi;i++) {
+        e=tunescore[i];
+        if (tunepos[i].color==black) e=-e;
+        p=1.0/(1.0+exp(-K*e));
+        if (p<1e-6) p=1e-6;
+        if (p>1.0-1e-6) p=1.0-1e-6;
+        y=0.5*(tunepos[i].result+1);
+        sum-=y*log(p)+(1.0-y)*log(1.0-p);
+    }
+    return(sum);
+}
+
+#ifndef _WIN32
+static int nworkers=0;
+static int tofd[MAXWORKERS],fromfd[MAXWORKERS];
+static pid_t workerpid[MAXWORKERS];
+
+typedef struct {
+    int a[TUNEPARAMS+1],b[TUNEPARAMS+1],c[TUNEPARAMS+1];
+    double K;
+} tpTuneJob;
+
+static void tune_worker(int in,int out,int lo,int hi)
+/* computes the loss of its slice for every parameter set it receives */
+{
+    tpTuneJob job;
+    double loss;
+
+    while (read(in,&job,sizeof(job))==sizeof(job)) {
+        memcpy(param_a,job.a,sizeof(job.a));
+        memcpy(param_b,job.b,sizeof(job.b));
+        memcpy(param_c,job.c,sizeof(job.c));
+        loss=tune_loss(lo,hi,job.K);
+        if (write(out,&loss,sizeof(loss))!=sizeof(loss)) break;
+    }
+    exit(0);
+}
+
+static void tune_start_workers(int n)
+{
+    int i,lo,hi,p1[2],p2[2];
+
+    if (n>MAXWORKERS) n=MAXWORKERS;
+    nworkers=0;
+    for(i=0;i<n;i++) {
+        lo=(int) ((long) ntunepos*i/n);
+        hi=(int) ((long) ntunepos*(i+1)/n);
+        if (pipe(p1)!=0) break;
+        if (pipe(p2)!=0) {close(p1[0]); close(p1[1]); break;}
+        fflush(stdout);
+        workerpid[i]=fork();
+        if (workerpid[i]<0) {close(p1[0]); close(p1[1]); close(p2[0]); close(p2[1]); break;}
+        if (workerpid[i]==0) {
+            int j;
+            for(j=0;j<nworkers;j++) {close(tofd[j]); close(fromfd[j]);}
+            close(p1[1]); close(p2[0]);
+            batch_threads=1;  /* the workers are the parallelism */
+            tune_worker(p1[0],p2[1],lo,hi);
+        }
+        close(p1[0]); close(p2[1]);
+        tofd[i]=p1[1]; fromfd[i]=p2[0];
+        nworkers++;
+    }
+    if (nworkers<n) printf("tune: started %i of %i workers\n",nworkers,n);
+}
+
+static void tune_stop_workers(void)
+{
+    int i;
+
+    for(i=0;i<nworkers;i++) {close(tofd[i]); close(fromfd[i]);}
+    for(i=0;i<nworkers;i++) waitpid(workerpid[i],NULL,0);
+    nworkers=0;
+}
+#endif
+
+static double tune_total(double K)
+/* mean loss over the whole tuning set with the current param_a/b/c */
+{
+    double sum=0.0;
+#ifndef _WIN32
+    if (nworkers>0) {
+        tpTuneJob job;
+        double loss;
+        int i;
+
+        memcpy(job.a,param_a,sizeof(job.a));
+        memcpy(job.b,param_b,sizeof(job.b));
+        memcpy(job.c,param_c,sizeof(job.c));
+        job.K=K;
+        for(i=0;i<nworkers;i++) write(tofd[i],&job,sizeof(job));
+        for(i=0;i<nworkers;i++) {
+            if (read(fromfd[i],&loss,sizeof(loss))!=sizeof(loss)) {
+                printf("tune: worker %i died\n",i);
+                exit(-1);
+            }
+            sum+=loss;
+        }
+        return(sum/ntunepos);
+    }
+#endif
+    sum=tune_loss(0,ntunepos,K);
+    return(sum/ntunepos);
+}
+
+static double tune_fit_k(void)
+/* golden section search for the scaling constant K */
+{
+    double a=1e-5,b=0.05,c,d,fc,fd;
+    double g=0.6180339887;
+    int i;
+
+    c=b-g*(b-a); d=a+g*(b-a);
+    fc=tune_total(c); fd=tune_total(d);
+    for(i=0;i<30;i++) {
+        if (fc<fd) {
+            b=d; d=c; fd=fc;
+            c=b-g*(b-a); fc=tune_total(c);
+        }
+        else {
+            a=c; c=d; fc=fd;
+            d=a+g*(b-a); fd=tune_total(d);
+        }
+    }
+    return(0.5*(a+b));
+}
+
+void save_parameters(void)
+/* writes the stage parameters to tables/params.txt */
+{
+    FILE *out;
+    int i;
+
+    out=my_fopen("tables/params.txt","w");
+    if (out==NULL) {printf("error writing tables/params.txt\n"); return;}
+    fprintf(out,"a"); for(i=1;i<=TUNEPARAMS;i++) fprintf(out," %i",param_a[i]); fprintf(out,"\n");
+    fprintf(out,"b"); for(i=1;i<=TUNEPARAMS;i++) fprintf(out," %i",param_b[i]); fprintf(out,"\n");
+    fprintf(out,"c"); for(i=1;i<=TUNEPARAMS;i++) fprintf(out," %i",param_c[i]); fprintf(out,"\n");
+    fclose(out);
+}
+
+void load_parameters(void)
+/* reads tuned stage parameters from tables/params.txt, if present */
+{
+    FILE *in;
+    char name[8];
+    int i,*p;
+
+    in=my_fopen("tables/params.txt","r");
+    if (in==NULL) return;
+    while (fscanf(in,"%7s",name)==1) {
+        if (strcmp(name,"a")==0) p=param_a;
+        else if (strcmp(name,"b")==0) p=param_b;
+        else if (strcmp(name,"c")==0) p=param_c;
+        else break;
+        for(i=1;i<=TUNEPARAMS;i++) if (fscanf(in,"%i",&p[i])!=1) break;
+    }
+    fclose(in);
+    dprint("parameters loaded from tables/params.txt\n");
+}
+
+void tune(char *file,int workers)
+/* tunes param_a/b/c on the games in file using workers processes */
+{
+    int *set[3],s,i,step,improved,pass;
+    double K,best,loss;
+
+    parameters[0]=-8;
+    search_min=0;
+    search_max=40;
+    perc=1.0;
+    ntunepos=0;
+    check_database(file,search_min,search_max);
+    if (ntunepos==0) {printf("tune: no positions\n"); return;}
+    tune_sort();
+    tunescore=realloc(tunescore,ntunepos*sizeof(int));
+    if (tunescore==NULL) {printf("tune: out of memory\n"); return;}
+    inDatabases=false;
+    printf("tune: %i positions\n",ntunepos);
+#ifndef _WIN32
+    if (workers>1) tune_start_workers(workers);
+#endif
+    K=tune_fit_k();
+    best=tune_total(K);
+    printf("tune: K=%.6f loss=%.6f\n",K,best);
+
+    set[0]=param_c; set[1]=param_b; set[2]=param_a;
+    for(step=4;step>=1;step/=2) {
+        pass=0;
+        do {
+            improved=false;
+            for(s=0;s<3;s++) for(i=1;i<=TUNEPARAMS;i++) {
+                if (set[s][i]+step<=TUNELIMIT) {
+                    set[s][i]+=step;
+                    loss=tune_total(K);
+                    if (loss<best) {best=loss; improved=true; continue;}
+                    set[s][i]-=step;
+                }
+                if (set[s][i]-step>=-TUNELIMIT) {
+                    set[s][i]-=step;
+                    loss=tune_total(K);
+                    if (loss<best) {best=loss; improved=true; continue;}
+                    set[s][i]+=step;
+                }
+            }
+            pass++;
+            printf("tune: pass %i step %i loss=%.6f\n",pass,step,best);
+            if (improved==true) save_parameters();
+        } while (improved==true && pass<TUNEPASSES);
+    }
+#ifndef _WIN32
+    tune_stop_workers();
+#endif
+    save_parameters();
+    set_eval();
+}
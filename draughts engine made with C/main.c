@@ -21,8 +21,11 @@
 #include <math.h>
 #include "var.h"
 #include <signal.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
-extern int abc_1,abc_2;
+extern LOCAL int abc_1,abc_2;
 int timeControlMode=TCM_TIME_PER_MOVE;
 float timeControlTimePerMove=4.0F;
 int timeControlMaxPly=5;
@@ -130,59 +133,6 @@ void stopprogram(int sig)
     if (a[0]=='y' || a[0]=='Y') exit(0);
 }
 
-void setHash(int n)
-{
-    printf("h:%i %i\n",sizeof(tpTranspos),transpos);
-    
-    if (transpos!=NULL) {
-        free(transpos);
-    }
-    transpos=(tpTranspos*) calloc(sizeof(tpTranspos),n);
-    if (transpos!=NULL) {
-        tablesize=n;
-    } else {
-        transpos=(tpTranspos*) calloc(sizeof(tpTranspos),5001);
-        n=5001;
-    }
-    init_hash();
-    winprint("\n");
-    winprint("HASHSIZE %i\n",tablesize);
-}
-
-void d_init(void)
-{
-    int i,dbssize=0;
-    extern DBINDEX bytesize[4096];
-    extern int npattree,npat;
-
-    dprint("%s\n",VERSION);
-    init_var();
-    init_databases();
-    mem64_init(true);
-    init_patterns();
-    init_board();
-    set_position(parameters[13],parameters[14]);
-    init_tstats();
-    init_tables();
-    //init_tpat();
-    init_takeback();
-    initDetectPatterns();
-    loadBreakThrough();
-    setHash(NHASH);
-    #ifdef MAPPEDMEMORY
-    /* XXX*/
-    #else
-        for(i=0;i<4096;i++) if (database[i]!=NULL) dbssize+=bytesize[i];
-    #endif
-    dprint("hashtables:%.1f Mb\n",(float) tablesize*sizeof(transpos[0])/1024/1024);
-    dprint("evaltables:%.1f Mb\n",(float) MAXEVAL*sizeof(evalcache[0])/1024/1024);
-    dprint("patterns:%.1f Mb\n",(float) (npattree*28+npat*sizeof(tpat[0]))/1024/1024);
-    dprint("databases:%.1f Mb\n",(float) dbssize/1024/1024);
-    for(i=1;i<16;i++) dprint("%i ",param_a[i]); dprint("\n");
-    for(i=1;i<16;i++) dprint("%i ",param_b[i]); dprint("\n");
-    for(i=1;i<16;i++) dprint("%i ",param_c[i]); dprint("\n");
-}
-
 #ifdef MAKEDLL
 __attribute__((stdcall)) int helloWorld(int test)
 {   
@@ -197,16 +147,27 @@ int main(int argc,char* argv[])
     int in1,in2;
     char input[1024],buffer[100];
     int alfa=-INF,beta=INF,fitdepth=-999;
-    int asa=false;
     FILE *in;
     int my_color=white;
     char args[40000];
+    int hubmode=false,out=-1;
+    char servepath[256]="";
+    int serveworkers=1,sharehash=false;
     
     //db33=malloc(205001002);
     //for (i=0;i<205001002;i++) db33[i]=0;
     
     /*read_wingame();*/
     /*dfscanf(in,"%s",input);*/
+    /* with -hub stdout is for the protocol only, the start up goes to stderr */
+    for(i=1;i<argc;i++) if (strcmp(argv[i],"-hub")==0) hubmode=true;
+#ifndef _WIN32
+    if (hubmode==true) {
+        fflush(stdout);
+        out=dup(1);
+        dup2(2,1);
+    }
+#endif
     strcpy(pagefile,"tmp/mem64-%i-%i.page");
     dprint ("-->%s",input);
     allowTwoPlyIncrements=false;
@@ -262,15 +223,18 @@ int main(int argc,char* argv[])
             sscanf(argv[++i],"%i",&search_max);
             sscanf(argv[++i],"%f",&perc);
             parameters[0]=fitdepth;
-            if (asa==false) {
+            {
                 int score;
                 score=check_database(pdnfile,search_min,search_max);
                 dprint("score:%i\n",score);
             }
-            if (asa==true) {
-                parameters[0]=fitdepth;
-                /*asa_main();*/
-            }
+        }
+        if (strcmp(argv[i],"-tune")==0) {
+            int workers=1;
+            sscanf(argv[++i],"%s",pdnfile);
+            if (i+1<argc && argv[i+1][0]!='-') sscanf(argv[++i],"%i",&workers);
+            tune(pdnfile,workers);
+            exit(0);
         }
         if (strcmp(argv[i],"-pdn")==0) {
             sscanf(argv[++i],"%s",pdnfile);
@@ -280,14 +244,6 @@ int main(int argc,char* argv[])
             parameters[0]=-4;
             check_database(pdnfile,search_min,search_max);
         }
-        if  (strcmp(argv[i],"-asa")==0) {
-            asa=true;
-        }
-        if  (strcmp(argv[i],"-asa")==0) {
-            char name[256];
-            sscanf(argv[++i],"%i",name);
-            save_board(white,name);
-        }
         if  (strcmp(argv[i],"-x")==0) {
             /*Xboard(1,argv)*/;
         }
@@ -316,6 +272,22 @@ int main(int argc,char* argv[])
         if (strcmp(argv[i],"-windows")==0) {
             windows=true;
         }
+        if (strcmp(argv[i],"-serve")==0) {
+            sscanf(argv[++i],"%255s",servepath);
+            if (i+1<argc && argv[i+1][0]!='-') sscanf(argv[++i],"%i",&serveworkers);
+        }
+        if (strcmp(argv[i],"-sharehash")==0) {
+            sharehash=true;
+        }
+        if (strcmp(argv[i],"-dbshared")==0) {
+            db_shared=true;
+            if (i+1<argc && argv[i+1][0]!='-') sscanf(argv[++i],"%255s",db_shared_dir);
+        }
+        if (strcmp(argv[i],"-dbpublish")==0) {
+            if (i+1<argc && argv[i+1][0]!='-') sscanf(argv[++i],"%255s",db_shared_dir);
+            publish_databases();
+            exit(0);
+        }
         if (strcmp(argv[i],"-db")==0) {
             read_all_databases(40);
         }
@@ -327,16 +299,37 @@ int main(int argc,char* argv[])
         }
         i++;
     }
-    if (windows==true) {
+    if (windows==true || hubmode==true) {
         usecol=false;
     }
-    if (windows==false) {
+    if (windows==false && hubmode==false) {
         display_board();
     }
     if (windows==true) {
         printf("connecting to windows interface\n");
     } 
     read_all_databases(40);
+    if (servepath[0]!=0) {
+        serve_loop(servepath,serveworkers,sharehash);
+        save_db_history();
+        #ifdef MAPPEDMEMORY
+            mem64_exit();
+        #endif
+        return(0);
+    }
+    comm_init();
+    if (hubmode==true) {
+        fflush(stdout);
+#ifndef _WIN32
+        if (out>=0) dup2(out,1);
+#endif
+        hub_loop();
+        save_db_history();
+        #ifdef MAPPEDMEMORY
+            mem64_exit();
+        #endif
+        return(0);
+    }
 
     do {
         signal(SIGINT,stopprogram);
@@ -344,12 +337,7 @@ int main(int argc,char* argv[])
         printf("dragon> ");
         /*fflush(stdout);*/
         
-        if (windows==true) {
-            in=winGetFile();
-        } else {
-            in=stdin;
-        }
-        fscanf(in,"%s",input);
+        in=comm_getcommand(input);
         signal(SIGINT,SIG_DFL);
         if (input[0]=='!') system(&input[1]);
         else if (strcmp(input,"pn")==0) {
@@ -551,6 +539,10 @@ int main(int argc,char* argv[])
         else if (strcmp(input,"stats")==0) {
             print_stats();
         }
+        else if (strcmp(input,"evalhash")==0) {
+            fscanf(in,"%i",&in1);
+            dprint("eval cache: %i entries\n",setEvalHash(in1));
+        }
         else if (strcmp(input,"bd")==0) {
             display_board();
         }
@@ -662,6 +654,24 @@ int main(int argc,char* argv[])
             test_nr+=1;
             dprint("score:%.3f time:%.2f\n",score/1000.0F,(float) t/CLOCKS_PER_SEC);
         }
+        else if (strcmp(input,"bench")==0) {
+            fscanf(in,"%i",&in1);
+            bench(in1);
+        }
+        else if (strcmp(input,"pvs")==0) {
+            fscanf(in,"%i",&use_pvs);
+        }
+        else if (strcmp(input,"lmr")==0) {
+            fscanf(in,"%i",&use_lmr);
+        }
+        else if (strcmp(input,"shots")==0) {
+            fscanf(in,"%i",&use_shots);
+        }
+        else if (strcmp(input,"multipv")==0) {
+            fscanf(in,"%i",&multipv);
+            if (multipv<1) multipv=1;
+            if (multipv>MAXMULTIPV) multipv=MAXMULTIPV;
+        }
         else if (strcmp(input,"?")==0) {
             int n;
             n=move_list(0,0);
@@ -918,11 +928,23 @@ play_error:
                    dopv {n}                    do best known move\n\
                    ! {command}                 shell escape\n\
                    eval                        static evaluation\n\
+                   evalhash {Mb}               set eval cache size\n\
                    movescore                   show score of all moves\n\
                    kill {0,1,2,3}              set killer method\n\
                    bestfit\n\
                    bookmove                    try to do move from book\n\
                    test                        speed tests\n\
+                   bench {depth}               search the bench positions\n\
+                   pvs {boolean}               null window search\n\
+                   lmr {boolean}               late move reductions\n\
+                   shots {boolean}             tactical shot rules\n\
+                   multipv {lines}             report the best lines\n\
+                   stop                        end the running search\n\
+                   fen {fen}                   set up a PDN FEN position\n\
+                   engines {n}{seconds}        search with n engines at once\n\
+                   dxp {port}                  play DXP games as follower\n\
+                   dxpconnect {host}{port}{color}{minutes}{moves}\n\
+                                               play a DXP game as initiator\n\
                    get {file}                  load position\n\
                    quit                        quit\n\
                    pn {color}{nodes}{type}     do pn1 search\n\
@@ -1270,13 +1292,66 @@ end_xdomove:
             }
         }
         
-        else dprint("error\n");
-        if (windows==true && in!=NULL) {
-            fclose(in);
-            unlink("com/win.in2");
+        else if (strcmp(input,"stop")==0) {
+            /* only ends a running search */
+        }
+        else if (strcmp(input,"fen")==0) {
+            int color;
+            char fen[1024];
+            fscanf(in,"%1023s",fen);
+            color=set_board_fen(fen);
+            if (color<0) dprint("error\n");
+            else {
+                game_color=color;
+                init_history();
+                display_board();
+            }
         }
+        else if (strcmp(input,"engines")==0) {
+            /* n independent engines search the position at the same time */
+#ifndef USE_THREADS
+            /* without threads every engine is the program, it would lose the game */
+            dprint("engines: needs USE_THREADS\n");
+#else
+            tpDragon *engine[16];
+            char pos[52],move[MOVEL*4];
+            float secs;
+            int n,score;
+            fscanf(in,"%i %f",&in1,&secs);
+            if (in1<1) in1=1;
+            if (in1>16) in1=16;
+            get_board_string(pos,game_color);
+            for(n=0;n<in1;n++) {
+                engine[n]=dragon_new(0,NULL);
+                if (engine[n]==NULL) break;
+                dragon_set_position(engine[n],pos);
+                dragon_search_async(engine[n],secs,0,NULL,NULL);
+            }
+            in1=n;
+            for(n=0;n<in1;n++) {
+                score=dragon_wait(engine[n],move,NULL);
+                dprint("engine %i: %s %.2f\n",n,move,score/1000.0F);
+                dragon_free(engine[n]);
+            }
+#endif
+        }
+        else if (strcmp(input,"dxp")==0) {
+            fscanf(in,"%i",&in1);
+            dxp_listen(in1>0 ? in1 : DXPPORT);
+        }
+        else if (strcmp(input,"dxpaddr")==0) {
+            fscanf(in,"%39s",dxp_address);
+        }
+        else if (strcmp(input,"dxpconnect")==0) {
+            int minutes,moves;
+            fscanf(in,"%99s %i %i %i %i",buffer,&in1,&in2,&minutes,&moves);
+            dxp_connect(buffer,in1,in2,minutes,moves);
+        }
+        else dprint("error\n");
+        comm_donecommand(in);
         
     } while(strcmp(input,"quit")!=0 && strcmp(input,"q")!=0 && strcmp(input,"exit")!=0);
+    save_db_history();
     #ifdef MAPPEDMEMORY
         mem64_exit();
     #endif
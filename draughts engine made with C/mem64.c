@@ -20,11 +20,17 @@
 
 
 #include <stdio.h>
+#include <string.h>
 #include "const.h"
+#include "var.h"
+#include "functions.h"
 #include <time.h>
 #ifdef USE_ZLIB
     #include "/usr/include/zlib.h"
 #endif
+#ifdef USE_THREADS
+    #include <pthread.h>
+#endif
 
 #define PAGESIZE (1024LL*1024LL)        /* size of a page */
 #define MAXPAGES 1200LL        /* maximum number of pages in ram */
@@ -42,11 +48,56 @@ INT64 mem64_increment[MAXPAGES];  /* last time this page was accessed */
 int mem64_handle[MAXPAGES];     /* the handle associatied with this page */
 int mem64_hpage[MAXPAGES];      /* the pagenumber within handle=index/pagesize */
 int mem64_dirty[MAXPAGES];      /* page is dirty */
+volatile unsigned int mem64_seq[MAXPAGES];  /* odd while the page is (re)assigned, see mem64_read() */
 char pagefile[255];
 
 INT64 mem64_diskActivity=0LL;
 INT64 increment=0LL;
 
+#ifdef USE_THREADS
+pthread_mutex_t mem64_mutex=PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+#ifdef __GNUC__
+    #define MEM64_BARRIER() __sync_synchronize()
+#else
+    #define MEM64_BARRIER()
+#endif
+
+/* the LRU clock. With threads increment only advances on the locked paths
+   (MEM64_TOUCH); the lock-free hits of mem64_read stamp a page with the
+   current value (MEM64_STAMP), a plain load and a store only when the stamp
+   changes, so reading threads do not write a shared counter. Pages read
+   since the last page was loaded then share the newest stamp */
+#ifdef USE_THREADS
+    #define MEM64_TOUCH(page) __atomic_store_n(&mem64_increment[page],__atomic_fetch_add(&increment,1LL,__ATOMIC_RELAXED),__ATOMIC_RELAXED)
+    #define MEM64_STAMP(page) do { \
+        INT64 now_=__atomic_load_n(&increment,__ATOMIC_RELAXED); \
+        if (__atomic_load_n(&mem64_increment[page],__ATOMIC_RELAXED)!=now_) \
+            __atomic_store_n(&mem64_increment[page],now_,__ATOMIC_RELAXED); \
+    } while (0)
+    #define MEM64_AGE(page) __atomic_load_n(&mem64_increment[page],__ATOMIC_RELAXED)
+#else
+    #define MEM64_TOUCH(page) (mem64_increment[page]=(increment++))
+    #define MEM64_STAMP(page) MEM64_TOUCH(page)
+    #define MEM64_AGE(page) (mem64_increment[page])
+#endif
+
+void mem64_lock(void)
+/* serializes access to the page tables when databases are loaded in the background */
+{
+#ifdef USE_THREADS
+    pthread_mutex_lock(&mem64_mutex);
+#endif
+}
+
+void mem64_unlock(void)
+{
+#ifdef USE_THREADS
+    pthread_mutex_unlock(&mem64_mutex);
+#endif
+}
+
 
 void mem64_init(int showinfo)
 {
@@ -145,18 +196,60 @@ int mem64_allocate(INT64 amount)
         }
         
         /*printf("a%i %i %i %i\n",i,fp,mem64[fp],base[i]);*/
+        mem64_seq[fp]++;
+        MEM64_BARRIER();
         base[i]=mem64[fp];
         mem64_handle[fp]=handle;
         mem64_hpage[fp]=i;
-        mem64_increment[fp]=(increment++);
+        MEM64_TOUCH(fp);
         mem64_dirty[fp]=true;
         numbers[i]=fp;
+        MEM64_BARRIER();
+        mem64_seq[fp]++;
     }
     /*printf("sadfdf\n");*/
         
     return (handle);
 }
 
+int mem64_attach(char *memory,INT64 amount)
+/* returns a mem64 handle for memory that is owned by the caller, for instance a
+   shared mapping. Its pages do not use the page pool: they are never evicted
+   or written to disk. if handle<0 there are no free handles */
+{
+    INT64 pages;
+    int handle;
+    int i;
+    void **base;
+    int *numbers;
+
+    handle=-1;
+    for(i=0;i<MAXHANDLE;i++) {
+        if (mem64_allocatedAmount[i]==0LL) {
+            handle=i;
+            break;
+        }
+    }
+    if (handle<0) return(handle);
+
+    pages=(amount+PAGESIZE-1)/PAGESIZE;
+    base=(void *)malloc(pages*sizeof(char *));
+    numbers=(int *)malloc(pages*sizeof(int *));
+    if (base==NULL || numbers==NULL) {
+        printf("Fatal: malloc failure on _base_\n");
+        exit(1);
+    }
+    mem64_allocatedAmount[handle]=amount;
+    mem64_pointerList[handle]=base;
+    mem64_pageNumber[handle]=numbers;
+    mem64_numberOfPages[handle]=pages;
+    for(i=0;i<pages;i++) {
+        base[i]=memory+i*PAGESIZE;
+        numbers[i]=-1;
+    }
+    return (handle);
+}
+
 int mem64_getFreePage()
 {
     int i;
@@ -171,8 +264,8 @@ int mem64_getFreePage()
             fp=i;
             break;
         }
-        if (mem64_increment[i]<oldestPage) {
-            oldestPage=mem64_increment[i];
+        if (MEM64_AGE(i)<oldestPage) {
+            oldestPage=MEM64_AGE(i);
             oldest=i;
         }
     }
@@ -227,12 +320,16 @@ writePage(int page)
         /*for (j=0;j<PAGESIZE;j++) printf("%i",mem64[page][j]);*/
     /*printf("\n");*/
     /* mark page as unused */
+    mem64_seq[page]++;
+    MEM64_BARRIER();
     base=mem64_pointerList[handle];
     base[hpage]=0;
     mem64_pageNumber[handle][hpage]=-1;
     mem64_handle[page]=-1;
     mem64_hpage[page]=-1;
     mem64_dirty[page]=false;
+    MEM64_BARRIER();
+    mem64_seq[page]++;
 }
 
 loadPage(int page,int handle,int hpage)
@@ -243,6 +340,8 @@ loadPage(int page,int handle,int hpage)
     gzFile zin;
     int amountread;
     
+    mem64_seq[page]++;
+    MEM64_BARRIER();
     /* save page to disk */
     /*printf("loading page %i, handle %i/%i\n",page,handle,hpage);*/
     sprintf(pg,pagefile,handle,hpage);
@@ -274,8 +373,10 @@ loadPage(int page,int handle,int hpage)
     mem64_pageNumber[handle][hpage]=page;
     mem64_handle[page]=handle;
     mem64_hpage[page]=hpage;
-    mem64_increment[page]=(increment++);
+    MEM64_TOUCH(page);
     mem64_dirty[page]=false;
+    MEM64_BARRIER();
+    mem64_seq[page]++;
 }
 
 void decompressGZfile(char *fIn,char *fOut)
@@ -338,7 +439,8 @@ char *mem64_pointer(int handle,INT64 index,int markAsDirty)
         memBlock=mem64[fp];
     }
     page=mem64_pageNumber[handle][hpage];
-    mem64_increment[page]=(increment++);
+    if (page<0) return (memBlock+index%PAGESIZE);  /* attached memory, see mem64_attach() */
+    MEM64_TOUCH(page);
     if (markAsDirty==true) {
         mem64_dirty[page]=true;
     }
@@ -346,6 +448,78 @@ char *mem64_pointer(int handle,INT64 index,int markAsDirty)
     return (memBlock+index%PAGESIZE);
 }
 
+void mem64_touch(int handle,INT64 size)
+/* writes every 256th of the first size bytes of handle, which puts its pages
+   in ram. The lock is taken per page, so readers are not held up meanwhile */
+{
+    INT64 i,j;
+    char *p;
+
+    for(i=0;i<size;i+=PAGESIZE) {
+        mem64_lock();
+        p=mem64_pointer(handle,i,true);
+        for(j=0;j<PAGESIZE && i+j<size;j+=256) p[j]=0;
+        mem64_unlock();
+    }
+}
+
+int mem64_read(int handle,INT64 index)
+/* returns the byte at 'index', like *mem64_pointer(handle,index,false), but may be
+   called from several threads at once. Resident pages are read without locking:
+   the page sequence number tells if the page was evicted or reassigned during
+   the read, in which case the read is retried on the locked (slow) path that
+   loads the page. */
+{
+    INT64 hpage;
+    char *memBlock;
+    void **base;
+    int page;
+    unsigned int seq;
+    int value;
+
+    hpage=index/PAGESIZE;
+    base=mem64_pointerList[handle];
+    memBlock=((char * volatile *) base)[hpage];
+    if (memBlock!=0) {
+        page=((volatile int *) mem64_pageNumber[handle])[hpage];
+        if (page<0) return((unsigned char) memBlock[index%PAGESIZE]);  /* attached memory never moves */
+        seq=mem64_seq[page];
+        MEM64_BARRIER();
+        if ((seq&1)==0 && mem64_handle[page]==handle && mem64_hpage[page]==hpage && mem64[page]==memBlock) {
+            value=(unsigned char) memBlock[index%PAGESIZE];
+            MEM64_BARRIER();
+            if (mem64_seq[page]==seq) {
+                MEM64_STAMP(page);
+                return(value);
+            }
+        }
+    }
+    mem64_lock();
+    value=(unsigned char) *mem64_pointer(handle,index,false);
+    mem64_unlock();
+    return(value);
+}
+
+void mem64_prefetch(int handle,INT64 index)
+/* asks the cpu to fetch the cache line holding 'index'. Only pages that are in ram
+   are touched: nothing is loaded from disk and the LRU order is left alone, so this
+   is cheap enough to call for a whole batch of probes before reading them */
+{
+    void **base;
+    char *memBlock;
+    INT64 hpage;
+
+    if (handle>=MAXHANDLE || handle<0 || index<0) return;
+    hpage=index/PAGESIZE;
+    if (hpage>=mem64_numberOfPages[handle]) return;
+    base=mem64_pointerList[handle];
+    memBlock=base[hpage];
+    if (memBlock==0) return;
+#ifdef __GNUC__
+    __builtin_prefetch(memBlock+index%PAGESIZE,0,1);
+#endif
+}
+
 mem64_free(int handle)
 {
     return;
@@ -423,13 +597,60 @@ mem64_save(int handle,char *filename)
     mem64_diskActivity+=mem64_allocatedAmount[handle];
 }
 
+INT64 mem64_loadRaw(char *memory,INT64 amount,char *filename)
+/* reads a (possibly split) database file into a flat block of memory.
+   returns the number of bytes read */
+{
+    INT64 index=0;
+    int i;
+    char fname[256];
+    int amountread;
+    int chunk;
+#ifdef USE_ZLIB
+    gzFile in;
+#else
+    FILE *in;
+#endif
+
+    for(i=0;index<amount;i++) {
+        if (i==0) sprintf(fname,"%s",filename);
+        if (i>0) sprintf(fname,"%s-%i",filename,i);
+        #ifdef USE_ZLIB
+            in = gzopen(fname, "rb");
+        #else
+            in = fopen(fname, "rb");
+        #endif
+        if (in == NULL) break;
+        do {
+            chunk=PAGESIZE;
+            if (chunk>amount-index) chunk=amount-index;
+            #ifdef USE_ZLIB
+                amountread = gzread(in, memory+index, chunk);
+            #else
+                amountread = fread(memory+index,1,chunk,in);
+            #endif
+            if (amountread>0) index+=amountread;
+        } while(amountread>0 && index<amount);
+        #ifdef USE_ZLIB
+            gzclose(in);
+        #else
+            fclose(in);
+        #endif
+    }
+    mem64_diskActivity+=index;
+    return(index);
+}
+
 int mem64_load(int handle,char *filename)
-/* returns true on success */
+/* returns true on success. The file is read into a private buffer first and
+   copied into the pages under the mem64 lock, so probes of other databases are
+   not held up by the (slow) decompression */
 {
     FILE *fhandle;
     INT64 index=0;
     char *p;
-    int i,j;
+    char *buffer;
+    int i,j,k,chunk;
     char fname[256];
     int amountread=0;
 #ifdef USE_ZLIB
@@ -437,6 +658,11 @@ int mem64_load(int handle,char *filename)
     int len;
 #endif
     
+    buffer=(char *) malloc(PAGESIZE);
+    if (buffer==NULL) {
+        printf("Fatal: malloc failure on _buffer_\n");
+        exit(1);
+    }
     for(i=0;true;i++) {
         fhandle=0;
         #ifdef USE_ZLIB
@@ -451,15 +677,23 @@ int mem64_load(int handle,char *filename)
             if (fhandle==NULL)  break;
         #endif
         for (j=0;true;j++) {
-            p=mem64_pointer(handle,index,true);
             #ifdef USE_ZLIB
-                amountread = gzread(in, p, sizeof(unsigned char)*PAGESIZE);
+                amountread = gzread(in, buffer, sizeof(unsigned char)*PAGESIZE);
             #else
-                amountread = fread(p,sizeof(unsigned char),PAGESIZE,fhandle);
+                amountread = fread(buffer,sizeof(unsigned char),PAGESIZE,fhandle);
             #endif
-            index+=amountread;
+            if (amountread<=0) break;
+            mem64_lock();
+            for (k=0;k<amountread;k+=chunk) {
+                /* a chunk may straddle a page boundary after a short read */
+                chunk=PAGESIZE-(index+k)%PAGESIZE;
+                if (chunk>amountread-k) chunk=amountread-k;
+                p=mem64_pointer(handle,index+k,true);
+                memcpy(p,buffer+k,chunk);
+            }
             mem64_diskActivity+=amountread;
-            if (amountread==0) break;
+            mem64_unlock();
+            index+=amountread;
         }
         #ifdef USE_ZLIB
             if (gzclose(in) != Z_OK) printf("failed gzclose");
@@ -467,6 +701,7 @@ int mem64_load(int handle,char *filename)
             fclose(fhandle);
         #endif
     }
+    free(buffer);
     if (index==0) {
         printf("load failure on %s\n",filename);
         return(false);
@@ -474,7 +709,7 @@ int mem64_load(int handle,char *filename)
     return(true);
 }
     
-mem64_test()
+void mem64_test()
 {
     int mem64id1,mem64id2;
     char *p;
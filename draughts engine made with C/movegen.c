@@ -16,379 +16,32 @@
 
 #include "var.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 /* movegen globals */
-int capture;
-int Indx;
-int mg_level;
-int mg_color;
-int mg_eneman;
-int mg_enecrown;
-int mg_owncrown;
-int mg_ownman;
-
-char capture_path[48];
-
-void mancapture(int p,int depth,int d)
-{
-    int cap=false;
-    int dir,np,nnp;
-
-    for(dir=0;dir<4;dir++) if (dir!=(d^2)) {
-            np=next[mg_color][p][dir];
-            if (board[np]==mg_eneman || board[np]==mg_enecrown) {
-                nnp=next[mg_color][np][dir];
-                if (board[nnp]==empty) {
-                    cap=true;
-                    capture_path[depth]=np;
-                    capture_path[depth+1]=board[np];
-                    capture_path[depth+2]=nnp;
-                    board[np]|=taken;
-                    mancapture(nnp,depth+3,dir);
-                    board[np]-=taken;
-                }
-            }
-        }
-
-    if (cap==false && depth>3) { /* at least one capture */
-        int i;
-
-        if (depth>capture) {capture=depth; Indx=0;}
-        if (depth>=capture) {
-            for(i=1;i<depth;i++) movelist[mg_level][Indx][i]=capture_path[i];
-            movelist[mg_level][Indx][depth]=promote[mg_color][capture_path[depth-1]];
-            movelist[mg_level][Indx][0]=depth;
-            Indx++;
-        }
-    }
-}
-
-void mancapture_wnc(int p,int depth)
-{
-    int cap=false;
-
-    if (board[p-7]==(black|man)) {
-        if (board[p-14]==empty) {
-            cap=true;
-            capture_path[depth]=p-7;
-            capture_path[depth+1]=black|man;
-            capture_path[depth+2]=p-14;
-            board[p-7]|=taken;
-            mancapture_wnc(p-14,depth+3);
-            board[p-7]-=taken;
-        }
-    }
-    if (board[p-6]==(black|man)) {
-        if (board[p-12]==empty) {
-            cap=true;
-            capture_path[depth]=p-6;
-            capture_path[depth+1]=black|man;
-            capture_path[depth+2]=p-12;
-            board[p-6]|=taken;
-            mancapture_wnc(p-12,depth+3);
-            board[p-6]-=taken;
-        }
-    }
-    if (board[p+7]==(black|man)) {
-        if (board[p+14]==empty) {
-            cap=true;
-            capture_path[depth]=p+7;
-            capture_path[depth+1]=black|man;
-            capture_path[depth+2]=p+14;
-            board[p+7]|=taken;
-            mancapture_wnc(p+14,depth+3);
-            board[p+7]-=taken;
-        }
-    }
-    if (board[p+6]==(black|man)) {
-        if (board[p+12]==empty) {
-            cap=true;
-            capture_path[depth]=p+6;
-            capture_path[depth+1]=black|man;
-            capture_path[depth+2]=p+12;
-            board[p+6]|=taken;
-            mancapture_wnc(p+12,depth+3);
-            board[p+6]-=taken;
-        }
-    }
-    if (cap==false && depth>3) { /* at least one capture */
-        int i;
-        if (depth>capture) {capture=depth; Indx=0;}
-        if (depth>=capture) {
-            for(i=1;i<depth;i++) movelist[mg_level][Indx][i]=capture_path[i];
-            movelist[mg_level][Indx][depth]=promote[white][capture_path[depth-1]];
-            movelist[mg_level][Indx][0]=depth;
-            Indx++;
-        }
-    }
-}
-
-void mancapture_bnc(int p,int depth)
-{
-    int cap=false;
-    if (board[p+7]==(white|man)) {
-        if (board[p+14]==empty) {
-            cap=true;
-            capture_path[depth]=p+7;
-            capture_path[depth+1]=white|man;
-            capture_path[depth+2]=p+14;
-            board[p+7]|=taken;
-            mancapture_bnc(p+14,depth+3);
-            board[p+7]-=taken;
-        }
-    }
-    if (board[p+6]==(white|man)) {
-        if (board[p+12]==empty) {
-            cap=true;
-            capture_path[depth]=p+6;
-            capture_path[depth+1]=white|man;
-            capture_path[depth+2]=p+12;
-            board[p+6]|=taken;
-            mancapture_bnc(p+12,depth+3);
-            board[p+6]-=taken;
-        }
-    }
-    if (board[p-7]==(white|man)) {
-        if (board[p-14]==empty) {
-            cap=true;
-            capture_path[depth]=p-7;
-            capture_path[depth+1]=white|man;
-            capture_path[depth+2]=p-14;
-            board[p-7]|=taken;
-            mancapture_bnc(p-14,depth+3);
-            board[p-7]-=taken;
-        }
-    }
-    if (board[p-6]==(white|man)) {
-        if (board[p-12]==empty) {
-            cap=true;
-            capture_path[depth]=p-6;
-            capture_path[depth+1]=white|man;
-            capture_path[depth+2]=p-12;
-            board[p-6]|=taken;
-            mancapture_bnc(p-12,depth+3);
-            board[p-6]-=taken;
-        }
-    }
-    if (cap==false && depth>3) { /* at least one capture */
-        int i;
-
-        if (depth>capture) {capture=depth; Indx=0;}
-        if (depth>=capture) {
-            for(i=1;i<depth;i++) movelist[mg_level][Indx][i]=capture_path[i];
-            movelist[mg_level][Indx][depth]=promote[black][capture_path[depth-1]];
-            movelist[mg_level][Indx][0]=depth;
-            Indx++;
-        }
-    }
-}
-
-void crowncapture(int pp,int olddir,int depth)
-{
-    int left,right,i;
-    int dd,dir,cap,p,np;
-    int piece[5],cp[5];
-    int findcap=false;
-
-    left=olddir-1; if (left<0) left+=4;
-    right=(olddir+1)%4;
-
-    for(dd=0;dd<2;dd++) {
-        dir=(dd==0)?left:right;
-        cap=0; p=pp;
-        do {
-            p=next[mg_color][p][dir];
-            if (board[p]==empty) {
-                for(i=0;i<cap;i++) {
-                    capture_path[depth+3*i]=cp[i];
-                    capture_path[depth+3*i+1]=piece[i];
-                    capture_path[depth+3*i+2]=p;
-                }
-                if (cap>0) {crowncapture(p,dir,depth+3*cap);}
-                continue;
-            } else if (board[p]==mg_eneman || board[p]==mg_enecrown) {
-                np=next[mg_color][p][dir];
-                if (board[np]==empty) {
-                    cp[cap]=p;
-                    piece[cap]=board[p];
-                    board[p]|=taken;
-                    cap++;
-                    findcap=true;
-                }
-                else break;
-            } else {
-                break;
-            }
-        } while(true);
-        for(i=0;i<cap;i++) board[cp[i]]=piece[i];
-    }
-    
-    if (findcap==false && depth>=capture) {
-        if (depth>capture) {capture=depth; Indx=0;}
-        for(i=1;i<depth;i++) movelist[mg_level][Indx][i]=capture_path[i];
-        movelist[mg_level][Indx][depth]=mg_owncrown;
-        movelist[mg_level][Indx][0]=depth;
-        Indx++;
-    }
-    return;
-}
-
-int crownmove(int pp)
-{
-    int cap;
-    int dir,np;
-    int i,p;
-    int cp[5],piece[5];
-    /* if dir is given:
-          find hit or do move in dir
-       if dir not given:
-          for all hits crownmove
-          do moves
-    */
-    board[pp]=empty;
-    for(dir=0;dir<4;dir++) {
-        p=pp; cap=0;
-        do {
-            p=next[mg_color][p][dir];
-            if (p==invalid || board[p]==mg_ownman || board[p]==mg_owncrown) break;
-            if (board[p]==empty) {
-                if (cap>0) {
-                    capture_path[1]=pp;
-                    capture_path[2]=mg_owncrown;
-                    for(i=0;i<cap;i++) {
-                        capture_path[3+3*i]=cp[i];
-                        capture_path[3+3*i+1]=piece[i];
-                        capture_path[3+3*i+2]=p;
-                    }
-
-                    crowncapture(p,dir,3+3*cap);
-                }
-                else if (capture==0) {
-                    movelist[mg_level][Indx][0]=4;
-                    movelist[mg_level][Indx][1]=pp;
-                    movelist[mg_level][Indx][2]=mg_owncrown;
-                    movelist[mg_level][Indx][3]=p;
-                    movelist[mg_level][Indx][4]=mg_owncrown;
-                    Indx++;
-                    continue;
-                }
-            }
-            if (board[p]==mg_eneman || board[p]==mg_enecrown) {
-                np=next[mg_color][p][dir];
-                if (board[np]==empty) {
-                    cp[cap]=p;
-                    piece[cap]=board[p];
-                    board[p]|=taken;
-                    cap++;
-                }
-                else break;
-            }
-        } while(true);
-        for(i=0;i<cap;i++) board[cp[i]]=piece[i];
-    }
-    board[pp]=mg_owncrown;
-    return(0);
-}
-
-int move_list_wnc(int level)
-{
-    int ip,p;
-    capture=0;
-    mg_level=level;
-
-    Indx=0;
-    for(ip=5;ip!=50;ip++) {
-        p=map[ip];
-        if (board[p] == (white|man)) {
-            /* capture moves */
-            if (board[p-6]==(black|man) || board[p-7]==(black|man) ||
-                    board[p+7]==(black|man) || board[p+6]==(black|man)) {
-                board[p]=empty;
-                capture_path[1]=p; capture_path[2]=(white|man);
-                mancapture_wnc(p,3);
-                board[p]=white|man;
-            }
-            if (capture==0) { /* non capture man moves */
-                if (board[p-7]==empty) {
-                    movelist[level][Indx][0]=4;
-                    movelist[level][Indx][1]=p;
-                    movelist[level][Indx][2]=white|man;
-                    movelist[level][Indx][3]=p-7;
-                    movelist[level][Indx][4]=promote[white][p-7];
-                    Indx++;
-                }
-                if (board[p-6]==empty) {
-                    movelist[level][Indx][0]=4;
-                    movelist[level][Indx][1]=p;
-                    movelist[level][Indx][2]=white|man;
-                    movelist[level][Indx][3]=p-6;
-                    movelist[level][Indx][4]=promote[white][p-6];
-                    Indx++;
-                }
-            } /* end if capture */
-        } /* end if ownman */
-    } /* end for board */
-    ngen+=Indx;
-    if (Indx>=MAXNM) {
-        set_col(31,31);printf("error: too many moves\n");res_col();
-        display_board();
-        Indx=MAXNM-1;
-    }
-    return(Indx);
-}
-
-int move_list_bnc(int level)
-{
-    int ip,p;
-    capture=0;
-    mg_level=level;
-
-    Indx=0;
-    for(ip=44;ip!=-1;ip--) {
-        p=map[ip];
-        if (board[p] == (black|man)) {
-            /* capture moves */
-            if (board[p-6]==(white|man) || board[p-7]==(white|man) ||
-                    board[p+7]==(white|man) || board[p+6]==(white|man)) {
-                board[p]=empty;
-                capture_path[1]=p; capture_path[2]=(black|man);
-                mancapture_bnc(p,3);board[p]=black|man;
-            }
-            if (capture==0) { /* non capture man moves */
-                if (board[p+7]==empty) {
-                    movelist[level][Indx][0]=4;
-                    movelist[level][Indx][1]=p;
-                    movelist[level][Indx][2]=black|man;
-                    movelist[level][Indx][3]=p+7;
-                    movelist[level][Indx][4]=promote[black][p+7];
-                    Indx++;
-                }
-                if (board[p+6]==empty) {
-                    movelist[level][Indx][0]=4;
-                    movelist[level][Indx][1]=p;
-                    movelist[level][Indx][2]=black|man;
-                    movelist[level][Indx][3]=p+6;
-                    movelist[level][Indx][4]=promote[black][p+6];
-                    Indx++;
-                }
-            } /* end if capture */
-        } /* end if ownman */
-    } /* end for board */
-    ngen+=Indx;
-    if (Indx>=MAXNM) {
-        set_col(31,31);printf("error: too many moves\n");res_col();
-        display_board();
-        Indx=MAXNM-1;
-    }
-    return(Indx);
-}
+LOCAL int capture;
+LOCAL int Indx;
+LOCAL int mg_level;
+LOCAL int mg_color;
+LOCAL int mg_eneman;
+LOCAL int mg_enecrown;
+LOCAL int mg_owncrown;
+LOCAL int mg_ownman;
+
+LOCAL char capture_path[48];
+
+/* the colour kernels */
+#define COL white
+#include "movegen_color.h"
+#undef COL
+#define COL black
+#include "movegen_color.h"
+#undef COL
 
 int move_list(int level,int color)
 {
-    int ip,p;
-    int p1,p2,dir,ehc=false;
-    int ownman,owncrown,eneman,enecrown;
-    int fl,fr,bl,br;
+    int n;
 
     if (level>=MAXPLY) {
         set_col(31,31);printf("error: too deep\n");res_col();
@@ -397,90 +50,28 @@ int move_list(int level,int color)
     }
     nmovelist++;
     if (pieces[white|crown]==0 && pieces[black|crown]==0) {
-        if (color==white) return(move_list_wnc(level));
-        if (color==black) return(move_list_bnc(level));
+        if (color==white) n=move_list_wnc(level);
+        else n=move_list_bnc(level);
     }
-    /* general routine */
-    ownman=man | color;
-    owncrown=crown | color;
-    eneman=man |! color;
-    enecrown=crown |! color;
-    capture=0;
-    mg_level=level;
-    mg_color=color;
-    mg_eneman=eneman;
-    mg_enecrown=enecrown;
-    mg_owncrown=owncrown;
-    mg_ownman=ownman;
-
-    if ((color==white && pieces[black|crown]!=0) || (color==black && pieces[white|crown]!=0)) ehc=true;
-    Indx=0;
-
-if (color==white) {p1=0; p2=50; dir=1;fl=-7; fr=-6; bl=+6;br=+7;}
-    else {p1=49; p2=-1; dir=-1;fl=+7; fr=+6; bl=-6; br=-7;}
-
-    for(ip=p1;ip!=p2;ip+=dir) {
-        p=map[ip];
-        if (board[p] == ownman) {
-
-            /* capture moves */
-            if (color==white) {
-                if (board[p-6]==eneman || board[p-7]==eneman ||
-                        board[p+7]==eneman || board[p+6]==eneman) {
-                    capture_path[1]=p; capture_path[2]=ownman;
-                    board[p]=empty;
-                    mancapture(p,3,-1);
-                    board[p]=ownman;
-                    goto scipcr;
-                }
-            }
-            else if (board[p+6]==eneman || board[p+7]==eneman ||
-                     board[p-7]==eneman || board[p-6]==eneman) {
-                capture_path[1]=p; capture_path[2]=ownman;
-                board[p]=empty;
-                mancapture(p,3,-1);
-                board[p]=ownman;
-                goto scipcr;
-            }
-            if (ehc==true) if (board[next[color][p][forright]]==enecrown ||
-                                   board[next[color][p][forleft]]==enecrown ||
-                                   board[next[color][p][backright]]==enecrown ||
-                                   board[next[color][p][backleft]]==enecrown) {
-                    capture_path[1]=p; capture_path[2]=ownman;
-                    board[p]=empty;
-                    mancapture(p,3,-1);
-                    board[p]=ownman;
-                }
-scipcr:
-            if (capture==0) { /* non capture man moves */
-                if (board[p+fl]==empty) {
-                    movelist[level][Indx][0]=4;
-                    movelist[level][Indx][1]=p;
-                    movelist[level][Indx][2]=board[p];
-                    movelist[level][Indx][3]=p+fl;
-                    movelist[level][Indx][4]=promote[color][p+fl];
-                    Indx++;
-                }
-                if (board[p+fr]==empty) {
-                    movelist[level][Indx][0]=4;
-                    movelist[level][Indx][1]=p;
-                    movelist[level][Indx][2]=board[p];
-                    movelist[level][Indx][3]=p+fr;
-                    movelist[level][Indx][4]=promote[color][p+fr];
-                    Indx++;
-                }
-            } /* end if capture */
-        } /* end if ownman */
-        /* crown moves */
-        else if (board[p] == owncrown) crownmove(p);
-    } /* end for board */
-    ngen+=Indx;
-    if (Indx>=MAXNM) {
+    else {
+        if (color==white) n=move_list_w(level);
+        else n=move_list_b(level);
+    }
+    ngen+=n;
+    if (n>=MAXNM) {
         set_col(31,31);printf("error: too many moves\n");res_col();
         display_board();
-        Indx=MAXNM-1;
+        Indx=n=MAXNM-1;
     }
-    return(Indx);
+    return(n);
+}
+
+int quiet(int color)
+/* returns false if color can capture, true otherwise */
+{
+    nquiet++;
+    if (color==white) return(w_quiet());
+    else return(b_quiet());
 }
 
 void xprint_move(char *move)
@@ -584,6 +175,82 @@ void sprint_move(char *out,char *move)
     }
 }
 
+void sprint_move_hub(char *out,char *move)
+/* hub notation: from-to, or fromxto followed by xN for every captured piece */
+{
+    int j,m,p;
+
+    m=move[0];
+    out[0]=0;
+    if (m==0) return;
+    if (m==4) sprintf(out,"%i-%i",invmap[(int) move[1]]+1,invmap[(int) move[3]]+1);
+    else {
+        p=sprintf(out,"%ix%i",invmap[(int) move[1]]+1,invmap[(int) move[m-1]]+1);
+        for(j=3;j<m-2;j+=3) p+=sprintf(&out[p],"x%i",invmap[(int) move[j]]+1);
+    }
+}
+
+void sprint_pv_hub(char *out,char pv[MPV][MOVEL])
+/* a line like PV[0] in hub notation, moves separated by spaces.
+   out holds MPV*MOVEL*4 characters */
+{
+    int i,p=0;
+
+    out[0]=0;
+    for(i=0;i<maxpv && i<MPV && pv[i][0]!=0;i++) {
+        if (i>0) out[p++]=' ';
+        sprint_move_hub(&out[p],pv[i]);
+        p+=strlen(&out[p]);
+    }
+}
+
+int find_move_squares(int level,int nmoves,int *sq,int nsq)
+/* the movelist[level] index of the move given as the field numbers from,
+   to and some of its captured pieces (hub and DXP), or of the capture
+   given as its path from, via..., to (PDN). -1 if no move fits, the first
+   one if several fit */
+{
+    int nr,i,j,m,found;
+    char *move;
+
+    if (nsq<2) return(-1);
+    for(nr=0;nr<nmoves;nr++) {
+        move=movelist[level][nr];
+        m=move[0];
+        if (invmap[(int) move[1]]+1!=sq[0] || invmap[(int) move[m-1]]+1!=sq[1]) continue;
+        for(i=2;i<nsq;i++) {
+            found=false;
+            for(j=3;j<m-2;j+=3) if (invmap[(int) move[j]]+1==sq[i]) found=true;
+            if (found==false) break;
+        }
+        if (i==nsq) return(nr);
+    }
+    for(nr=0;nr<nmoves;nr++) {
+        move=movelist[level][nr];
+        m=move[0];
+        if (m==4 || (m-3)/3!=nsq-1 || invmap[(int) move[1]]+1!=sq[0]) continue;
+        for(i=1;i<nsq;i++) if (invmap[(int) move[3*i+2]]+1!=sq[i]) break;
+        if (i==nsq) return(nr);
+    }
+    return(-1);
+}
+
+int parse_move(int level,int nmoves,char *text)
+/* the movelist[level] index of a move written as 32-28, 28x19x23 (hub)
+   or 28x19x10 (PDN path), -1 if it is not a legal move */
+{
+    int sq[MOVEL],nsq=0,n;
+
+    while (*text!=0 && nsq<MOVEL) {
+        if (*text>='0' && *text<='9' && sscanf(text,"%d%n",&sq[nsq],&n)==1) {
+            nsq++;
+            text+=n;
+        }
+        else text++;
+    }
+    return(find_move_squares(level,nmoves,sq,nsq));
+}
+
 void win_print_move(char *move)
 {
     char movebuffer[128];
@@ -617,6 +284,23 @@ void print_movelist(int level,int n)
     dprint("\n");
 }
 
+/* add (s=1) or remove (s=-1) piece q on field p from the square-table sums */
+#define PSQ(p,q,s) { short *t=psq_tab[(int)(q)][(int)(p)]; int c=(q)&1; \
+    psq_eval[c]+=(s)*t[0]; psq_center[c]+=(s)*t[1]; psq_wing[c][t[2]]+=(s); psq_tempo[c]+=(s)*t[3]; \
+    man_key^=man_rnd[(int)(q)][(int)(p)]; man_bits[c]^=man_bit[(int)(q)][(int)(p)]; \
+    pos_key^=pos_rnd[(int)(q)][(int)(p)]; }
+
+void set_field(int p,int q)
+/* puts piece q (or empty) on field p, keeping pieces[] and the sums in step */
+{
+    int o=board[p];
+
+    if (o==q) return;
+    if (o!=empty) {pieces[o]--; PSQ(p,o,-1);}
+    if (q!=empty) {pieces[q]++; PSQ(p,q,1);}
+    board[p]=q;
+}
+
 void do_move(char *move)
 {
     int i,length;
@@ -626,10 +310,13 @@ void do_move(char *move)
     pieces[move[2]]--; pieces[move[length]]++;
     board[move[1]]=empty;
     board[move[length-1]]=move[length];
+    PSQ(move[1],move[2],-1);
+    PSQ(move[length-1],move[length],1);
 
     for(i=3;i<length-1;i+=3) {
         pieces[move[i+1]]--;
         board[move[i]]=empty;
+        PSQ(move[i],move[i+1],-1);
     }
     return;
 }
@@ -642,10 +329,13 @@ void undo_move(char *move)
     pieces[move[2]]++; pieces[move[length]]--;
     board[move[length-1]]=empty;
     board[move[1]]=move[2];
+    PSQ(move[length-1],move[length],-1);
+    PSQ(move[1],move[2],1);
 
     for(i=3;i<length-1;i+=3) {
         pieces[move[i+1]]++;
         board[move[i]]=move[i+1];
+        PSQ(move[i],move[i+1],1);
     }
     return;
 }
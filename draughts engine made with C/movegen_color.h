@@ -0,0 +1,404 @@
+/*
+ * Copyright 1996 by Michel D. Grimminck
+ *
+ * All Rights Reserved
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright notice appear in all copies and that
+ * both that copyright notice and this permission notice appear in
+ * supporting documentation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/* move generation and capture tests for one colour. movegen.c includes
+   this file once with COL defined as white and once as black, so both
+   colours get code with the piece values and direction offsets as
+   constants. WB(w,b) picks the white or the black spelling of a name.
+
+   The offsets follow next[COL][p][dir]: a field off the board is a padding
+   field holding invalid, so p+offset never needs the next[] lookup */
+
+#if COL==white
+#define WB(w,b) w
+#define ENE black
+#define FL (-7)
+#define FR (-6)
+#define BR (+7)
+#define BL (+6)
+#else
+#define WB(w,b) b
+#define ENE white
+#define FL (+7)
+#define FR (+6)
+#define BR (-7)
+#define BL (-6)
+#endif
+
+/* forleft, forright, backright, backleft */
+static const signed char WB(off_w,off_b)[4]={FL,FR,BR,BL};
+#define OFF WB(off_w,off_b)
+
+static void WB(mancapture_wnc,mancapture_bnc)(int p,int depth)
+/* man captures when there are no crowns on the board */
+{
+    int cap=false;
+
+    if (board[p+FL]==(ENE|man)) {
+        if (board[p+2*FL]==empty) {
+            cap=true;
+            capture_path[depth]=p+FL;
+            capture_path[depth+1]=ENE|man;
+            capture_path[depth+2]=p+2*FL;
+            board[p+FL]|=taken;
+            WB(mancapture_wnc,mancapture_bnc)(p+2*FL,depth+3);
+            board[p+FL]-=taken;
+        }
+    }
+    if (board[p+FR]==(ENE|man)) {
+        if (board[p+2*FR]==empty) {
+            cap=true;
+            capture_path[depth]=p+FR;
+            capture_path[depth+1]=ENE|man;
+            capture_path[depth+2]=p+2*FR;
+            board[p+FR]|=taken;
+            WB(mancapture_wnc,mancapture_bnc)(p+2*FR,depth+3);
+            board[p+FR]-=taken;
+        }
+    }
+    if (board[p+BR]==(ENE|man)) {
+        if (board[p+2*BR]==empty) {
+            cap=true;
+            capture_path[depth]=p+BR;
+            capture_path[depth+1]=ENE|man;
+            capture_path[depth+2]=p+2*BR;
+            board[p+BR]|=taken;
+            WB(mancapture_wnc,mancapture_bnc)(p+2*BR,depth+3);
+            board[p+BR]-=taken;
+        }
+    }
+    if (board[p+BL]==(ENE|man)) {
+        if (board[p+2*BL]==empty) {
+            cap=true;
+            capture_path[depth]=p+BL;
+            capture_path[depth+1]=ENE|man;
+            capture_path[depth+2]=p+2*BL;
+            board[p+BL]|=taken;
+            WB(mancapture_wnc,mancapture_bnc)(p+2*BL,depth+3);
+            board[p+BL]-=taken;
+        }
+    }
+    if (cap==false && depth>3) { /* at least one capture */
+        int i;
+
+        if (depth>capture) {capture=depth; Indx=0;}
+        if (depth>=capture) {
+            for(i=1;i<depth;i++) movelist[mg_level][Indx][i]=capture_path[i];
+            movelist[mg_level][Indx][depth]=promote[COL][capture_path[depth-1]];
+            movelist[mg_level][Indx][0]=depth;
+            Indx++;
+        }
+    }
+}
+
+static void WB(mancapture_w,mancapture_b)(int p,int depth,int d)
+/* man captures of men and crowns, d is the direction of the last jump */
+{
+    int cap=false;
+    int dir,np,nnp;
+
+    for(dir=0;dir<4;dir++) if (dir!=(d^2)) {
+            np=p+OFF[dir];
+            if (board[np]==(ENE|man) || board[np]==(ENE|crown)) {
+                nnp=np+OFF[dir];
+                if (board[nnp]==empty) {
+                    cap=true;
+                    capture_path[depth]=np;
+                    capture_path[depth+1]=board[np];
+                    capture_path[depth+2]=nnp;
+                    board[np]|=taken;
+                    WB(mancapture_w,mancapture_b)(nnp,depth+3,dir);
+                    board[np]-=taken;
+                }
+            }
+        }
+
+    if (cap==false && depth>3) { /* at least one capture */
+        int i;
+
+        if (depth>capture) {capture=depth; Indx=0;}
+        if (depth>=capture) {
+            for(i=1;i<depth;i++) movelist[mg_level][Indx][i]=capture_path[i];
+            movelist[mg_level][Indx][depth]=promote[COL][capture_path[depth-1]];
+            movelist[mg_level][Indx][0]=depth;
+            Indx++;
+        }
+    }
+}
+
+static void WB(crowncapture_w,crowncapture_b)(int pp,int olddir,int depth)
+/* continues a crown capture that arrived on pp moving in olddir */
+{
+    int left,right,i;
+    int dd,dir,cap,p,np;
+    int piece[5],cp[5];
+    int findcap=false;
+
+    left=olddir-1; if (left<0) left+=4;
+    right=(olddir+1)%4;
+
+    for(dd=0;dd<2;dd++) {
+        dir=(dd==0)?left:right;
+        cap=0; p=pp;
+        do {
+            p+=OFF[dir];
+            if (board[p]==empty) {
+                for(i=0;i<cap;i++) {
+                    capture_path[depth+3*i]=cp[i];
+                    capture_path[depth+3*i+1]=piece[i];
+                    capture_path[depth+3*i+2]=p;
+                }
+                if (cap>0) {WB(crowncapture_w,crowncapture_b)(p,dir,depth+3*cap);}
+                continue;
+            } else if (board[p]==(ENE|man) || board[p]==(ENE|crown)) {
+                np=p+OFF[dir];
+                if (board[np]==empty) {
+                    cp[cap]=p;
+                    piece[cap]=board[p];
+                    board[p]|=taken;
+                    cap++;
+                    findcap=true;
+                }
+                else break;
+            } else {
+                break;
+            }
+        } while(true);
+        for(i=0;i<cap;i++) board[cp[i]]=piece[i];
+    }
+
+    if (findcap==false && depth>=capture) {
+        if (depth>capture) {capture=depth; Indx=0;}
+        for(i=1;i<depth;i++) movelist[mg_level][Indx][i]=capture_path[i];
+        movelist[mg_level][Indx][depth]=COL|crown;
+        movelist[mg_level][Indx][0]=depth;
+        Indx++;
+    }
+}
+
+static void WB(crownmove_w,crownmove_b)(int pp)
+/* moves and captures of the crown on pp */
+{
+    int cap;
+    int dir,np;
+    int i,p;
+    int cp[5],piece[5];
+
+    board[pp]=empty;
+    for(dir=0;dir<4;dir++) {
+        p=pp; cap=0;
+        do {
+            p+=OFF[dir];
+            if (board[p]==invalid || board[p]==(COL|man) || board[p]==(COL|crown)) break;
+            if (board[p]==empty) {
+                if (cap>0) {
+                    capture_path[1]=pp;
+                    capture_path[2]=COL|crown;
+                    for(i=0;i<cap;i++) {
+                        capture_path[3+3*i]=cp[i];
+                        capture_path[3+3*i+1]=piece[i];
+                        capture_path[3+3*i+2]=p;
+                    }
+
+                    WB(crowncapture_w,crowncapture_b)(p,dir,3+3*cap);
+                }
+                else if (capture==0) {
+                    movelist[mg_level][Indx][0]=4;
+                    movelist[mg_level][Indx][1]=pp;
+                    movelist[mg_level][Indx][2]=COL|crown;
+                    movelist[mg_level][Indx][3]=p;
+                    movelist[mg_level][Indx][4]=COL|crown;
+                    Indx++;
+                    continue;
+                }
+            }
+            if (board[p]==(ENE|man) || board[p]==(ENE|crown)) {
+                np=p+OFF[dir];
+                if (board[np]==empty) {
+                    cp[cap]=p;
+                    piece[cap]=board[p];
+                    board[p]|=taken;
+                    cap++;
+                }
+                else break;
+            }
+        } while(true);
+        for(i=0;i<cap;i++) board[cp[i]]=piece[i];
+    }
+    board[pp]=COL|crown;
+}
+
+static int WB(move_list_wnc,move_list_bnc)(int level)
+/* move list when there are no crowns on the board */
+{
+    int ip,p;
+    capture=0;
+    mg_level=level;
+
+    Indx=0;
+#if COL==white
+    for(ip=5;ip!=50;ip++) {
+#else
+    for(ip=44;ip!=-1;ip--) {
+#endif
+        p=map[ip];
+        if (board[p] == (COL|man)) {
+            /* capture moves */
+            if (board[p+FL]==(ENE|man) || board[p+FR]==(ENE|man) ||
+                    board[p+BR]==(ENE|man) || board[p+BL]==(ENE|man)) {
+                board[p]=empty;
+                capture_path[1]=p; capture_path[2]=(COL|man);
+                WB(mancapture_wnc,mancapture_bnc)(p,3);
+                board[p]=COL|man;
+            }
+            if (capture==0) { /* non capture man moves */
+                if (board[p+FL]==empty) {
+                    movelist[level][Indx][0]=4;
+                    movelist[level][Indx][1]=p;
+                    movelist[level][Indx][2]=COL|man;
+                    movelist[level][Indx][3]=p+FL;
+                    movelist[level][Indx][4]=promote[COL][p+FL];
+                    Indx++;
+                }
+                if (board[p+FR]==empty) {
+                    movelist[level][Indx][0]=4;
+                    movelist[level][Indx][1]=p;
+                    movelist[level][Indx][2]=COL|man;
+                    movelist[level][Indx][3]=p+FR;
+                    movelist[level][Indx][4]=promote[COL][p+FR];
+                    Indx++;
+                }
+            } /* end if capture */
+        } /* end if ownman */
+    } /* end for board */
+    return(Indx);
+}
+
+static int WB(move_list_w,move_list_b)(int level)
+/* move list with crowns on the board */
+{
+    int ip,p,ehc;
+
+    capture=0;
+    mg_level=level;
+    ehc=(pieces[ENE|crown]!=0);
+    Indx=0;
+
+#if COL==white
+    for(ip=0;ip!=50;ip++) {
+#else
+    for(ip=49;ip!=-1;ip--) {
+#endif
+        p=map[ip];
+        if (board[p] == (COL|man)) {
+            /* capture moves */
+            if (board[p+FL]==(ENE|man) || board[p+FR]==(ENE|man) ||
+                    board[p+BR]==(ENE|man) || board[p+BL]==(ENE|man)) {
+                capture_path[1]=p; capture_path[2]=COL|man;
+                board[p]=empty;
+                WB(mancapture_w,mancapture_b)(p,3,-1);
+                board[p]=COL|man;
+            }
+            else if (ehc==true) if (board[p+FL]==(ENE|crown) || board[p+FR]==(ENE|crown) ||
+                                    board[p+BR]==(ENE|crown) || board[p+BL]==(ENE|crown)) {
+                    capture_path[1]=p; capture_path[2]=COL|man;
+                    board[p]=empty;
+                    WB(mancapture_w,mancapture_b)(p,3,-1);
+                    board[p]=COL|man;
+                }
+            if (capture==0) { /* non capture man moves */
+                if (board[p+FL]==empty) {
+                    movelist[level][Indx][0]=4;
+                    movelist[level][Indx][1]=p;
+                    movelist[level][Indx][2]=COL|man;
+                    movelist[level][Indx][3]=p+FL;
+                    movelist[level][Indx][4]=promote[COL][p+FL];
+                    Indx++;
+                }
+                if (board[p+FR]==empty) {
+                    movelist[level][Indx][0]=4;
+                    movelist[level][Indx][1]=p;
+                    movelist[level][Indx][2]=COL|man;
+                    movelist[level][Indx][3]=p+FR;
+                    movelist[level][Indx][4]=promote[COL][p+FR];
+                    Indx++;
+                }
+            } /* end if capture */
+        } /* end if ownman */
+        /* crown moves */
+        else if (board[p] == (COL|crown)) WB(crownmove_w,crownmove_b)(p);
+    } /* end for board */
+    return(Indx);
+}
+
+static int WB(wnc_quiet,bnc_quiet)(void)
+/* quiet test when there are no crowns on the board */
+{
+    int ip,p;
+
+#if COL==white
+    for(ip=5;ip<50;ip++) {
+#else
+    for(ip=44;ip>=0;ip--) {
+#endif
+        p=map[ip];
+        if (board[p] == (COL|man)) {
+            if (board[p+FL]==(ENE|man)) if (board[p+2*FL]==empty) return(false);
+            if (board[p+FR]==(ENE|man)) if (board[p+2*FR]==empty) return(false);
+            if (board[p+BR]==(ENE|man)) if (board[p+2*BR]==empty) return(false);
+            if (board[p+BL]==(ENE|man)) if (board[p+2*BL]==empty) return(false);
+        }
+    }
+    nquietfail++;
+    return(true);
+}
+
+static int WB(w_quiet,b_quiet)(void)
+{
+    int ip,p,d,pp;
+
+    if (pieces[white|crown]==0 && pieces[black|crown]==0) return(WB(wnc_quiet,bnc_quiet)());
+#if COL==white
+    for(ip=0;ip!=50;ip++) {
+#else
+    for(ip=49;ip>=0;ip--) {
+#endif
+        p=map[ip];
+        if (board[p] == (COL|man)) {
+            if (board[p+FL]==(ENE|man) || board[p+FL]==(ENE|crown)) if (board[p+2*FL]==empty) return(false);
+            if (board[p+FR]==(ENE|man) || board[p+FR]==(ENE|crown)) if (board[p+2*FR]==empty) return(false);
+            if (board[p+BR]==(ENE|man) || board[p+BR]==(ENE|crown)) if (board[p+2*BR]==empty) return(false);
+            if (board[p+BL]==(ENE|man) || board[p+BL]==(ENE|crown)) if (board[p+2*BL]==empty) return(false);
+        }
+        else if (board[p] == (COL|crown)) {
+            for(d=0;d<4;d++) {
+                pp=p;
+                do pp+=OFF[d]; while(board[pp]==empty);
+                if (board[pp]==(ENE|man) || board[pp]==(ENE|crown)) if (board[pp+OFF[d]]==empty) return(false);
+            }
+        }
+    }
+    nquietfail++;
+    return(true);
+}
+
+#undef WB
+#undef ENE
+#undef FL
+#undef FR
+#undef BR
+#undef BL
+#undef OFF
@@ -17,6 +17,8 @@
 /* most code here is obsolete, but there is new code on the end */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "var.h"
 #include "functions.h"
 
@@ -38,10 +40,21 @@ int biggestp;
 struct BMPATTERN {
     unsigned int p1;
     unsigned int p2;
-} bmPattern[50];
+} LOCAL bmPattern[50];
 
 struct BMPATTERN bmPatternInit[50];
-struct BMPATTERN bmFilter[50][50][8];
+
+/* compiled pattern filters: for anchor field i and neighbour slot dp,
+   bmFilter[i][dp][v] holds the patterns that allow value v on bmField[i][dp].
+   Off-board slots are folded into bmPatternInit and point at the anchor
+   itself with an all-ones row, so detectPatterns needs no bounds checks */
+unsigned int bmFilter[50][9][8];
+unsigned char bmField[50][9];
+static const int bmSpread[9]={-7,-6,+6,+7,+12,+14,-12,-13,-14};
+/* the same slots as x,y of the shot rules, and per pattern the values a
+   slot allows as a shot cell set; npat_find tests patterns as cells */
+static const signed char bmSpreadXY[9][2]={{-1,1},{1,1},{-1,-1},{1,-1},{-2,-2},{2,-2},{2,2},{0,2},{-2,2}};
+static unsigned char bmSlotSet[32][9];
 
 /* new code */
 int mapTo4[100]; /* maps board-value to OPP,FREE,BORDER,OWN */
@@ -580,1055 +593,436 @@ void init_takeback()
     mapTo4[invalid]=BORDER;
 }
                
-int npat_findOrig(int color,int cdepth)
-/* returns true if pattern found */
+/* tactical shot rules. Every rule is one line of the form
+
+     from>to [pat=n] [crown] [ip=lo-hi] cell... [tb c1 c2 c3 c4 c5 c6] [ray dir org]
+
+   relative to a white man on local field ip (10..49), white to move:
+   - from>to     the suggested move, both as x,y coordinates (x to the right,
+                 y forward, so 0,0>-1,1 is the forleft step of the man itself)
+   - pat=n       the man must match pattern n (PATn) of patterns.txt
+   - crown       the opponent must have a crown
+   - ip=lo-hi    only for men on fields lo..hi
+   - x,y=set     the field must hold one of set, x,y!set none of set, with
+                 e=empty w=man b=enemy man W=crown B=enemy crown x=off board
+   - tb ...      the takeback[] probe on six fields must be 0; '.' is empty
+   - ray dir org the first piece from org (exclusive) in direction fl/fr/bl/br
+                 must be an enemy crown
+   Rules are tried in order for each man, the first match sets the move.
+   A rule only matches if from holds a man and to is empty, the move is
+   played at leaf nodes so it must stay on the board.
+   shots.txt replaces the built-in rules below when present. */
+
+#define MAXSHOTS 64
+#define MAXSHOTCELLS 12
+#define SHOTCELLS (MAXSHOTCELLS+9+2)  /* with the pattern slots, from and to */
+
+static char *default_shots[]={
+    /* promotion prevention */
+    "0,0>-1,1 ip=41-44 -2,0=b -1,1=e",
+    "0,0>1,1 ip=40-43 2,0=b 1,1=e",
+    /* shot through a double exchange */
+    "0,0>1,1 1,1=e 2,2=b 3,1=b 4,0=w 5,-1!e 0,2=e 2,0!b 3,3=b 4,4=e",
+    "0,0>1,1 1,1=e 2,2=b 3,1=b 4,0=w 5,-1!e 0,2=e 2,0!b 1,3=b 0,4=e",
+    "0,0>1,1 1,1=e 2,2=b 3,1=b 4,0=w 5,-1!e 0,2=w 3,3=b 4,4=e",
+    "0,0>1,1 1,1=e 2,2=b 3,1=b 4,0=w 5,-1!e 0,2=w 1,3=b 0,4=e",
+    "0,0>1,1 1,1=e 2,2=b 3,1=b 4,0=w 5,-1!e 0,2=b 2,0!e 3,3=b 4,4=e",
+    "0,0>1,1 1,1=e 2,2=b 3,1=b 4,0=w 5,-1!e 0,2=b 2,0!e 1,3=b 0,4=e",
+    "0,0>-1,1 -1,1=e -2,2=b -3,1=b -4,0=w -5,-1!e 0,2=e -2,0!b -3,3=b -4,4=e",
+    "0,0>-1,1 -1,1=e -2,2=b -3,1=b -4,0=w -5,-1!e 0,2=e -2,0!b -1,3=b 0,4=e",
+    "0,0>-1,1 -1,1=e -2,2=b -3,1=b -4,0=w -5,-1!e 0,2=w -3,3=b -4,4=e",
+    "0,0>-1,1 -1,1=e -2,2=b -3,1=b -4,0=w -5,-1!e 0,2=w -1,3=b 0,4=e",
+    "0,0>-1,1 -1,1=e -2,2=b -3,1=b -4,0=w -5,-1!e 0,2=b -2,0!e -3,3=b -4,4=e",
+    "0,0>-1,1 -1,1=e -2,2=b -3,1=b -4,0=w -5,-1!e 0,2=b -2,0!e -1,3=b 0,4=e",
+    /* patterns prefiltered by patterns.txt */
+    "0,0>-1,1 pat=1 -4,2=bB -5,3=e -3,1=e -2,0=e 0,-2=wWx tb -7,1 -6,2 -3,5 -4,4 -7,5 -6,4",
+    "0,0>1,1 pat=2 4,2=bB 5,3=e 3,1=e 2,0=e 0,-2=wWx tb 7,1 6,2 3,5 4,4 7,5 6,4",
+    "0,0>-1,1 pat=3 -2,0!e 0,2=b -1,3=e 1,-1!w tb -3,1 . 1,5 0,4 -3,5 -2,4",
+    "0,0>-1,1 pat=3 -2,0!e 0,2=b -1,3=e 2,-2!e tb -3,1 . 1,5 0,4 -3,5 -2,4",
+    "0,0>1,1 pat=4 -2,0!e 0,2=b 1,3=e -1,-1!w tb 3,1 . -1,5 0,4 3,5 2,4",
+    "0,0>1,1 pat=4 -2,0!e 0,2=b 1,3=e -2,-2!e tb 3,1 . -1,5 0,4 3,5 2,4",
+    "0,0>-1,1 pat=3 2,0=bB 0,2=wWe 3,-1=e tb 5,1 4,0 1,-3 2,-2 5,-3 4,-2",
+    "0,0>-1,1 pat=3 2,0=bB 0,2=bBx -2,0!e 3,-1=e tb 5,1 4,0 1,-3 2,-2 5,-3 4,-2",
+    "0,0>1,1 pat=4 -2,0=bB 0,2=wWe -3,-1=e tb -5,1 -4,0 -1,-3 -2,-2 -5,-3 -4,-2",
+    "0,0>1,1 pat=4 -2,0=bB 0,2=bBx 2,0!e -3,-1=e tb -5,1 -4,0 -1,-3 -2,-2 -5,-3 -4,-2",
+    "0,0>-1,1 pat=1 0,-2=wWx -2,0=e -3,1=e -4,0=bB -5,-1=e tb -3,-3 -4,-2 -7,1 -6,0 -7,-3 -6,-2",
+    "0,0>1,1 pat=2 0,-2=wWx 2,0=e 3,1=e 4,0=bB 5,-1=e tb 3,-3 4,-2 7,1 6,0 7,-3 6,-2",
+    "0,0>-1,1 pat=5 -2,0=wbWB 1,3=e tb -1,5 0,4 3,1 2,2 3,5 2,4",
+    "0,0>-1,1 pat=5 -2,0=b tb -1,-3 -2,-2 -5,1 -4,0 -5,-3 -4,-2",
+    "0,0>-1,1 pat=5 -2,0=B -3,-1=e tb -1,-3 -2,-2 -5,1 -4,0 -5,-3 -4,-2",
+    "0,0>1,1 pat=6 2,0=wbWB -1,3=e tb 1,5 0,4 -3,1 -2,2 -3,5 -2,4",
+    "0,0>1,1 pat=6 2,0=b tb 1,-3 2,-2 5,1 4,0 5,-3 4,-2",
+    "0,0>1,1 pat=6 2,0=B 3,-1=e tb 1,-3 2,-2 5,1 4,0 5,-3 4,-2",
+    "0,0>-1,1 pat=7 3,3=e tb 1,5 2,4 4,1 4,2 5,5 4,4",
+    "0,0>1,1 pat=8 -3,3=e tb -1,5 -2,4 -4,1 -4,2 -5,5 -4,4",
+    /* catch an enemy crown */
+    "0,0>-1,1 pat=9 crown ray fl 0,0",
+    "0,0>1,1 pat=10 crown ray fr 0,0",
+    "-1,-3>-2,-2 pat=11 crown -1,-3=w -3,-1=e ray bl 0,0",
+    "1,-3>2,-2 pat=12 crown 1,-3=w 3,-1=e ray br 0,0",
+    "-1,-1>-2,0 pat=13 crown -2,0=e 3,-3=wWx ray bl -1,1",
+    "1,-1>2,0 pat=14 crown -2,0=e -3,-3=wWx ray br 1,1",
+    NULL
+};
+
+typedef struct {
+    char pat;                   /* pattern number, 0=none */
+    char needcrown,lo,hi,ncell,tb,ray;
+    char nall;                  /* cells with the pattern slots, from and to */
+    signed char cell[SHOTCELLS][2];
+    unsigned char set[SHOTCELLS];
+    signed char tbcell[6][2];   /* x==SHOTEMPTY: constant empty */
+    signed char org[2];
+    signed char from[2],to[2];
+    /* compiled: the cells (with the pattern slots, from and to appended) as
+       offsets on the field layout, onb[c] are the anchors for which cell c is on the board
+       and offb[c] those that pass because the cell is off the board and
+       its set allows that */
+    unsigned char shr[SHOTCELLS],shl[SHOTCELLS];
+    unsigned char uset[SHOTCELLS];  /* index of the set in shot_uset */
+    unsigned INT64 onb[SHOTCELLS],offb[SHOTCELLS];
+    unsigned INT64 anchors;
+    unsigned INT64 menmask[2];  /* the anchors as man_bits of white and black */
+    char share;     /* leading cells equal to those of the previous rule */
+} tpShot;
+
+/* field sets are 64 bit masks with bit p-SHOTBASE for field p, so that the
+   neighbour at x,y is a shift by (x-13*y)/2 for every anchor at once */
+#define SHOTBASE 14
+#define SHOTEMPTY 99
+
+static tpShot shot[MAXSHOTS];
+static int nshot=0;
+static unsigned char shot_uset[32];  /* the different sets of the cells */
+static int nshot_uset;
+static unsigned INT64 shot_board;  /* all fields */
+static const char shot_debruijn[64]={
+     0, 1,48, 2,57,49,28, 3,61,58,50,42,38,29,17, 4,
+    62,55,59,36,53,51,43,22,45,39,33,30,24,18,12, 5,
+    63,47,56,27,60,41,37,16,54,35,52,21,44,32,23,11,
+    46,26,40,15,34,20,31,10,25,14,19, 9,13, 8, 7, 6};
+
+static unsigned INT64 shot_layout(unsigned INT64 x)
+/* converts a set with bit ip per field (man_bits) to a field set: every
+   row of five moves up by the padding in front of it */
 {
-    static BTYPE temp[93];
-    BTYPE *local;  /* out local board */
-    int mman,eman,mcrown,ecrown;  /* number of pieces on the board */
-    int bbbr,bbbl,fffr,fffl,fl,fr,bl,br,bbl,bbr,ffr,ffl,l,r,f,b;  /* field-value at different position relative to current piece */
-    int p,ip,pt;
-    int i1,i2,i3,i4,i5,i6;
-    
-    pat_try++;
-    
-    /* makesure we work on a white to move board */
-    if (color==white) {
-        local=board;
-        mman=pieces[white|man]; eman=pieces[black|man];
-        mcrown=pieces[white|crown]; ecrown=pieces[black|crown];
-    }
-    else {
-        local=temp;
-        reverse_board(local,board);
-        eman=pieces[white|man]; mman=pieces[black|man];
-        ecrown=pieces[white|crown]; mcrown=pieces[black|crown];
+    static const char pad[10]={0,1,3,4,6,7,9,10,12,13};
+    unsigned INT64 f=0;
+    int r;
+
+    for(r=0;r<10;r++) f|=((x>>(5*r))&31)<<(5*r+pad[r]);
+    return f;
+}
+
+static unsigned INT64 shot_mirror(unsigned INT64 f)
+/* turns a field set around, as reverse_board does: map[ip]+map[49-ip]=90,
+   so bit i goes to bit 62-i */
+{
+    f=((f>>1)&0x5555555555555555ULL)|((f&0x5555555555555555ULL)<<1);
+    f=((f>>2)&0x3333333333333333ULL)|((f&0x3333333333333333ULL)<<2);
+    f=((f>>4)&0x0F0F0F0F0F0F0F0FULL)|((f&0x0F0F0F0F0F0F0F0FULL)<<4);
+    f=((f>>8)&0x00FF00FF00FF00FFULL)|((f&0x00FF00FF00FF00FFULL)<<8);
+    f=((f>>16)&0x0000FFFF0000FFFFULL)|((f&0x0000FFFF0000FFFFULL)<<16);
+    f=(f>>32)|(f<<32);
+    return f>>1;
+}
+
+static int shot_coord(char *s,signed char *c)
+{
+    int x,y;
+
+    if (sscanf(s,"%i,%i",&x,&y)!=2 || x<-9 || x>9 || y<-9 || y>9) return(false);
+    c[0]=x; c[1]=y;
+    return(true);
+}
+
+static int shot_set(char *s)
+{
+    int set=0;
+
+    for(;*s;s++) switch(*s) {
+        case 'e': set|=1; break;
+        case 'w': set|=2; break;
+        case 'b': set|=4; break;
+        case 'W': set|=8; break;
+        case 'B': set|=16; break;
+        case 'x': set|=32; break;
+        default: return(-1);
     }
+    return(set);
+}
 
-    
-    for(ip=0;ip<50;ip++) {
-        p=map[ip];
-        fl=local[p-7];
-        fr=local[p-6];
-        bl=local[p+6];
-        br=local[p+7];
-        bbr=local[p+14];
-        if (bbr!=invalid) bbbr=local[p+21]; else bbbr=invalid;
-        bbl=local[p+12];
-        if (bbl!=invalid) bbbl=local[p+18]; else bbbl=invalid;
-        ffr=local[p-12];
-        ffl=local[p-14];
-        if (ffr!=invalid) fffr=local[p-18]; else fffr=invalid;
-        if (ffl!=invalid) fffl=local[p-21]; else fffl=invalid;
-
-        l=local[next[white][next[white][p][forleft]][backleft]];
-        r=local[next[white][next[white][p][forright]][backright]];
-        if (ip>=10) f=local[p-13]; else f=invalid;
-        if (ip<=39) b=local[p+13]; else b=invalid;
-
-        if (local[p]==man) {
-            
-            /* pattern:
-            ??      ??
-              ??  ??
-                ..
-              ??  bb  w.  bb
-            ??      ..  ..
-                      ..  ww
-                    ??  ww
-                  ??      ws
-            */
-            if (LWBOARD(p,-1,1)==empty && LWBOARD(p,0,2)==(black|man) && (LWBOARD(p,-4,2)==(black|man) || LWBOARD(p,-4,2)==(black|crown)) &&
-            LWBOARD(p,-5,3)==empty && LWBOARD(p,-3,1)==empty && LWBOARD(p,-2,-0)==empty &&
-            bl==man && (LWBOARD(p,0,-2)==man || LWBOARD(p,0,-2)==crown || LWBOARD(p,0,-2)==invalid) &&
-            (ffl==empty || ffl==man || ffl==crown)) {
-                i1=mapTo4[LWBOARD(p,-7,1)];
-                i2=mapTo4[LWBOARD(p,-6,2)];
-                i3=mapTo4[LWBOARD(p,-3,5)];
-                i4=mapTo4[LWBOARD(p,-4,4)];
-                i5=mapTo4[LWBOARD(p,-7,5)];
-                i6=mapTo4[LWBOARD(p,-6,4)];
-                if (takeback[i1][i2][i3][i4][i5][i6]==0) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-7);
-                    return(true);
-                }
-            }
-            /* mirror */
-            if (LWBOARD(p,1,1)==empty && LWBOARD(p,0,2)==(black|man) && (LWBOARD(p,4,2)==(black|man) || LWBOARD(p,4,2)==(black|crown)) &&
-            LWBOARD(p,5,3)==empty && LWBOARD(p,3,1)==empty && LWBOARD(p,2,0)==empty &&
-            br==man && (LWBOARD(p,0,-2)==man || LWBOARD(p,0,-2)==crown || LWBOARD(p,0,-2)==invalid) &&
-            (ffr==empty || ffr==man || ffr==crown)) {
-                i1=mapTo4[LWBOARD(p,7,1)];
-                i2=mapTo4[LWBOARD(p,6,2)];
-                i3=mapTo4[LWBOARD(p,3,5)];
-                i4=mapTo4[LWBOARD(p,4,4)];
-                i5=mapTo4[LWBOARD(p,7,5)];
-                i6=mapTo4[LWBOARD(p,6,4)];
-                /*printf("%i %i %i %i %i %i %i\n",i1,i2,i3,i4,i5,i6,takeback[i1][i2][i3][i4][i5][i6]);*/
-                if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                    pat_found++;
-                    /*printf("s\n");*/
-                    setMove(cdepth,color,p,p-6);
-                    return(true);
-                }
-            }
-            /* pattern:
-            bb  w.
-              ..  ..      ??            
-            ??  ww  bb  ??
-              ww  ??  ..
-            ws      ??  ??
-                  ??      ??
-            */
-            if (
-                fl==empty &&
-                fr==empty &&
-                ffl==(black|man) &&
-                (r==(black|man) || r==(black|crown)) &&
-                (bl==man || bl==crown) &&
-                (bbl==man || bbl==crown || bbl==invalid) &&
-                (f==man || f==crown || f==empty || (f==(black|man) && local[p-1]==man)) &&
-                LWBOARD(p,3,-1)==empty
-            ) {
-                i1=mapTo4[LWBOARD(p,5,1)];
-                i2=mapTo4[LWBOARD(p,4,0)];
-                i3=mapTo4[LWBOARD(p,1,-3)];
-                i4=mapTo4[LWBOARD(p,2,-2)];
-                i5=mapTo4[LWBOARD(p,5,-3)];
-                i6=mapTo4[LWBOARD(p,4,-2)];
-                if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-7);
-                    return(true);
-                }
-            }
-            /* mirror */
-            printf("%i %i %i %i %i %i %i %i\n",p,fr,fl,ffr,l,br,bbr,f,local[p+1]);
-            if (
-                fr==empty &&
-                fl==empty &&
-                ffr==(black|man) &&
-                (l==(black|man) || l==(black|crown)) &&
-                (br==man || br==crown) &&
-                (bbr==man || bbr==crown || bbr==invalid) &&
-                (f==man || f==crown || f==empty || (f==(black|man) && local[p+1]==man)) &&
-                LWBOARD(p,-3,-1)==empty
-            ) {    
-                printf("hallo\n");
-                i1=mapTo4[LWBOARD(p,-5,1)];
-                i2=mapTo4[LWBOARD(p,-4,0)];
-                i3=mapTo4[LWBOARD(p,-1,-3)];
-                i4=mapTo4[LWBOARD(p,-2,-2)];
-                i5=mapTo4[LWBOARD(p,-5,-3)];
-                i6=mapTo4[LWBOARD(p,-4,-2)];
-                if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-6);
-                    return(true);
-                }
-            }
-            /* pattern:
-                      w.  bb
-            ??      ..  ..
-              ??  bb  ..  ww
-                ..  ??  ww
-              ??  ??      ws  
-            ??        
-            */
-            if (
-                f==(black|man) &&
-                bl==man &&
-                (b==man || b==crown || b==invalid) &&
-                fl==empty &&
-                l==empty &&
-                (ffl==empty || ffl==man || ffl==crown) &&
-                LWBOARD(p,-3,1)==empty &&
-                (LWBOARD(p,-4,0)==(black|man) || LWBOARD(p,-4,0)==(black|crown)) &
-                LWBOARD(p,-5,-1)==empty
-            ) {
-                i1=mapTo4[LWBOARD(p,-3,-3)];
-                i2=mapTo4[LWBOARD(p,-4,-2)];
-                i3=mapTo4[LWBOARD(p,-7,1)];
-                i4=mapTo4[LWBOARD(p,-6,0)];
-                i5=mapTo4[LWBOARD(p,-7,-3)];
-                i6=mapTo4[LWBOARD(p,-6,-2)];
-                if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-7);
-                    return(true);
-                } 
-            }                
-            /* mirror */
-            if (
-                f==(black|man) &&
-                br==man &&
-                (b==man || b==crown || b==invalid) &&
-                fr==empty &&
-                r==empty &&
-                (ffr==empty || ffr==man || ffr==crown) &&
-                LWBOARD(p,3,1)==empty &&
-                (LWBOARD(p,4,0)==(black|man) || LWBOARD(p,4,0)==(black|crown)) &
-                LWBOARD(p,5,-1)==empty
-            ) {
-                i1=mapTo4[LWBOARD(p,3,-3)];
-                i2=mapTo4[LWBOARD(p,4,-2)];
-                i3=mapTo4[LWBOARD(p,7,1)];
-                i4=mapTo4[LWBOARD(p,6,0)];
-                i5=mapTo4[LWBOARD(p,7,-3)];
-                i6=mapTo4[LWBOARD(p,6,-2)];
-                if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-6);
-                    return(true);
-                } 
+static int shot_parse(char *line,tpShot *s)
+/* compiles one rule line into s, returns false on a syntax error */
+{
+    char buf[512],*tok,*q,*sep=" \t\r\n";
+    int i,n,a,b;
+
+    strncpy(buf,line,511); buf[511]=0;
+    memset(s,0,sizeof(tpShot));
+    s->lo=10; s->hi=49;
+    tok=strtok(buf,sep);
+    if (tok==NULL || (q=strchr(tok,'>'))==NULL) return(false);
+    *q=0;
+    if (shot_coord(tok,s->from)==false || shot_coord(q+1,s->to)==false) return(false);
+    while ((tok=strtok(NULL,sep))!=NULL) {
+        if (strncmp(tok,"pat=",4)==0) {
+            n=atoi(tok+4);
+            if (n<1 || n>32) return(false);
+            s->pat=n;
+        }
+        else if (strcmp(tok,"crown")==0) s->needcrown=true;
+        else if (strncmp(tok,"ip=",3)==0) {
+            if (sscanf(tok+3,"%i-%i",&a,&b)!=2 || a<10 || b>49 || a>b) return(false);
+            s->lo=a; s->hi=b;
+        }
+        else if (strcmp(tok,"tb")==0) {
+            for(i=0;i<6;i++) {
+                tok=strtok(NULL,sep);
+                if (tok==NULL) return(false);
+                if (strcmp(tok,".")==0) s->tbcell[i][0]=SHOTEMPTY;
+                else if (shot_coord(tok,s->tbcell[i])==false) return(false);
             }
-            /* pattern:
-                ??      ??
-                  ??  ??
-                    ..
-              bb  bb  ??
-                ..  ??  ?? 
-              ww  ww  
-                ??  ww
-              ??      ws   
-            */
-            /*if (p==54) printf("%i\n%i\n%i\n%i\n%i\n%i\n%i\n%",fl,ffl,br,bbr,f,l,LWBOARD(p,1,3));*/
-                
-            if (
-                fl==empty &&
-                ffl==(black|man) &&
-                br==man &&
-                (bbr==man || bbr==crown || bbr==invalid) &&
-                (f==(black|man) || f==(black|crown)) &&
-                (l==man || l==crown) &&
-                LWBOARD(p,1,3)==empty
-            ) {
-                i1=mapTo4[LWBOARD(p,-1,5)];
-                i2=mapTo4[LWBOARD(p,0,4)];
-                i3=mapTo4[LWBOARD(p,3,1)];
-                i4=mapTo4[LWBOARD(p,2,2)];
-                i5=mapTo4[LWBOARD(p,3,5)];
-                i6=mapTo4[LWBOARD(p,2,4)];
-                if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-7);
-                    return(true);
-                }
-            }                
-            /* mirror */
-            if (
-                fr==empty &&
-                ffr==(black|man) &&
-                bl==man &&
-                (bbl==man || bbl==crown || bbl==invalid) &&
-                (f==(black|man) || f==(black|crown)) &&
-                (r==man || r==crown) &&
-                LWBOARD(p,-1,3)==empty
-            ) {
-                i1=mapTo4[LWBOARD(p,1,5)];
-                i2=mapTo4[LWBOARD(p,0,4)];
-                i3=mapTo4[LWBOARD(p,-3,1)];
-                i4=mapTo4[LWBOARD(p,-2,2)];
-                i5=mapTo4[LWBOARD(p,-3,5)];
-                i6=mapTo4[LWBOARD(p,-2,4)];
-                if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-6);
-                    return(true);
-                }
-            }                
-            
-            /*
-                  ??      ??
-                    ??  ??
-                      ..
-            bb  w.  bb  ??
-              ..  ..      ??
-            ??  ww  
-              ww  ??
-            ws      ??
-            */
-            if (
-                fl==empty &&
-                ffl==(black|man) &&
-                fr==empty &&
-                (f==empty || f==man || f==crown) &&
-                (ffr==(black|man) || ffr==(black|crown)) &&
-                bl==man &&
-                (bbl==man || bbl==crown || bbl==invalid) &&
-                LWBOARD(p,3,3)==empty
-            ) {
-                i1=mapTo4[LWBOARD(p,1,5)];
-                i2=mapTo4[LWBOARD(p,2,4)];
-                i3=mapTo4[LWBOARD(p,4,1)];
-                i4=mapTo4[LWBOARD(p,4,2)];
-                i5=mapTo4[LWBOARD(p,5,5)];
-                i6=mapTo4[LWBOARD(p,4,4)];
-                if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-7);
-                    return(true);
-                }
-            }                
-            /* mirror */
-            if (
-                fr==empty &&
-                ffr==(black|man) &&
-                fl==empty &&
-                (f==empty || f==man || f==crown) &&
-                (ffl==(black|man) || ffl==(black|crown)) &&
-                br==man &&
-                (bbr==man || bbr==crown || bbr==invalid) &&
-                LWBOARD(p,-3,3)==empty
-            ) {
-                i1=mapTo4[LWBOARD(p,-1,5)];
-                i2=mapTo4[LWBOARD(p,-2,4)];
-                i3=mapTo4[LWBOARD(p,-4,1)];
-                i4=mapTo4[LWBOARD(p,-4,2)];
-                i5=mapTo4[LWBOARD(p,-5,5)];
-                i6=mapTo4[LWBOARD(p,-4,4)];
-                if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-6);
-                    return(true);
-                }
-            }                
-                
-            if (ecrown>0) {
-                /* pattern: catch enemy crown 
-                BB  ??   ??
-                  ..  ??
-                ??  ww  ??
-                  ??  ww
-                ??  ??  ws        
-                */
-                if (fl == empty && br == man && (bbr == man || bbr == invalid || bbr == crown)) {
-                    int rayHasCrown=false;
-                    pt=p;
-                    do {
-                        pt=next[0][pt][forleft];
-                        if (pt==invalid) break;
-                        if (local[pt]!=empty) {
-                            if (local[pt]==(black|crown)) {
-                                rayHasCrown=true;
-                            }
-                            break;
-                        }
-                    } while (true);
-                    if (rayHasCrown==true) {
-                        pat_found++;
-                        setMove(cdepth,color,p,p-7);
-                        return(true);
-                    }
-                }
-                if (fr == empty && bl == man && (bbl == man || bbl == invalid || bbl == crown)) {
-                    int rayHasCrown=false;
-                    pt=p;
-                    do {
-                        pt=next[0][pt][forright];
-                        if (pt==invalid) break;
-                        if (local[pt]!=empty) {
-                            if (local[pt]==(black|crown)) {
-                                rayHasCrown=true;
-                            }
-                            break;
-                        }
-                    } while (true);
-                    if (rayHasCrown==true) {
-                        pat_found++;
-                        setMove(cdepth,color,p,p-6);
-                        return(true);
-                    }
-                }
-                /* pattern: catch enemy crown 
-                ??  ??   ws
-                  ??  ww
-                ..  ..  ??
-                  ??  ??
-                BB  ww  ??        
-                */
-                if (bl == empty && bbl == empty && (fr == man || fr == invalid || fr == crown)) {
-                    if (local[p+19] == man && local[p+5]==empty) {
-                        int rayHasCrown=false;
-                        pt=p;
-                        do {
-                            pt=next[0][pt][backleft];
-                            if (pt==invalid) break;
-                            if (local[pt]!=empty) {
-                                if (local[pt]==(black|crown)) {
-                                    rayHasCrown=true;
-                                }
-                                break;
-                            }
-                        } while (true);
-                        if (rayHasCrown==true) {
-                            pat_found++;
-                            setMove(cdepth,color,p+19,p+12);
-                            return(true);
-                        }
-                    }
-                }
-                /* mirror */
-                if (br == empty && bbr == empty && (fl == man || fl == invalid || fl == crown)) {
-                    if (local[p+20] == man && local[p+8]==0) {
-                        int rayHasCrown=false;
-                        pt=p;
-                        do {
-                            pt=next[0][pt][backright];
-                            if (pt==invalid) break;
-                            if (local[pt]!=empty) {
-                                if (local[pt]==(black|crown)) {
-                                    rayHasCrown=true;
-                                }
-                                break;
-                            }
-                        } while (true);
-                        if (rayHasCrown==true) {
-                            pat_found++;
-                            setMove(cdepth,color,p+20,p+14);
-                            return(true);
-                        }
-                    }
-                }
+            s->tb=true;
+        }
+        else if (strcmp(tok,"ray")==0) {
+            tok=strtok(NULL,sep);
+            if (tok==NULL) return(false);
+            if (strcmp(tok,"fl")==0) s->ray=forleft+1;
+            else if (strcmp(tok,"fr")==0) s->ray=forright+1;
+            else if (strcmp(tok,"br")==0) s->ray=backright+1;
+            else if (strcmp(tok,"bl")==0) s->ray=backleft+1;
+            else return(false);
+            tok=strtok(NULL,sep);
+            if (tok==NULL || shot_coord(tok,s->org)==false) return(false);
+        }
+        else {
+            if (s->ncell==MAXSHOTCELLS) return(false);
+            q=strpbrk(tok,"=!");
+            if (q==NULL) return(false);
+            n=shot_set(q+1);
+            if (n<=0) return(false);
+            if (*q=='!') n^=63;
+            *q=0;
+            if (shot_coord(tok,s->cell[(int)s->ncell])==false) return(false);
+            s->set[(int)s->ncell++]=n;
+        }
+    }
+    return(true);
+}
+
+static void shot_add(char *line,int nr)
+{
+    if (nshot==MAXSHOTS) {printf("shots: too many rules\n"); return;}
+    if (shot_parse(line,&shot[nshot])==false) {
+        printf("shots: error in rule %i: %s\n",nr,line);
+        return;
+    }
+    nshot++;
+}
+
+#define SHOTFIELD(p,c) ((int) nextall[0][p][10+(c)[0]][10+(c)[1]])
+
+static void shot_compile(tpShot *s)
+/* resolves the cells of s to field offsets and on-board anchor masks */
+{
+    int c,n,ip,p,f,x,y,off;
+
+    n=s->ncell;
+    if (s->pat>0) {
+        /* the pattern, slot by slot, a slot that allows anything is left out */
+        for(c=0;c<9;c++) {
+            if (bmSlotSet[s->pat-1][c]==63) continue;
+            s->cell[n][0]=bmSpreadXY[c][0]; s->cell[n][1]=bmSpreadXY[c][1];
+            s->set[n++]=bmSlotSet[s->pat-1][c];
+        }
+    }
+    s->cell[n][0]=s->from[0]; s->cell[n][1]=s->from[1]; s->set[n]=2;
+    s->cell[n+1][0]=s->to[0]; s->cell[n+1][1]=s->to[1]; s->set[n+1]=1;
+    s->nall=n+2;
+    for(c=0;c<n+2;c++) {
+        x=s->cell[c][0]; y=s->cell[c][1];
+        off=(x-13*y)/2;
+        s->shr[c]=off>0 ? off : 0;
+        s->shl[c]=off<0 ? -off : 0;
+        s->onb[c]=0;
+        if ((x+y)&1) continue;
+        for(ip=10;ip<50;ip++) {
+            p=map[ip];
+            f=SHOTFIELD(p,s->cell[c]);
+            if (invmap[f]<0) continue;
+            if (f!=p+off) printf("shots: bad offset %i,%i\n",x,y);
+            s->onb[c]|=1ULL<<(p-SHOTBASE);
+        }
+        s->offb[c]=(s->set[c]&32) ? ~s->onb[c] : 0;
+    }
+    for(c=0;c<n+2;c++) {
+        for(f=0;f<nshot_uset && shot_uset[f]!=(s->set[c]&31);f++);
+        if (f==nshot_uset) {
+            if (nshot_uset==32) {printf("shots: too many different cell sets\n"); f=0;}
+            else shot_uset[nshot_uset++]=s->set[c]&31;
+        }
+        s->uset[c]=f;
+    }
+    /* only men for which every cell can match, a man near the edge often
+       has none. As man_bits, black sees the board turned around */
+    s->anchors=0;
+    s->menmask[0]=s->menmask[1]=0;
+    for(ip=s->lo;ip<=s->hi;ip++) {
+        f=map[ip]-SHOTBASE;
+        for(c=0;c<n+2;c++) if ((((s->onb[c]|s->offb[c])>>f)&1)==0) break;
+        if (c<n+2) continue;
+        s->anchors|=1ULL<<f;
+        s->menmask[0]|=1ULL<<ip;
+        s->menmask[1]|=1ULL<<(49-ip);
+    }
+}
 
+void init_shots(void)
+/* compiles the shot rules (shots.txt or the built-in set) for npat_find */
+{
+    FILE *in;
+    char line[512],*q;
+    int i,c;
+
+    nshot=0;
+    in=fopen("shots.txt","r");
+    if (in!=NULL) {
+        i=0;
+        while (fgets(line,512,in)!=NULL) {
+            i++;
+            q=line+strspn(line," \t");
+            if (*q=='#' || *q=='\n' || *q=='\r' || *q==0) continue;
+            shot_add(q,i);
+        }
+        fclose(in);
+        dprint("shots.txt: %i rules\n",nshot);
+    } else {
+        for(i=0;default_shots[i]!=NULL;i++) shot_add(default_shots[i],i+1);
+    }
+    shot_board=0;
+    for(i=0;i<50;i++) shot_board|=1ULL<<(map[i]-SHOTBASE);
+    nshot_uset=0;
+    for(i=0;i<nshot;i++) {
+        shot_compile(&shot[i]);
+        shot[i].share=0;
+        if (i>0 && shot[i].anchors==shot[i-1].anchors) {
+            for(c=0;c<shot[i].ncell && c<shot[i-1].ncell;c++) {
+                if (shot[i].cell[c][0]!=shot[i-1].cell[c][0] || shot[i].cell[c][1]!=shot[i-1].cell[c][1] ||
+                    shot[i].set[c]!=shot[i-1].set[c]) break;
             }
+            shot[i].share=c;
         }
     }
-    return(false);
 }
 
+static int shot_verify(tpShot *s,BTYPE *local,int p)
+/* the per-anchor part of a rule: takeback probe and crown ray */
+{
+    int c,pt,v[6];
+
+    if (s->tb==true) {
+        for(c=0;c<6;c++) {
+            if (s->tbcell[c][0]==SHOTEMPTY) v[c]=FREE;
+            else v[c]=mapTo4[local[SHOTFIELD(p,s->tbcell[c])]];
+        }
+        if (takeback[v[0]][v[1]][v[2]][v[3]][v[4]][v[5]]!=0) return(false);
+    }
+    if (s->ray!=0) {
+        pt=SHOTFIELD(p,s->org);
+        do {
+            pt=next[0][pt][s->ray-1];
+        } while (pt!=invalid && local[pt]==empty);
+        if (pt==invalid || local[pt]!=(black|crown)) return(false);
+    }
+    return(true);
+}
 
 int npat_find(int color,int cdepth)
 /* patterns that checked at the evaluation level
    sets suggested move */
 /* returns true if pattern found */
 {
-    static BTYPE temp[93];
-    BTYPE *local;  /* out local board */
-    int ecrown;  /* number of pieces on the board */
-    int l,r,f,b;  /* field-value at different position relative to current piece */
-    int p,ip,pt;
-    int i1,i2,i3,i4,i5,i6;
-    
-    
-    /* makesure we work on a white to move board */
-    if (color==white) {
-        local=board;
-        ecrown=pieces[black|crown];
-    }
-    else {
-        local=temp;
-        reverse_board(local,board);
-        ecrown=pieces[white|crown];
-    }
-    detectPatterns(local);
+    static LOCAL BTYPE temp[93];
+    BTYPE *local=NULL;  /* white to move board, only made for shot_verify */
+    int ecrown;  /* number of enemy crowns */
+    int ip,k,c,p,v,valid=-1,sets=false;
+    unsigned INT64 stack[SHOTCELLS+1];
+    unsigned INT64 cls[5],u[32],cand[MAXSHOTS],pending=0,m,bit,men;
+    tpShot *s;
+
+    if (use_shots==false) return(false);
+    ecrown=pieces[(color^1)|crown];
     pat_try++;
-    for(ip=10;ip<50;ip++) {
-        p=map[ip];
-        if (local[p]==man) {
-            /*   threat  
-            *  ??  ??
-            *    ??      ??
-            *      ??  ..
-            *        ..  
-            *      w.  bb  w.
-            *        ..  ..
-            *      ww  ww  ww
-            */
-            /*if (local[p-1]==man && local[p+1]==man && local[p-7]==empty && local[p-13]==(black|man) && local[p-6]==empty &&
-                (local[p-14]==empty || local[p-14]==man) && (local[p-12]==empty || local[p-12]==man) &&
-                LWBOARD(p,-1,3)==empty
-            ) {
-                if (LWBOARD(p,-2,4)==empty && LWBOARD(p,0,4)==empty) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-6);
-                    return(true);
-                }                    
-                if (LWBOARD(p,2,4)==empty && LWBOARD(p,0,4)==empty) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-7);
-                    return(true);
-                }
-            }*/
-            /* threat
-          *   ??        
-          *     ??    
-          *       ..
-          *     ww  bb
-          *       ..  ..
-          *         ww  ws
-            */
-            /*if (local[p-7]==empty && local[p-6]==empty &&
-                (local[p+1]==(white|man) || local[p+1]==invalid) &&
-                local[p-14]==(white|man) && local[p-13]==(black|man) && LWBOARD(p,-1,3)==empty
-            ) {
-                i1=mapTo4[LWBOARD(p,-3,1)];
-                i2=mapTo4[LWBOARD(p,-2,2)];
-                i3=mapTo4[LWBOARD(p,1,5)];
-                i4=mapTo4[LWBOARD(p,0,4)];
-                i5=mapTo4[LWBOARD(p,-3,5)];
-                i6=mapTo4[LWBOARD(p,-2,4)];
-                if (takeback[i1][i2][i3][i4][i5][i6]==0) {
-                    //display_board();
-                    //printf("c: %i\n",color);
-                    pat_found++;
-                    setMove(cdepth,color,p,p-6);
-                    return(true);
-                }
-            } */               
-            /* mirror */        
-            /*
-            if (eval_type==3 && local[p-6]==empty && local[p-7]==empty &&
-                (local[p-1]==(white|man) || local[p-1]==invalid) &&
-                local[p-12]==(white|man) && local[p-13]==(black|man) && LWBOARD(p,1,3)==empty
-            ) {
-                i1=mapTo4[LWBOARD(p,3,1)];
-                i2=mapTo4[LWBOARD(p,2,2)];
-                i3=mapTo4[LWBOARD(p,-1,5)];
-                i4=mapTo4[LWBOARD(p,0,4)];
-                i5=mapTo4[LWBOARD(p,3,5)];
-                i6=mapTo4[LWBOARD(p,2,4)];
-                if (takeback[i1][i2][i3][i4][i5][i6]==0) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-7);
-                    return(true);
-                }
-            }                
-            */
-            /* promotion prevention
-                   ..
-                 bb  ww
-               ??  ??
-             **  **  **
-            
-             */
-            if (p>=F41 && p<=F45) {
-                if (p>=F42) {
-                    if (local[p-1]==(black|man) && local[p-7]==empty) {
-                        pat_found++;
-                        setMove(cdepth,color,p,p-7);
-                           return(true);
-                    }
-                }
-                if (p<=F44) {
-                    if (local[p+1]==(black|man) && local[p-6]==empty) {
-                        pat_found++;
-                        setMove(cdepth,color,p,p-6);
-                           return(true);
-                    }
-                }
-            }
-            /* pattern
-            *                ..           ..   
-            *              bb               bb
-            *        w.  bb               w.  bb
-            *          ..  bb               ..  bb
-            *        ww  ??  ww           ww  ??  ww
-            *                  ws                   ws
-            */
-            if (local[p-6]==empty && local[p-12]==(black|man) && LWBOARD(p,3,1)==(black|man) && LWBOARD(p,4,0)==(white|man) && 
-                (local[p-13]==empty || local[p-13]==(white|man) || (local[p-13]==(black|man) && local[p+1]!=empty)) &&
-                (LWBOARD(p,5,-1)!=empty) && !(local[p+1]==(black|man) && local[p-13]==empty)
-            ) {
-                if (LWBOARD(p,3,3)==(black|man) && LWBOARD(p,4,4)==empty) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-6);
-                       return(true);
-                }
-                if (LWBOARD(p,1,3)==(black|man) && LWBOARD(p,0,4)==empty) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-6);
-                       return(true);
+
+    /* every rule for all anchors at once. stack[c] is the anchor set after
+       the first c cells of the previous rule, so a common prefix is only
+       tested once */
+    men=man_bits[color];
+    for(k=0;k<nshot;k++) {
+        s=&shot[k];
+        cand[k]=0;
+        if ((s->needcrown==true && ecrown==0) || (s->menmask[color]&men)==0) {
+            valid=-1;
+            continue;
+        }
+        if (sets==false) {
+            /* field sets of empty, man, enemy man, crown and enemy crown,
+               turned around for black, and of the sets the cells ask for */
+            cls[1]=shot_layout(man_bits[color]);
+            cls[2]=shot_layout(man_bits[color^1]);
+            cls[3]=cls[4]=0;
+            if (pieces[white|crown]+pieces[black|crown]>0) {
+                for(ip=0;ip<50;ip++) {
+                    v=board[map[ip]];
+                    if (v==(color|crown)) cls[3]|=1ULL<<(map[ip]-SHOTBASE);
+                    else if (v==((color^1)|crown)) cls[4]|=1ULL<<(map[ip]-SHOTBASE);
                 }
             }
-            if (local[p-7]==empty && local[p-14]==(black|man) && LWBOARD(p,-3,1)==(black|man) && LWBOARD(p,-4,0)==(white|man) && 
-                (local[p-13]==empty || local[p-13]==(white|man) || (local[p-13]==(black|man) && local[p-1]!=empty)) &&
-                (LWBOARD(p,-5,-1)!=empty) && !(local[p-1]==(black|man) && local[p-13]==empty)
-            ) {
-                if (LWBOARD(p,-3,3)==(black|man) && LWBOARD(p,-4,4)==empty) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-7);
-                       return(true);
-                }
-                if (LWBOARD(p,-1,3)==(black|man) && LWBOARD(p,0,4)==empty) {
-                    pat_found++;
-                    setMove(cdepth,color,p,p-7);
-                       return(true);
-                }
+            if (color==black) for(c=1;c<5;c++) cls[c]=shot_mirror(cls[c]);
+            cls[0]=shot_board&~(cls[1]|cls[2]|cls[3]|cls[4]);
+            for(c=0;c<nshot_uset;c++) {
+                v=shot_uset[c];
+                u[c]=(cls[0]&-(unsigned INT64)(v&1))|(cls[1]&-(unsigned INT64)((v>>1)&1))|
+                     (cls[2]&-(unsigned INT64)((v>>2)&1))|(cls[3]&-(unsigned INT64)((v>>3)&1))|
+                     (cls[4]&-(unsigned INT64)((v>>4)&1));
             }
-            if ((bmPattern[ip].p1 & 16383)!=0) {
-                /* pattern:
-                ??      ??
-                  ??  ??
-                    ..
-                  ??  bb  w.  bb
-                ??      ..  ..
-                          ..  ww
-                        ??  ww
-                      ??      ws
-                */
-            
-                l=local[p-1];
-                r=local[p+1];
-                if (ip<=39) b=local[p+13]; else b=invalid;
-
-                if ((bmPattern[ip].p1 & PAT1)!=0 &&
-                    (LWBOARD(p,-4,2)==(black|man) || LWBOARD(p,-4,2)==(black|crown)) &&
-                    LWBOARD(p,-5,3)==empty && LWBOARD(p,-3,1)==empty && LWBOARD(p,-2,-0)==empty &&
-                    (LWBOARD(p,0,-2)==man || LWBOARD(p,0,-2)==crown || LWBOARD(p,0,-2)==invalid)   
-                ) {
-                    i1=mapTo4[LWBOARD(p,-7,1)];
-                    i2=mapTo4[LWBOARD(p,-6,2)];
-                    i3=mapTo4[LWBOARD(p,-3,5)];
-                    i4=mapTo4[LWBOARD(p,-4,4)];
-                    i5=mapTo4[LWBOARD(p,-7,5)];
-                    i6=mapTo4[LWBOARD(p,-6,4)];
-                    if (takeback[i1][i2][i3][i4][i5][i6]==0) {
-                        pat_found++;
-                        setMove(cdepth,color,p,p-7);
-                        return(true);
-                    }
-                }
-                /* mirror */
-                if ((bmPattern[ip].p1 & PAT2)!=0 &&
-                    (LWBOARD(p,4,2)==(black|man) || LWBOARD(p,4,2)==(black|crown)) &&
-                    LWBOARD(p,5,3)==empty && LWBOARD(p,3,1)==empty && LWBOARD(p,2,0)==empty &&
-                    (LWBOARD(p,0,-2)==man || LWBOARD(p,0,-2)==crown || LWBOARD(p,0,-2)==invalid) 
-                ) {
-                    i1=mapTo4[LWBOARD(p,7,1)];
-                    i2=mapTo4[LWBOARD(p,6,2)];
-                    i3=mapTo4[LWBOARD(p,3,5)];
-                    i4=mapTo4[LWBOARD(p,4,4)];
-                    i5=mapTo4[LWBOARD(p,7,5)];
-                    i6=mapTo4[LWBOARD(p,6,4)];
-                    /*printf("%i %i %i %i %i %i %i\n",i1,i2,i3,i4,i5,i6,takeback[i1][i2][i3][i4][i5][i6]);*/
-                    if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                        pat_found++;
-                        /*printf("s\n");*/
-                        setMove(cdepth,color,p,p-6);
-                        return(true);
-                    }
-                }
-                /* pattern
-           *     ??      ??
-           *       ??  ??
-           *         ..
-           *       bb  bb
-           *     ??  ..  ..
-           *       wb  ww
-           *         ww  .
-           *       ws      .
-                 */
-                if (
-                    ((bmPattern[ip].p1 & PAT3)!=0) &&
-                    l!=empty && local[p-13]==(black|man) &&
-                    LWBOARD(p,-1,3)==empty && !(local[p+7]==man && local[p+14]==empty)
-                ) {
-                    i1=mapTo4[LWBOARD(p,-3,1)];
-                    i2=mapTo4[empty];
-                    i3=mapTo4[LWBOARD(p,1,5)];
-                    i4=mapTo4[LWBOARD(p,0,4)];
-                    i5=mapTo4[LWBOARD(p,-3,5)];
-                    i6=mapTo4[LWBOARD(p,-2,4)];
-                    if (takeback[i1][i2][i3][i4][i5][i6]==0) {
-                        /*dprint("%i %i %i %i %i %i \n",i1,i2,i3,i4,i5,i6);*/
-                        pat_found++;
-                        setMove(cdepth,color,p,p-7);
-                        return(true);
-                    }
-                }
-                /* mirror */
-                if (
-                    ((bmPattern[ip].p1 & PAT4)!=0) &&
-                    l!=empty && local[p-13]==(black|man) &&
-                    LWBOARD(p,1,3)==empty && !(local[p+6]==man && local[p+12]==empty)
-                ) {
-                    i1=mapTo4[LWBOARD(p,3,1)];
-                    i2=mapTo4[empty];
-                    i3=mapTo4[LWBOARD(p,-1,5)];
-                    i4=mapTo4[LWBOARD(p,0,4)];
-                    i5=mapTo4[LWBOARD(p,3,5)];
-                    i6=mapTo4[LWBOARD(p,2,4)];
-                    if (takeback[i1][i2][i3][i4][i5][i6]==0) {
-                        /*dprint("%i %i %i %i %i %i \n",i1,i2,i3,i4,i5,i6);*/
-                        pat_found++;
-                        setMove(cdepth,color,p,p-6);
-                        return(true);
-                    }
-                }
-                /* pattern:
-             *  bb  w.
-             *    ..  ..      ??            
-             *  ??  ww  bb  ??
-             *    ww  ??  ..
-             *  ws      ??  ??
-             *        ??      ??
-                */
-                if (
-                    ((bmPattern[ip].p1 & PAT3)!=0) &&
-                    (r==(black|man) || r==(black|crown)) &&
-                    (local[p-13]==man || local[p-13]==crown || local[p-13]==empty || (local[p-13]!=empty && local[p-1]!=empty)) &&
-                    LWBOARD(p,3,-1)==empty
-                ) {
-                    i1=mapTo4[LWBOARD(p,5,1)];
-                    i2=mapTo4[LWBOARD(p,4,0)];
-                    i3=mapTo4[LWBOARD(p,1,-3)];
-                    i4=mapTo4[LWBOARD(p,2,-2)];
-                    i5=mapTo4[LWBOARD(p,5,-3)];
-                    i6=mapTo4[LWBOARD(p,4,-2)];
-                    /*if ((bmPattern[ip].p1 & PAT3)==0) {
-                        if (color==white) {
-                            printf("%i\n",ip);
-                            display_board();
-                            scanf("%i\n",&i1);
-                        }
-                    }*/
-                    if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                        pat_found++;
-                        setMove(cdepth,color,p,p-7);
-                        return(true);
-                    }
-                }
-                /* mirror */
-                //printf("%i %i %i\n",p,local[p-13],local[+1]);
-                if (
-                    ((bmPattern[ip].p1 & PAT4)!=0) &&
-                    (l==(black|man) || l==(black|crown)) &&
-                    (local[p-13]==man || local[p-13]==crown || local[p-13]==empty || (local[p-13]!=empty && local[p+1]!=empty)) &&
-                    LWBOARD(p,-3,-1)==empty
-                ) {    
-                    i1=mapTo4[LWBOARD(p,-5,1)];
-                    i2=mapTo4[LWBOARD(p,-4,0)];
-                    i3=mapTo4[LWBOARD(p,-1,-3)];
-                    i4=mapTo4[LWBOARD(p,-2,-2)];
-                    i5=mapTo4[LWBOARD(p,-5,-3)];
-                    i6=mapTo4[LWBOARD(p,-4,-2)];
-                    if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                        pat_found++;
-                        setMove(cdepth,color,p,p-6);
-                        return(true);
-                    }
-                }
-                /* pattern:
-             *            w.  bb
-             *  ??      ..  ..
-             *    ??  bb  ..  ww
-             *      ..  ??  ww
-             *    ??  ??      ws  
-             *  ??        
-                */
-                if (
-                    ((bmPattern[ip].p1 & PAT1)!=0) &&
-                    (b==man || b==crown || b==invalid) &&
-                    l==empty &&
-                    LWBOARD(p,-3,1)==empty &&
-                    (LWBOARD(p,-4,0)==(black|man) || LWBOARD(p,-4,0)==(black|crown)) &
-                    LWBOARD(p,-5,-1)==empty
-                ) {
-                    i1=mapTo4[LWBOARD(p,-3,-3)];
-                    i2=mapTo4[LWBOARD(p,-4,-2)];
-                    i3=mapTo4[LWBOARD(p,-7,1)];
-                    i4=mapTo4[LWBOARD(p,-6,0)];
-                    i5=mapTo4[LWBOARD(p,-7,-3)];
-                    i6=mapTo4[LWBOARD(p,-6,-2)];
-                    if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                        pat_found++;
-                        setMove(cdepth,color,p,p-7);
-                        return(true);
-                    } 
-                }                
-                /* mirror */
-                if (
-                    ((bmPattern[ip].p1 & PAT2)!=0) &&
-                    (b==man || b==crown || b==invalid) &&
-                    r==empty &&
-                    LWBOARD(p,3,1)==empty &&
-                    (LWBOARD(p,4,0)==(black|man) || LWBOARD(p,4,0)==(black|crown)) &
-                    LWBOARD(p,5,-1)==empty
-                ) {
-                    i1=mapTo4[LWBOARD(p,3,-3)];
-                    i2=mapTo4[LWBOARD(p,4,-2)];
-                    i3=mapTo4[LWBOARD(p,7,1)];
-                    i4=mapTo4[LWBOARD(p,6,0)];
-                    i5=mapTo4[LWBOARD(p,7,-3)];
-                    i6=mapTo4[LWBOARD(p,6,-2)];
-                    if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                        pat_found++;
-                        setMove(cdepth,color,p,p-6);
-                        return(true);
-                    } 
-                }
-                /* pattern:
-             *      ??      ??
-             *        ??  ??
-             *          ..
-             *    bb  bb  ??
-             *      ..  ??  ?? 
-             *    wb  ww  
-             *  .?  ??  ww
-             *    ??      ws   
-                */
-                /*if (p==54) printf("%i\n%i\n%i\n%i\n%i\n%i\n%i\n%",fl,ffl,br,bbr,f,l,LWBOARD(p,1,3));*/
-                    
-                if (
-                    ((bmPattern[ip].p1 & PAT5)!=0) &&
-                    (l!=empty && l!=invalid)
-                ) {
-                    if (LWBOARD(p,1,3)==empty) {
-                        i1=mapTo4[LWBOARD(p,-1,5)];
-                        i2=mapTo4[LWBOARD(p,0,4)];
-                        i3=mapTo4[LWBOARD(p,3,1)];
-                        i4=mapTo4[LWBOARD(p,2,2)];
-                        i5=mapTo4[LWBOARD(p,3,5)];
-                        i6=mapTo4[LWBOARD(p,2,4)];
-                        if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                            pat_found++;
-                            setMove(cdepth,color,p,p-7);
-                            return(true);
-                        }
-                    }
-                    if (l==(black|man) || l==(black|crown) && LWBOARD(p,-3,-1)==empty) {
-                        i1=mapTo4[LWBOARD(p,-1,-3)];
-                        i2=mapTo4[LWBOARD(p,-2,-2)];
-                        i3=mapTo4[LWBOARD(p,-5,1)];
-                        i4=mapTo4[LWBOARD(p,-4,0)];
-                        i5=mapTo4[LWBOARD(p,-5,-3)];
-                        i6=mapTo4[LWBOARD(p,-4,-2)];
-                        if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                            pat_found++;
-                            setMove(cdepth,color,p,p-7);
-                            return(true);
-                        }
-                    }
-                }                
-                /* mirror */
-                if (
-                    ((bmPattern[ip].p1 & PAT6)!=0) &&
-                    (r!=empty && r!=invalid) 
-                ) {
-                    if (LWBOARD(p,-1,3)==empty) {
-                        i1=mapTo4[LWBOARD(p,1,5)];
-                        i2=mapTo4[LWBOARD(p,0,4)];
-                        i3=mapTo4[LWBOARD(p,-3,1)];
-                        i4=mapTo4[LWBOARD(p,-2,2)];
-                        i5=mapTo4[LWBOARD(p,-3,5)];
-                        i6=mapTo4[LWBOARD(p,-2,4)];
-                        if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                            pat_found++;
-                            setMove(cdepth,color,p,p-6);
-                            return(true);
-                        }
-                    }
-                    if (r==(black|man) || r==(black|crown) && LWBOARD(p,3,-1)==empty) {
-                        i1=mapTo4[LWBOARD(p,1,-3)];
-                        i2=mapTo4[LWBOARD(p,2,-2)];
-                        i3=mapTo4[LWBOARD(p,5,1)];
-                        i4=mapTo4[LWBOARD(p,4,0)];
-                        i5=mapTo4[LWBOARD(p,5,-3)];
-                        i6=mapTo4[LWBOARD(p,4,-2)];
-                        if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                            pat_found++;
-                            setMove(cdepth,color,p,p-6);
-                            return(true);
-                        }
-                    }
-                }                
-                
-                /*
-              *       ??      ??
-              *         ??  ??
-              *           ..
-              * bb  w.  bb  ??
-              *   ..  ..      ??
-              * ??  ww  
-              *   ww  ??
-              * ws      ??
-               */
-                if (
-                    ((bmPattern[ip].p1 & PAT7)!=0) &&
-                    LWBOARD(p,3,3)==empty
-                ) {
-                    i1=mapTo4[LWBOARD(p,1,5)];
-                    i2=mapTo4[LWBOARD(p,2,4)];
-                    i3=mapTo4[LWBOARD(p,4,1)];
-                    i4=mapTo4[LWBOARD(p,4,2)];
-                    i5=mapTo4[LWBOARD(p,5,5)];
-                    i6=mapTo4[LWBOARD(p,4,4)];
-                    if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                        pat_found++;
-                        setMove(cdepth,color,p,p-7);
-                        return(true);
-                    }
-                }                
-                /* mirror */
-                if (
-                    ((bmPattern[ip].p1 & PAT8)!=0) &&
-                    LWBOARD(p,-3,3)==empty
-                ) {
-                    i1=mapTo4[LWBOARD(p,-1,5)];
-                    i2=mapTo4[LWBOARD(p,-2,4)];
-                    i3=mapTo4[LWBOARD(p,-4,1)];
-                    i4=mapTo4[LWBOARD(p,-4,2)];
-                    i5=mapTo4[LWBOARD(p,-5,5)];
-                    i6=mapTo4[LWBOARD(p,-4,4)];
-                    if (takeback[i1][i2][i3][i4][i5][i6]==0 ) {
-                        pat_found++;
-                        setMove(cdepth,color,p,p-6);
-                        return(true);
-                    }
-                }                
-                    
-                if (ecrown>0) {
-                    /* pattern: catch enemy crown 
-              *     BB  ??   ??
-              *       ..  ??
-              *     ??  ww  ??
-              *       ??  ww
-              *     ??  ??  ws        
-                    */
-                    if ((bmPattern[ip].p1 & PAT9)!=0 ) {
-                        int rayHasCrown=false;
-                        pt=p;
-                        do {
-                            pt=next[0][pt][forleft];
-                            if (pt==invalid) break;
-                            if (local[pt]!=empty) {
-                                if (local[pt]==(black|crown)) {
-                                    rayHasCrown=true;
-                                }
-                                break;
-                            }
-                        } while (true);
-                        if (rayHasCrown==true) {
-                            pat_found++;
-                            setMove(cdepth,color,p,p-7);
-                            return(true);
-                        }
-                    }
-                    if ((bmPattern[ip].p1 & PAT10)!=0) {
-                        int rayHasCrown=false;
-                        pt=p;
-                        do {
-                            pt=next[0][pt][forright];
-                            if (pt==invalid) break;
-                            if (local[pt]!=empty) {
-                                if (local[pt]==(black|crown)) {
-                                    rayHasCrown=true;
-                                }
-                                break;
-                            }
-                        } while (true);
-                        if (rayHasCrown==true) {
-                            pat_found++;
-                            setMove(cdepth,color,p,p-6);
-                            return(true);
-                        }
-                    }
-                    /* pattern: catch enemy crown 
-              *     ??  ??   ws
-              *       ??  ww
-              *     ..  ..  ??
-              *       ..  ??
-              *     BB  ww  ??        
-                    */
-                    if ((bmPattern[ip].p1 & PAT11)!=0) {
-                        if (local[p+19] == man && local[p+5]==empty) {
-                            int rayHasCrown=false;
-                            pt=p;
-                            do {
-                                pt=next[0][pt][backleft];
-                                if (pt==invalid) break;
-                                if (local[pt]!=empty) {
-                                    if (local[pt]==(black|crown)) {
-                                        rayHasCrown=true;
-                                    }
-                                    break;
-                                }
-                            } while (true);
-                            if (rayHasCrown==true) {
-                                pat_found++;
-                                setMove(cdepth,color,p+19,p+12);
-                                return(true);
-                            }
-                        }
-                    }
-                    /* mirror */
-                    if ((bmPattern[ip].p1 & PAT12)!=0) {
-                        if (local[p+20] == man && local[p+8]==0) {
-                            int rayHasCrown=false;
-                            pt=p;
-                            do {
-                                pt=next[0][pt][backright];
-                                if (pt==invalid) break;
-                                if (local[pt]!=empty) {
-                                    if (local[pt]==(black|crown)) {
-                                        rayHasCrown=true;
-                                    }
-                                    break;
-                                }
-                            } while (true);
-                            if (rayHasCrown==true) {
-                                pat_found++;
-                                setMove(cdepth,color,p+20,p+14);
-                                return(true);
-                            }
-                        }
-                    }
-                    /* pattern: catch enemy crown 
-               *    ??  ..  ??
-               *      ..  ww
-               *    BB  ww  ..
-               *      ??  ??  ww
-               *        ??  ??  ws
-                    */
-                    if ((bmPattern[ip].p1 & PAT13)!=0) {
-                        if (local[p-1]==empty && (LWBOARD(p,3,-3)==(white|man) || LWBOARD(p,3,-3)==invalid || LWBOARD(p,3,-3)==(white|crown))) {
-                            int rayHasCrown=false;
-                            pt=p-7;
-                            do {
-                                pt=next[0][pt][backleft];
-                                if (pt==invalid) break;
-                                if (local[pt]!=empty) {
-                                    if (local[pt]==(black|crown)) {
-                                        rayHasCrown=true;
-                                    }
-                                    break;
-                                }
-                            } while (true);
-                            if (rayHasCrown==true) {
-                                
-                                pat_found++;
-                                setMove(cdepth,color,p+6,p-1);
-                                return(true);
-                            }
-                        }
-                    } /* endif pat13 */
-                    /* mirror */
-                    if ((bmPattern[ip].p1 & PAT14)!=0) {
-                        if (local[p-1]==empty && (LWBOARD(p,-3,-3)==(white|man) || LWBOARD(p,-3,-3)==invalid || LWBOARD(p,-3,-3)==(white|crown))) {
-                            int rayHasCrown=false;
-                            pt=p-6;
-                            do {
-                                pt=next[0][pt][backright];
-                                if (pt==invalid) break;
-                                if (local[pt]!=empty) {
-                                    if (local[pt]==(black|crown)) {
-                                        rayHasCrown=true;
-                                    }
-                                    break;
-                                }
-                            } while (true);
-                            if (rayHasCrown==true) {
-                                
-                                pat_found++;
-                                setMove(cdepth,color,p+7,p+1);
-                                return(true);
-                            }
-                        }
-                    } /* endif pat14 */
+            sets=true;
+        }
+        c=s->share<valid ? s->share : valid;
+        if (c<=0) {
+            c=0;
+            stack[0]=s->anchors&cls[1];
+        }
+        for(m=stack[c];c<s->nall && m!=0;c++) {
+            bit=(u[s->uset[c]]>>s->shr[c])<<s->shl[c];
+            m&=(bit&s->onb[c])|s->offb[c];
+            stack[c+1]=m;
+        }
+        valid=c;
+        cand[k]=m;
+        pending|=m;
+    }
+
+    /* lowest anchor first, then rule order */
+    while (pending!=0) {
+        bit=pending&(~pending+1);
+        pending^=bit;
+        p=shot_debruijn[(bit*0x03F79D71B4CB0A89ULL)>>58]+SHOTBASE;
+        for(k=0;k<nshot;k++) {
+            if ((cand[k]&bit)==0) continue;
+            s=&shot[k];
+            if (local==NULL) {
+                if (color==white) local=board;
+                else {
+                    local=temp;
+                    reverse_board(local,board);
                 }
             }
+            if (shot_verify(s,local,p)==false) continue;
+            pat_found++;
+            setMove(cdepth,color,SHOTFIELD(p,s->from),SHOTFIELD(p,s->to));
+            return(true);
         }
     }
     return(false);
@@ -1639,15 +1033,22 @@ void initDetectPatterns(void)
     int i;
     int pattern;
     char pat[100];
-    int p,spr;
-    int v,dp;
-    int include;
+    int p,v,dp;
     FILE *in;
-    for (i=0;i<50;i++) for (p=0;p<50;p++) for (v=0;v<8;v++) bmFilter[i][p][v].p1=0;
-    
+
     for (i=0;i<50;i++) {
         bmPatternInit[i].p1=0;
         bmPatternInit[i].p2=0;
+        for (dp=0;dp<9;dp++) {
+            p=invmap[map[i]+bmSpread[dp]];
+            if (p<0) {
+                bmField[i][dp]=map[i];
+                for (v=0;v<8;v++) bmFilter[i][dp][v]=0xffffffffU;
+            } else {
+                bmField[i][dp]=map[i]+bmSpread[dp];
+                for (v=0;v<8;v++) bmFilter[i][dp][v]=0;
+            }
+        }
     }
 
     in=fopen("patterns.txt","r");
@@ -1655,116 +1056,50 @@ void initDetectPatterns(void)
         dprint("FATAL: patterns.txt not found\n");
         exit(1);
     }
+    /* each pattern is 9 groups of 7 flags, one group per neighbour slot:
+       flag v allows board value v, flag 1 allows the slot to be off-board */
     for (pattern=0;pattern<32;pattern++) {
         fscanf(in,"%s\n",pat);
+        for(dp=0;dp<9;dp++) {
+            bmSlotSet[pattern][dp]=(pat[dp*7+1]=='0') ? 0 : 32;
+            for (v=0;v<6;v++) {
+                if (v!=1 && pat[dp*7+v]=='1') bmSlotSet[pattern][dp] |= (v==0) ? 1 : 1<<(v-1);
+            }
+        }
         for (i=0;i<50;i++) {
-            /*if (i==34) printf("xx1 %x\n",bmPatternInit[i].p1);*/
-            bmPatternInit[i].p1=bmPatternInit[i].p1 | (1<<pattern);
-            /*if (i==34) printf("xx2 %x\n",bmPatternInit[i].p1);*/
+            bmPatternInit[i].p1 |= 1U<<pattern;
             for(dp=0;dp<9;dp++) {
-                if (dp==0) spr=-7;
-                if (dp==1) spr=-6;
-                if (dp==2) spr=+6;
-                if (dp==3) spr=+7;
-                if (dp==4) spr=+12;
-                if (dp==5) spr=+14;
-                if (dp==6) spr=-12;
-                if (dp==7) spr=-13;
-                if (dp==8) spr=-14;
-                p=invmap[map[i]+spr];
-                /*if (i==34) printf("xx3 %x\n",bmPatternInit[i].p1);*/
+                p=invmap[map[i]+bmSpread[dp]];
                 if (p<0) {
-                    if (pat[dp*7+1]=='0') {
-                        bmPatternInit[i].p1 &=  (-1-(1<<pattern));
-                        /*if (i==34 ) printf("%x\n",bmPatternInit[i].p1);*/
-                        
-                    }
+                    if (pat[dp*7+1]=='0') bmPatternInit[i].p1 &= ~(1U<<pattern);
                 } else {
                     for (v=0;v<6;v++) {
-                        include=0;
-                        if (v==0 && pat[dp*7+0]=='1') include=1;
-                        if (v==2 && pat[dp*7+2]=='1') include=1;
-                        if (v==3 && pat[dp*7+3]=='1') include=1;
-                        if (v==4 && pat[dp*7+4]=='1') include=1;
-                        if (v==5 && pat[dp*7+5]=='1') include=1;
-                        bmFilter[i][p][v].p1=bmFilter[i][p][v].p1 | (include<<pattern);
+                        if (v!=1 && pat[dp*7+v]=='1') bmFilter[i][dp][v] |= 1U<<pattern;
                     }
                 }
-                /*if (i==34) printf("xx4 %x\n",bmPatternInit[i].p1);*/
             }
         }
-        
     }
-    printf("ww %x",bmPatternInit[34].p1);
     fclose(in);
 }
 
 void detectPatterns(BTYPE *local)
+/* sets bmPattern[i].p1 to the patterns that match around every white man */
 {
     int i;
-    int p;
-    int p1,p2;
-        
+    unsigned int p1;
+    unsigned int (*f)[8];
+    unsigned char *q;
+
     for (i=5;i<50;i++) {
         if (local[map[i]]==(white|man)) {
+            f=bmFilter[i];
+            q=bmField[i];
             p1=bmPatternInit[i].p1;
-            //p2=bmPatternInit[i].p2;
-            
-            p=invmap[map[i]+7];
-            if (p>=0) {
-                p1 &= bmFilter[i][p][local[map[i]+7]].p1;
-             //   p2 &= bmFilter[i][p][local[map[i]+7]].p2;
-            }
-            p=invmap[map[i]+6];
-            if (p>=0) {
-                p1 &= bmFilter[i][p][local[map[i]+6]].p1;
-               // p2 &= bmFilter[i][p][local[map[i]+6]].p2;
-            }
-            p=invmap[map[i]-7];
-            if (p>=0) {
-                p1 &= bmFilter[i][p][local[map[i]-7]].p1;
-            //    p2 &= bmFilter[i][p][local[map[i]-7]].p2;
-            }
-            p=invmap[map[i]-6];
-            if (p>=0) {
-                p1 &= bmFilter[i][p][local[map[i]-6]].p1;
-            //    p2 &= bmFilter[i][p][local[map[i]-6]].p2;
-            }
-            p=invmap[map[i]+14];
-            if (p>=0) {
-                p1 &= bmFilter[i][p][local[map[i]+14]].p1;
-              //  p2 &= bmFilter[i][p][local[map[i]+14]].p2;
-            }
-            p=invmap[map[i]+12];
-            if (p>=0) {
-                p1 &= bmFilter[i][p][local[map[i]+12]].p1;
-            //    p2 &= bmFilter[i][p][local[map[i]+12]].p2;
-            }
-            p=invmap[map[i]-12];
-            if (p>=0) {
-                p1 &= bmFilter[i][p][local[map[i]-12]].p1;
-            //    p2 &= bmFilter[i][p][local[map[i]-12]].p2;
-            }
-            p=invmap[map[i]-14];
-            if (p>=0) {
-                p1 &= bmFilter[i][p][local[map[i]-14]].p1;
-            //    p2 &= bmFilter[i][p][local[map[i]-14]].p2;
-            }
-            p=invmap[map[i]-13];
-            if (p>=0) {
-                p1 &= bmFilter[i][p][local[map[i]-13]].p1;
-             //   p2 &= bmFilter[i][p][local[map[i]-13]].p2;
-            }
+            p1 &= f[0][local[q[0]]] & f[1][local[q[1]]] & f[2][local[q[2]]];
+            p1 &= f[3][local[q[3]]] & f[4][local[q[4]]] & f[5][local[q[5]]];
+            p1 &= f[6][local[q[6]]] & f[7][local[q[7]]] & f[8][local[q[8]]];
             bmPattern[i].p1=p1;
-           // bmPattern[i].p2=p2;
-            /*printf("%i %i\n",i,p1 & 15);*/
         }
     }
 }
-
-
-
-
-
-
-
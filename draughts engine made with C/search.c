@@ -15,34 +15,172 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "var.h"
 #include "functions.h"
 #include <string.h>
 #include <time.h>
 #include <math.h>
 #include <signal.h>
+#ifdef USE_THREADS
+#include <pthread.h>
+#endif
 
 static int deepning[32]={20, 33, 53, 67, 77, 86, 94, 100, 106, 111, 115, 119, 123, 127, 130, 133, 136, 139, 142, 144, 146, 149, 151, 153, 155, 157, 158, 160, 162, 164, 165, 167}; /* near-logarithmic function */
-int stopflag=false;
-int max_ext_depth;
-int current_move[MAXPLY];
+LOCAL volatile int stopflag=false;  /* set by SIGINT, the timer and the interface to end the search */
+LOCAL volatile int pondering=false;  /* think searches on the opponent's time, see ponder_hit */
+LOCAL int max_ext_depth;
+LOCAL int current_move[MAXPLY];
+static int lmr[LMRDEPTH][MAXNM]; /* late move reduction in 1/100 ply by depth and move number */
+LOCAL char multipv_pv[MAXMULTIPV][MPV][MOVEL]; /* lines of the last search_multipv, best first */
+LOCAL int multipv_score[MAXMULTIPV];
+LOCAL int multipv_n=0;
+static LOCAL char excluded[MAXMULTIPV][MOVEL]; /* root moves alfabeta skips */
+static LOCAL int nexcluded=0;
+
+/* the clock of the search of a thread. The timer thread and the input
+   readers reach it, and through it stopflag, with search_clock() */
+struct _clock {
+    volatile int *stopflag,*pondering;  /* of the searching thread */
+    volatile int running;  /* the timer thread runs */
+    volatile double deadline;  /* of the timer */
+    volatile double start;  /* wall_time() from which think counts its time */
+    volatile float maxtime;  /* of think */
+#ifdef USE_THREADS
+    pthread_t thread;
+#endif
+};
+static LOCAL struct _clock clock_state;
+struct _clock *main_clock=NULL;  /* of the thread that set up the program, the one SIGINT stops */
 
 #define USEHASH 200
 
+/* stages of the move picker */
+#define PICK_FIRST 0
+#define PICK_KILLER 1
+#define PICK_SCORE 2
+#define PICK_REST 3
+
+typedef struct {
+    int stage;
+    int cdepth,nmoves;
+    int first,killer;  /* movelist index of hash and killer move or -1 */
+    int nleft;
+    int left[MAXNM];   /* movelist indices still to pick, in generation order */
+    int score[MAXNM];
+} tpMovePick;
+
+void init_lmr(void)
+/* fill the late move reduction table: about log(depth)*log(movenr)/LMRDIV ply */
+{
+    int d,m,r;
+
+    for(d=0;d<LMRDEPTH;d++) for(m=0;m<MAXNM;m++) {
+        r=0;
+        if (d>=3 && m>=LMRMOVES) r=(int)(100.0*log(d)*log(m)/LMRDIV)/100*100;
+        if (r>100*(d-2)) r=100*(d-2);
+        lmr[d][m]=r;
+    }
+}
+
 void stopsearch(int sig)
 {
     sig++;
     set_col(31,31);
     printf("Search terminated\n");
     res_col();
-    stopflag=true;
+    /* any thread may get the signal, its own stopflag is the wrong one */
+    if (main_clock!=NULL) clock_stop(main_clock);
+    else stopflag=true;
+}
+
+struct _clock *search_clock(void)
+/* the clock of the calling thread */
+{
+    clock_state.stopflag=&stopflag;
+    clock_state.pondering=&pondering;
+    return(&clock_state);
+}
+
+void clock_stop(struct _clock *c)
+/* end the search of the thread of clock c */
+{
+    __atomic_store_n(c->stopflag,true,__ATOMIC_RELEASE);
+}
+
+#ifdef USE_THREADS
+static void *timer_loop(void *arg)
+/* timer thread: sets stopflag once the deadline has passed */
+{
+    struct _clock *c=arg;
+    struct timespec ts;
+
+    ts.tv_sec=0;
+    ts.tv_nsec=TIMERSTEP*1000000L;
+    while (c->running==true) {
+        if (wall_time()>=c->deadline) {
+            clock_stop(c);
+            break;
+        }
+        nanosleep(&ts,NULL);
+    }
+    return(arg);
+}
+#endif
+
+void start_timer(double seconds)
+/* stop the search after seconds of wall-clock time. With threads a timer
+   thread watches the clock, otherwise evalboard polls search_deadline */
+{
+#ifdef USE_THREADS
+    struct _clock *c=search_clock();
+
+    c->deadline=wall_time()+seconds;
+    c->running=true;
+    if (pthread_create(&c->thread,NULL,timer_loop,c)==0) return;
+    c->running=false;
+#endif
+    search_deadline=wall_time()+seconds;
+}
+
+void stop_timer(void)
+{
+#ifdef USE_THREADS
+    if (clock_state.running==true) {
+        clock_state.running=false;
+        pthread_join(clock_state.thread,NULL);
+    }
+#endif
+    search_deadline=0;
+}
+
+static void set_timer(struct _clock *c,double seconds)
+/* move the deadline of a running timer to seconds from now */
+{
+#ifdef USE_THREADS
+    if (c->running==true) {
+        c->deadline=wall_time()+seconds;
+        return;
+    }
+#endif
+    if (search_deadline>0) search_deadline=wall_time()+seconds;
+}
+
+void ponder_hit(struct _clock *c)
+/* the opponent played the expected move: from now on the pondering
+   search of think with clock c runs on its own time */
+{
+    if (*c->pondering==false) return;
+    c->start=wall_time();
+    if (c->maxtime>0) set_timer(c,TIMEHARD*c->maxtime);
+    *c->pondering=false;
 }
 
 void analysePosition(float maxtime)
 {
     int d;
     int m,oppex;
-    float time1;
+    double time1;
     int nmoves,score;
     int depth;
     int stop;
@@ -57,13 +195,14 @@ void analysePosition(float maxtime)
     
     d=400;
     
-    time1=clock();
+    time1=wall_time();
     init_hash();
     set_eval();
     init_tstats();
     
     stop=false;
     stopflag=false;
+    start_timer(maxtime);
     
     winprint("\n");
     winprint("STARTANALYSEPOS\n");
@@ -76,7 +215,7 @@ void analysePosition(float maxtime)
         exactSc[m]=false;
     }
     
-    while((clock()-time1)/CLOCKS_PER_SEC<maxtime && stop==false && d<100*(MAXPLY-20)) {
+    while(wall_time()-time1<maxtime && stop==false && d<100*(MAXPLY-20)) {
         nmoves=move_list(0,game_color);
         bestScorePreviousDepth=bestscore;
         bestscore=-INF;
@@ -114,6 +253,7 @@ void analysePosition(float maxtime)
                 moveDepth[m]=d2;
                 if (score>bestscore) { bestscore=score; }
                 if (stopflag==true) {
+                    stop_timer();
                     winprint("THINK|0\n");
                     return;
                 }
@@ -122,11 +262,12 @@ void analysePosition(float maxtime)
                 winprint("|%i|%.3f|%i|",d2/100+1,score/1000.0F,exact);
                 print_move(PV[1][1]);
                 winprint("\n");
-                if ((clock()-time1)/CLOCKS_PER_SEC>maxtime) { stop=true; break; }
+                if (wall_time()-time1>maxtime) { stop=true; break; }
             }
         }
         d+=100;
     }
+    stop_timer();
     winprint("THINK|0\n");
     
 }
@@ -165,13 +306,13 @@ void analyseGame(int anaWhite,int anaBlack,float maxtime,int threshold,int batch
     int myScore;
     int userScore;
     int col;
-    float time;
+    double time;
     char buffer[MAXCOMMENT];
     int maxp;
     float timePerMove=0.1;
     int ncomment;
     char myPV[MPV][MOVEL];
-    float totTime;
+    double totTime;
     
     winprint("\n");
     winprint("STARTANALYSEGAME\n");
@@ -180,15 +321,15 @@ void analyseGame(int anaWhite,int anaBlack,float maxtime,int threshold,int batch
     init_tstats();
     useBlockingPlay=true;
     
-    totTime=clock();
+    totTime=wall_time();
     d=0;
     for (i=0;i<game_history_max;i++) {
         strcpy(game_history[i].tmp,game_history[i].comment);
     }
-    while((clock()-totTime)/CLOCKS_PER_SEC<maxtime && stopflag==false && d<100*(MAXPLY-20)) {
+    while(wall_time()-totTime<maxtime && stopflag==false && d<100*(MAXPLY-20)) {
         ncomment=0;
         for (i=0;i<game_history_max;i++) {
-            if ((float)(clock()-totTime)/CLOCKS_PER_SEC>maxtime) break;
+            if (wall_time()-totTime>maxtime) break;
             col=game_color^((i-game_history_nr)&1);
             if (((col==white && anaWhite==1) || (col==black && anaBlack==1))) {
                 decompress_board(board,game_history[i].board);
@@ -199,8 +340,8 @@ void analyseGame(int anaWhite,int anaBlack,float maxtime,int threshold,int batch
                     baseScore=alfabeta(-INF,INF,col,0,200,0,&oppex);
                     
                     d=400;
-                    time=clock();
-                    while((clock()-time)<0.5*CLOCKS_PER_SEC*timePerMove && d<(100*(MAXPLY-20))) {
+                    time=wall_time();
+                    while(wall_time()-time<0.5*timePerMove && d<(100*(MAXPLY-20))) {
                         init_stats();
                         d2=d;
                         myScore=alfabeta(-INF,INF,col,0,d,0,&oppex);
@@ -273,13 +414,63 @@ void analyseGame(int anaWhite,int anaBlack,float maxtime,int threshold,int batch
     set_pieces();
     useBlockingPlay=false;
 }
+
+/* what the time allocation of play and think keeps between iterations */
+typedef struct {
+    float instability;          /* halved every iteration */
+    int prevscore;
+    char prevmove[MOVEL];
+    float tprev;                /* seconds of the previous iteration, 0 before */
+    int dprev;                  /* and its depth */
+} tpTimeAlloc;
+
+static void time_init(tpTimeAlloc *ta)
+{
+    ta->instability=0;
+    ta->prevscore=0;
+    ta->prevmove[0]=0;
+    ta->tprev=0;
+    ta->dprev=0;
+}
+
+static int time_next(tpTimeAlloc *ta,char *move,int score,int d,float t1,double t,
+                     float maxtime,int twoply)
+/* after the iteration of depth d, that took t1 of the t seconds since the
+   start and found move with score: the depth step to the next iteration,
+   200 with twoply if two more plies fit easily, 0 if the next one would
+   not end in time. A new best move or a falling score asks for more time,
+   a best move that holds over the iterations for less */
+{
+    float stability,branchFactor;
+    int step=100;
+
+    ta->instability/=2;
+    if (ta->prevmove[0]!=0 && movecmp(move,ta->prevmove)!=0) ta->instability+=1.0;
+    if (ta->prevmove[0]!=0 && score<ta->prevscore-TIMEDROP) ta->instability+=1.0;
+    movecopy(ta->prevmove,move);
+    ta->prevscore=score;
+    if (ta->tprev>0) {
+        stability=TIMESTABLE+ta->instability*TIMEUNSTABLE;
+        if (stability>TIMEMAXFACTOR) stability=TIMEMAXFACTOR;
+        branchFactor=t1/ta->tprev;
+        if (branchFactor<1.0) branchFactor=1.0;
+        if (branchFactor>6.0) branchFactor=6.0;
+        if (d-ta->dprev>100) branchFactor=sqrt(branchFactor);
+        if (t1*branchFactor+t>TIMEFACTOR*stability*maxtime) return(0);
+        if (twoply==true && t1*branchFactor*branchFactor+t<0.8*stability*maxtime && branchFactor<3.0F) step=200;
+    }
+    ta->tprev=t1;
+    ta->dprev=d;
+    return(step);
+}
+
 int play(int color, float maxtime, int maxdepth, int verbose)
 /* front end for alpha-beta
    search for player 'color' until maxtime is reached.
    if maxtime=0 search forever.
    */
 {
-    int n,time1,d,score,t,myscore,myd,i,exact;
+    int n,d,score,myscore,myd,i,exact;
     int my_score,my_d,my_time,my_neval,totalman;
     char mymove[32];
     char comment[MAXCOMMENT];
@@ -289,19 +480,16 @@ int play(int color, float maxtime, int maxdepth, int verbose)
     int resign=true;
     int ntest=0;
     float t1;
-    float tstart,tend;
-    float timeFactor;
-    float timeForPreviousIteration;
-    float depthForPreviousIteration;
-    float nextTime;
-    float branchFactor;
-    int dtmp;
+    double time1,tstart,tend,t;
+    tpTimeAlloc ta;
+    int dprev;
     int allExact;
+    int dtwScore[MAXNM];
     int best;
     int nr;
     
     lastSearchDepth=0;
-    tstart=clock();
+    tstart=wall_time();
     winprint("\n");
     winprint("CLEARPV\n");
     winprint("THINK|1\n");
@@ -353,9 +541,9 @@ int play(int color, float maxtime, int maxdepth, int verbose)
     allExact=true;
     best=-INF;
     
+    theoreticDTW_batch(color^1,0,n,dtwScore);
     for(nr=0;nr<n;nr++) {
-        do_move(movelist[0][nr]);
-        score=theoreticDTW(color^1);
+        score=dtwScore[nr];
         if (score==UNKNOWN) {
             allExact=false;
         } else {
@@ -364,7 +552,6 @@ int play(int color, float maxtime, int maxdepth, int verbose)
                 movecopy(mymove,movelist[0][nr]);
             }
         }
-        undo_move(movelist[0][nr]);
     }
     if (allExact==true && best!=0 && best>LOSE && best<WIN) {
         winprint("\n");
@@ -398,24 +585,20 @@ int play(int color, float maxtime, int maxdepth, int verbose)
 notexact:
     d=100;
     signal(SIGINT,stopsearch);
-    time1=clock();
+    time1=wall_time();
     init_hash();
     init_tstats();
-    t=-clock();
-    
-    timeFactor=1.35;    
-    
-    timeForPreviousIteration=0;
-    depthForPreviousIteration=0;
+    if (maxtime>0) start_timer(TIMEHARD*maxtime);
+    time_init(&ta);
     while((/*((clock()-time1)<timeFactor*CLOCKS_PER_SEC*maxtime || maxtime==0) &&*/ d<=maxdepth && d<100*(MAXPLY-10)) || d==100 ) {
         init_stats();
         max_ext_depth=(d/100)+4;
-        t1=clock();
+        t1=wall_time();
         /*plyscore[d/100]=score=alfabeta(-INF,INF,color,0,d,0,&exact);*/
         if (eval_type==3) {
             plyscore[d/100]=score=probalfabeta(-INF,INF,color,0,d,0,&exact);
         } else {
-            plyscore[d/100]=score=alfabeta(-INF,INF,color,0,d,0,&exact);
+            plyscore[d/100]=score=search_root(color,d,d==100 ? UNKNOWN : my_score,&exact);
         }
         lastSearchDepth=d;
         if (verbose>=0) printf(" (%i) ",exact);
@@ -424,6 +607,8 @@ notexact:
             my_score=score;
             my_d=d;
             my_neval=neval;
+            multipv_n=0;
+            if (multipv>1 && eval_type!=3) search_multipv(color,d,score);
         }
         else {
             if (verbose>0) {
@@ -436,19 +621,21 @@ notexact:
             }
             break;
         }
-        t1=(clock()-t1)/CLOCKS_PER_SEC;
+        t1=wall_time()-t1;
+        t=wall_time()-time1;
         if (verbose>3) {
             set_col(33,33);
-            if ((verbose>5 && ((double) t/CLOCKS_PER_SEC)>1.0) || verbose>9) printf("\n");
+            if ((verbose>5 && t>1.0) || verbose>9) printf("\n");
             printf("depth:%2i   ",d/100);
             printf("s:%.3f t:%.1f   ",score/1000.0F,(float) t1);
             if (windows==false) {
                 print_pv();
+                if (multipv_n>1) print_multipv(d,t1);
             }
             res_col();
-            if ((windows==false || verbose>5 && ((double) t/CLOCKS_PER_SEC)>3.0) || verbose>9) {
+            if ((windows==false || verbose>5 && t>3.0) || verbose>9) {
                 print_stats();
-                if ( ((double) t/CLOCKS_PER_SEC)>60.0) beep();
+                if (t>60.0) beep();
             }
             fflush(stdout);
         }
@@ -459,38 +646,19 @@ notexact:
             winprint("|");
             print_stats();
             winprint("\n");
+            if (multipv_n>1) print_multipv(d,t1);
         }
         if (score==WIN || score==LOSE) break;
-        dtmp=d;
-        if (timeForPreviousIteration>0) {
-            float timeTilNow=((float)clock()-time1)/CLOCKS_PER_SEC;
-                
-            branchFactor=t1/timeForPreviousIteration;
-            if (branchFactor<1.0) branchFactor=1.0;
-            if (branchFactor>6.0) branchFactor=6.0;
-            if (d-depthForPreviousIteration>100) branchFactor=sqrt(branchFactor);
-            
-            nextTime=t1*branchFactor+timeTilNow;
-            //printf("curtime: %.2f nexttime: %.2f factor:%.2f  %f\n",timeTilNow,nextTime,branchFactor,t1);
-            if (nextTime>timeFactor*maxtime && d!=100 ) break;
-
-            nextTime=t1*branchFactor*branchFactor+timeTilNow;
-            //printf("curtim2: %.2f nexttime: %.2f factor:%.2f  %f\n",timeTilNow,nextTime,branchFactor,t1);
-            if (allowTwoPlyIncrements==true && nextTime<0.8*maxtime && branchFactor<3.0F) d+=100;
-        }
-        d+=100;
-            
-        /*if (eval_type==1 && (clock()-time1)<0.3*CLOCKS_PER_SEC*maxtime) d+=100;*/
-
-        timeForPreviousIteration=t1;
-        depthForPreviousIteration=dtmp;
-
+        dprev=d;
+        d+=time_next(&ta,mymove,score,d,t1,t,maxtime,allowTwoPlyIncrements);
+        if (d==dprev) break;
     }
-    t+=clock();
+    stop_timer();
+    t=wall_time()-time1;
         
     signal(SIGINT,SIG_DFL);
     stopflag=false;
-    sprintf(comment,"[%%eval %.3f][%%egt 0:0:%.2f][%%depth %i][%%nodes %i]",(float)(my_score/1000.0F),(float) t/CLOCKS_PER_SEC,my_d/100,my_neval);
+    sprintf(comment,"[%%eval %.3f][%%egt 0:0:%.2f][%%depth %i][%%nodes %i]",(float)(my_score/1000.0F),(float) t,my_d/100,my_neval);
     if (mymove[0]==0) { /* no move was selected; they all lose */
         movecopy(mymove,movelist[0][0]);
     }
@@ -525,12 +693,248 @@ notexact:
     }
     winprint("\n");
     winprint("THINK|0\n");
-    tend=clock();
-    timeUsed[color]+=(tend-tstart)/CLOCKS_PER_SEC+operator_time;
+    tend=wall_time();
+    timeUsed[color]+=(tend-tstart)+operator_time;
 
     return(score);
 }
 
+int think(int color,float maxtime,int maxdepth,char *bestmove,char *pondermove,
+          void (*report)(int,int,double,INT64))
+/* iterative deepening for the protocol front ends: as play, but the move
+   is not made and nothing is printed, every finished iteration goes to
+   report (if not NULL), the multipv lines with sprint_multipv. Searches until maxdepth, until maxtime is used
+   (0 is no limit) or until stopflag, which the caller clears. While
+   pondering is set the time does not run and the search does not end
+   before ponder_hit or stopflag. The move and the expected reply go to
+   bestmove and pondermove; returns the score of the last iteration */
+{
+    int n,d,score,myscore=0,exact;
+    int step=100;
+    double t,t1;
+    tpTimeAlloc ta;
+    INT64 nodes=0;
+
+    bestmove[0]=0;
+    pondermove[0]=0;
+    n=move_list(0,color);
+    if (n==0) return(-INF);
+    movecopy(bestmove,movelist[0][0]);
+    set_eval();
+    init_hash();
+    init_tstats();
+    clock_state.maxtime=maxtime;
+    clock_state.start=wall_time();
+    if (maxtime>0) start_timer(pondering==true ? 1E9 : TIMEHARD*maxtime);
+    time_init(&ta);
+    for(d=100;d<=maxdepth && d<100*(MAXPLY-10);d+=step) {
+        if (n==1 && pondering==false) break;
+        init_stats();
+        max_ext_depth=(d/100)+4;
+        t1=wall_time();
+        if (eval_type==3) score=probalfabeta(-INF,INF,color,0,d,0,&exact);
+        else score=search_root(color,d,d==100 ? UNKNOWN : myscore,&exact);
+        nodes+=neval+nmovelist;
+        if (stopflag==true) break;
+        myscore=score;
+        multipv_n=0;
+        if (multipv>1 && eval_type!=3) search_multipv(color,d,score);
+        if (PV[0][0][0]!=0) {
+            movecopy(bestmove,PV[0][0]);
+            if (PV[0][1][0]!=0) movecopy(pondermove,PV[0][1]);
+            else pondermove[0]=0;
+        }
+        t1=wall_time()-t1;
+        t=wall_time()-clock_state.start;
+        if (report!=NULL) report(d,score,t,nodes);
+        if (score==WIN || score==LOSE) break;
+
+        step=time_next(&ta,bestmove,score,d,t1,t,maxtime,false);
+        if (maxtime==0 || pondering==true) step=100;
+        if (step==0) break;
+    }
+#ifdef USE_THREADS
+    while (pondering==true && stopflag==false) {
+        struct timespec ts;
+
+        ts.tv_sec=0;
+        ts.tv_nsec=TIMERSTEP*1000000L;
+        nanosleep(&ts,NULL);
+    }
+#endif
+    stop_timer();
+    return(myscore);
+}
+
+int search_root(int color,int depth,int guess,int *exact)
+/* alfa-beta from the root in an aspiration window around guess, the score
+   of the previous iteration. A search that fails low or high is repeated
+   with that side of the window widened four times, until it is open.
+   guess=UNKNOWN searches with the full window */
+{
+    int lo,hi,delta=ASPWINDOW,score;
+
+    if (use_pvs==false || guess==UNKNOWN || guess<=-ASPLIMIT || guess>=ASPLIMIT) {
+        return(alfabeta(-INF,INF,color,0,depth,0,exact));
+    }
+    lo=guess-delta; hi=guess+delta;
+    while (true) {
+        score=alfabeta(lo,hi,color,0,depth,0,exact);
+        if (stopflag==true) return(score);
+        if (score<=lo && lo>-INF) {
+            delta*=4;
+            lo=(delta>=ASPLIMIT) ? -INF : guess-delta;
+        }
+        else if (score>=hi && hi<INF) {
+            delta*=4;
+            hi=(delta>=ASPLIMIT) ? INF : guess+delta;
+        }
+        else return(score);
+    }
+}
+
+int root_excluded(char *move)
+/* true if move is excluded from the root search */
+{
+    int i;
+
+    for(i=0;i<nexcluded;i++) if (movecmp(excluded[i],move)==0) return(true);
+    return(false);
+}
+
+static void extend_pv(char pv[MPV][MOVEL],int color)
+/* lengthen a line cut off by a hash table hit with the hash moves */
+{
+    int i,m,min,max,hd;
+    char hashmove[2];
+
+    for(i=0;i<maxpv && i<MPV-1 && pv[i][0]!=0;i++) {
+        do_move(pv[i]);
+        color^=1;
+    }
+    for(;i<maxpv && i<MPV-1;i++) {
+        if (retreive_hash(color,&min,&max,&hd,hashmove)==UNKNOWN) break;
+        m=find_hashmove(i+1,move_list(i+1,color),hashmove);
+        if (m<0) break;
+        movecopy(pv[i],movelist[i+1][m]);
+        do_move(pv[i]);
+        color^=1;
+    }
+    pv[i][0]=0;
+    while(i>0) undo_move(pv[--i]);
+}
+
+int search_multipv(int color,int depth,int score)
+/* after search_root found the best line with score, search the next
+   multipv-1 best root moves, each with a full window excluding the root
+   moves of the lines before it. The lines go to multipv_pv/multipv_score,
+   PV[0] is left at the best line. Returns the number of lines */
+{
+    int i,k,n,exact;
+
+    for(i=0;i<MPV;i++) movecopy(multipv_pv[0][i],PV[0][i]);
+    multipv_score[0]=score;
+    n=move_list(0,color);
+    for(k=1;k<multipv && k<n;k++) {
+        movecopy(excluded[nexcluded++],multipv_pv[k-1][0]);
+        for(i=0;i<MPV;i++) PV[0][i][0]=0;
+        score=alfabeta(-INF,INF,color,0,depth,0,&exact);
+        if (stopflag==true) break;
+        for(i=0;i<MPV;i++) movecopy(multipv_pv[k][i],PV[0][i]);
+        multipv_score[k]=score;
+    }
+    nexcluded=0;
+    for(i=0;i<MPV;i++) movecopy(PV[0][i],multipv_pv[0][i]);
+    multipv_n=k;
+    for(k=0;k<multipv_n;k++) extend_pv(multipv_pv[k],color);
+    return(multipv_n);
+}
+
+void print_multipv(int depth,float t)
+/* report the lines of the last search_multipv */
+{
+    int i,k;
+
+    for(k=0;k<multipv_n;k++) {
+        if (windows==true) {
+            winprint("\n");
+            winprint("MULTIPV|%i|%i|%.3f|%.1f|",depth/100,k+1,multipv_score[k]/1000.0F,t);
+        }
+        else printf("    %i. s:%.3f pv: ",k+1,multipv_score[k]/1000.0F);
+        for(i=0;i<MPV && multipv_pv[k][i][0]!=0;i++) {
+                print_move(multipv_pv[k][i]);
+                dprint(" ");
+            }
+        if (windows==true) winprint("\n");
+        else printf("\n");
+    }
+}
+
+int sprint_multipv(int k,char *out,int *score)
+/* line k, best first, of the last search_multipv in hub notation, for
+   the report function of think. False if there is no such line */
+{
+    if (k<0 || k>=multipv_n) return(false);
+    sprint_pv_hub(out,multipv_pv[k]);
+    *score=multipv_score[k];
+    return(true);
+}
+
+/* positions searched by bench: the opening position and positions
+   from engine games, written as for set_board_string */
+static char *bench_positions[]={
+    "Wbbbbbbbbbbbbbbbbbbbbeeeeeeeeeewwwwwwwwwwwwwwwwwwww",
+    "Wbbebbbbbbbbebbbbbbebeeeeeeeweewewwwwweewewwwwwwwww",
+    "Wbbebbbbbbeeeebbbeebbebeeeeeeeeewwwweewwweeewwwwwww",
+    "Wbbeeeeebbbbebbbbeebbeeeeebeweewewwweeewweeewwewwww",
+    "Wbbeeeeebebbebbbeeeeebebeeeeeeweeeweeeewwweeweewwww",
+    "Wbebbbbbbbbbbbbbbbbeeeebewwwebeeweewwwwwwewwwwwwwww",
+    "Wbebbeebbbbbbbeebbbeeebeewwwbeewwewewewwewewweeweww",
+    "WbebeeeeeeebbeebeeeeebeeeeeeeeeweeeeeeweeeeweeBweww",
+    "Wbbbbbbbbebbbebbbebebbeebeeweeeewwwwewwwwwwwwwwwwwe",
+    "Wbbebebebebbbeeebebeebeebbbwweewweweewwewewweewwwwe",
+    "Wbbebeebbeebbeeeeeeeebewbbbeeeeeeewewwwwweweeeewwwe",
+    NULL
+};
+
+void bench(int depth)
+/* searches every bench position to a fixed depth in plies and reports the
+   nodes (evaluations plus move generations) and the time used */
+{
+    int i,d,color,score,exact;
+    INT64 nodes,total=0;
+    double t,t0,ttotal=0.0;
+    BTYPE save[93];
+
+    copy_board(save,board);
+    set_eval();
+    stopflag=false;
+    for(i=0;bench_positions[i]!=NULL;i++) {
+        color=set_board_string(bench_positions[i]);
+        if (color<0) continue;
+        init_hash();
+        init_tstats();
+        nodes=0;
+        score=UNKNOWN;
+        t0=wall_time();
+        for(d=100;d<=100*depth;d+=100) {
+            init_stats();
+            max_ext_depth=(d/100)+4;
+            score=search_root(color,d,d==100 ? UNKNOWN : score,&exact);
+            nodes+=neval+nmovelist;
+        }
+        t=wall_time()-t0;
+        dprint("bench %2i: score %7.3f nodes %12llu time %6.2f  ",i+1,score/1000.0F,nodes,t);
+        print_move(PV[0][0]);
+        dprint("\n");
+        total+=nodes;
+        ttotal+=t;
+    }
+    dprint("bench depth %i pvs %i lmr %i shots %i: nodes %llu time %.2f nps %.0f\n",depth,use_pvs,use_lmr,use_shots,total,ttotal,ttotal>0 ? total/ttotal : 0.0);
+    copy_board(board,save);
+    set_pieces();
+}
+
 void resume(void)
 {
     ;
@@ -541,7 +945,7 @@ void print_pv(void)
     int i;
 
     printf("pv: ");
-    for(i=0;i<MPV;i++) if (PV[0][i][0]!=0) {
+    for(i=0;i<MPV && PV[0][i][0]!=0;i++) {
             print_move(PV[0][i]);
             dprint(" ");
         }
@@ -654,19 +1058,59 @@ void init_rephash(void)
 }
 
 
+/* bumped by init_hash; stale eval cache entries then fail the signature test */
+static LOCAL unsigned int evalgen=0;
+
+/* true if the hash table of this thread is shared with other engine
+   threads (share_hash). Its entries are then read and written under the
+   locks of hash_lock and init_hash leaves the table to the other threads */
+static LOCAL int shared_hash=false;
+#ifdef USE_THREADS
+static char hash_locks[HASHLOCKS];
+
+static void hash_lock(int entry,int lock)
+/* take or release the locks of entry and entry+1, lowest lock first */
+{
+    int a=entry&(HASHLOCKS-1),b=(entry+1)&(HASHLOCKS-1),t;
+
+    if (b<a) {t=a; a=b; b=t;}
+    if (lock==true) {
+        while (__atomic_test_and_set(&hash_locks[a],__ATOMIC_ACQUIRE)) ;
+        while (__atomic_test_and_set(&hash_locks[b],__ATOMIC_ACQUIRE)) ;
+    } else {
+        __atomic_clear(&hash_locks[b],__ATOMIC_RELEASE);
+        __atomic_clear(&hash_locks[a],__ATOMIC_RELEASE);
+    }
+}
+#else
+#define hash_lock(entry,lock)
+#endif
+
+void share_hash(tpTranspos *table,int size)
+/* use table of size entries as the hash table of this thread, shared
+   with other threads: the table of another thread, or on the thread that
+   made it, its own table once others use it */
+{
+    shared_hash=true;
+    transpos=table;
+    tablesize=size;
+}
+
 void init_hash(void)
 {
     int i;
 
+    if (shared_hash==true) {
+        evalgen++;
+        init_rephash();
+        return;
+    }
     for(i=0;i<tablesize;i++) {
         transpos[i].hashkey=-1;
         transpos[i].board[0]=invalid;
         transpos[i].depth=0;
     }
-    for(i=0;i<MAXEVAL;i++) {
-        evalcache[i].hashkey=-1;
-        evalcache[i].board[0]=invalid;
-    }
+    evalgen++;
     init_rephash();
 }
 
@@ -680,38 +1124,72 @@ unsigned int hash_key(int color)
     return(key+2*color);
 }
 
-int retreive_eval(int color)
-/* retreive the current position from the hash table */
+/* eval cache entries are read and written as one 64 bit word, so threads
+   sharing the table never see a torn signature/score pair */
+#ifdef USE_THREADS
+    #define EVAL_LOAD(p) __atomic_load_n(p,__ATOMIC_RELAXED)
+    #define EVAL_STORE(p,v) __atomic_store_n(p,v,__ATOMIC_RELAXED)
+#else
+    #define EVAL_LOAD(p) (*(p))
+    #define EVAL_STORE(p,v) (*(p)=(v))
+#endif
+
+static unsigned INT64 eval_key(int color)
 {
-    int i,entry;
-    unsigned int key;
-    unsigned char temp[18];
+    return(pos_key^(color==white?0ULL:0xD1B54A32D192ED03ULL));
+}
 
-    key=hash_key(color);
-    entry=key%MAXEVAL;
+static unsigned int eval_signature(unsigned INT64 key)
+{
+    return((unsigned int) (key>>32)^(evalgen*0x9E3779B9U));
+}
 
-    if (key!=evalcache[entry].hashkey) {
-        return(UNKNOWN);
+int setEvalHash(int mb)
+/* (re)allocates the eval cache with the largest power of 2 number of entries
+   that fits in 'mb' megabytes. Returns the number of entries */
+{
+    unsigned INT64 n=1,*table;
+
+    while(2*n*sizeof(evaltable[0])<=(unsigned INT64) mb*1024*1024) n*=2;
+    if (n<1024) n=1024;
+    table=(unsigned INT64*) calloc(n,sizeof(evaltable[0]));
+    while(table==NULL && n>1024) {
+        n/=2;
+        table=(unsigned INT64*) calloc(n,sizeof(evaltable[0]));
     }
-    strong_compress_board(temp,board); temp[17]=color;
-    for(i=0;i<18;i++) if (evalcache[entry].board[i]!=temp[i]) return(UNKNOWN);
+    if (table==NULL) {
+        dprint("eval cache: out of memory\n");
+        return(evalmask+1);
+    }
+    if (evaltable!=NULL) free(evaltable);
+    evaltable=table;
+    evalmask=n-1;
+    evalgen++;
+    return(n);
+}
+
+int retreive_eval(int color)
+/* retreive the current position from the eval cache */
+{
+    unsigned INT64 key,entry;
+
+    if (evaltable==NULL) return(UNKNOWN);
+    neprobe++;
+    key=eval_key(color);
+    entry=EVAL_LOAD(&evaltable[key&evalmask]);
+    if ((unsigned int) (entry>>32)!=eval_signature(key)) return(UNKNOWN);
     outeval++;
-    return(evalcache[entry].score);
+    return((int) (unsigned int) entry);
 }
 
 void store_eval(int color,int score)
-/* store the current position in the hash table */
+/* store the current position in the eval cache */
 {
-    int entry;
-    unsigned int key;
-
-    key=hash_key(color);
-    entry=key%MAXEVAL;
+    unsigned INT64 key;
 
-    evalcache[entry].hashkey=key;
-    evalcache[entry].score=score;
-    strong_compress_board(evalcache[entry].board,board);
-    evalcache[entry].board[17]=color;
+    if (evaltable==NULL) return;
+    key=eval_key(color);
+    EVAL_STORE(&evaltable[key&evalmask],((unsigned INT64) eval_signature(key)<<32) | (unsigned int) score);
     ineval++;
 }
 
@@ -721,22 +1199,31 @@ int retreive_hash(int color,int *min, int *max,int *hd,char *move)
     int i,entry;
     unsigned int key;
     unsigned char temp[18];
+    tpTranspos *t,copy[2];
 
     key=hash_key(color);
     entry=key%tablesize;
+    t=&transpos[entry];
+    if (shared_hash==true) {
+        /* work on a copy that no other thread writes */
+        hash_lock(entry,true);
+        copy[0]=t[0]; copy[1]=t[1];
+        hash_lock(entry,false);
+        t=copy;
+    }
 
-    if (key!=transpos[entry].hashkey) {
-        entry++;
-        if (key!=transpos[entry].hashkey) return(UNKNOWN);
+    if (key!=t->hashkey) {
+        t++;
+        if (key!=t->hashkey) return(UNKNOWN);
     }
     strong_compress_board(temp,board); temp[17]=color;
-    for(i=0;i<18;i++) if (transpos[entry].board[i]!=temp[i]) return(UNKNOWN);
+    for(i=0;i<18;i++) if (t->board[i]!=temp[i]) return(UNKNOWN);
     outhash++;
-    *min=transpos[entry].min_score;
-    *max=transpos[entry].max_score;
-    *hd=transpos[entry].depth;
-    move[0]=transpos[entry].move[0];
-    move[1]=transpos[entry].move[1];
+    *min=t->min_score;
+    *max=t->max_score;
+    *hd=t->depth;
+    move[0]=t->move[0];
+    move[1]=t->move[1];
     return(!UNKNOWN);
 }
 
@@ -749,6 +1236,7 @@ void store_hash(int color,int depth,int min,int max,char *move)
     key=hash_key(color);
     entry=key%tablesize;
 
+    if (shared_hash==true) hash_lock(entry,true);
     if (transpos[entry].depth>depth) {
         transpos[entry+1]=transpos[entry];
     }
@@ -760,6 +1248,7 @@ void store_hash(int color,int depth,int min,int max,char *move)
     transpos[entry].depth=depth;
     transpos[entry].move[0]=move[1];
     transpos[entry].move[1]=move[move[0]-1];
+    if (shared_hash==true) hash_lock(entry,false);
     inhash++;
 }
 
@@ -785,128 +1274,109 @@ void sort_viahash(int level,int nmoves,char *hashmove,int depth,int color)
     print_move(hashmove);
 }
 
-void findkiller(int level,int nmoves)
+int find_move(int level,int nmoves,char *move)
+/* index of move in the movelist, -1 if absent */
 {
     int i;
-    char temp[32];
 
-    for(i=0;i<nmoves;i++) if (movecmp(movelist[level][i],killer[level])==0) {
-            movecopy(temp,movelist[level][0]);
-            movecopy(movelist[level][0],movelist[level][i]);
-            movecopy(movelist[level][i],temp);
-            break;
-        }
+    for(i=0;i<nmoves;i++) if (movecmp(movelist[level][i],move)==0) return(i);
+    return(-1);
 }
 
-int quiet_crown(int p,int color)
+int find_hashmove(int level,int nmoves,char *hashmove)
+/* index of the move with the from and to fields of a hash move, -1 if absent */
 {
-    int d,pp,eneman,enecrown;
-
-    eneman=man|!color;enecrown=crown|!color;
+    int i;
 
-    for(d=0;d<4;d++) {
-        pp=p;
-        do pp=next[color][pp][d]; while(board[pp]==empty);
-        if (board[pp]==eneman || board[pp]==enecrown) if (board[next[color][pp][d]]==empty) return(false);
-    }
-    return(true);
+    for(i=0;i<nmoves;i++) if (movelist[level][i][1]==hashmove[0] && movelist[level][i][(int)movelist[level][i][0]-1]==hashmove[1]) return(i);
+    return(-1);
 }
 
-int wnc_quiet()
+static void init_picker(tpMovePick *mp,int level,int nmoves,int first)
+/* start picking the moves of movelist[level], first (or -1) goes first */
 {
-    int ip,p;
-
-    for(ip=5;ip<50;ip++) {
-        p=map[ip];
-        if (board[p] == (white|man)) {
-            if (board[p-7]==(black|man)) if (board[p-14]==empty) return(false);
-            if (board[p-6]==(black|man)) if (board[p-12]==empty) return(false);
-            if (board[p+7]==(black|man)) if (board[p+14]==empty) return(false);
-            if (board[p+6]==(black|man)) if (board[p+12]==empty) return(false);
-        }
-    }
-    nquietfail++;
-    return(true);
+    mp->stage=PICK_FIRST;
+    mp->cdepth=level;
+    mp->nmoves=nmoves;
+    mp->first=first;
+    mp->killer=-1;
+    mp->nleft=0;
 }
 
-int w_quiet()
+static int pick_move(tpMovePick *mp)
+/* return the movelist index of the next move to search or -1 when done.
+   Stages: the first (hash) move, the killer (kill method KILLER, the
+   PROBKILL history already prefers it), then the other moves which are
+   scored only once they are needed and picked highest score first. */
 {
-    int ip,p,d,pp;
-
-    if (pieces[white|crown]==0 && pieces[black|crown]==0) return(wnc_quiet());
-    for(ip=0;ip!=50;ip++) {
-        p=map[ip];
-        if (board[p] == (white|man)) {
-            if (board[p-7]==(black|man) || board[p-7]==(black|crown)) if (board[p-14]==empty) return(false);
-            if (board[p-6]==(black|man) || board[p-6]==(black|crown)) if (board[p-12]==empty) return(false);
-            if (board[p+7]==(black|man) || board[p+7]==(black|crown)) if (board[p+14]==empty) return(false);
-            if (board[p+6]==(black|man) || board[p+6]==(black|crown)) if (board[p+12]==empty) return(false);
+    int i,b,mnr,lm,level;
+
+    level=mp->cdepth;
+    switch(mp->stage) {
+    case PICK_FIRST:
+        mp->stage=PICK_KILLER;
+        if (mp->first>=0) return(mp->first);
+        /* fall through */
+    case PICK_KILLER:
+        mp->stage=PICK_SCORE;
+        if (kill_method==KILLER) mp->killer=find_move(level,mp->nmoves,killer[level]);
+        if (mp->killer==mp->first) mp->killer=-1;
+        if (mp->killer>=0) return(mp->killer);
+        /* fall through */
+    case PICK_SCORE:
+        mp->stage=PICK_REST;
+        lm=0;
+        if (kill_method==PROBKILL && level>0) lm=move_nr(movelist[level-1][current_move[level-1]]);
+        for(i=0;i<mp->nmoves;i++) if (i!=mp->first && i!=mp->killer) {
+            mnr=move_nr(movelist[level][i]);
+            if (kill_method==PROBKILL) mp->score[mp->nleft]=2*history[level][mnr][mp->nmoves]+countermove[level&1][lm][mnr];
+            else if (kill_method==HISTORY) mp->score[mp->nleft]=history[level][mnr][0];
+            else mp->score[mp->nleft]=0;
+            mp->left[mp->nleft++]=i;
         }
-        else if (board[p] ==(white|crown)) {
-            for(d=0;d<4;d++) {
-                pp=p;
-                do pp=next[white][pp][d]; while(board[pp]==empty);
-                if (board[pp]==(black|man) || board[pp]==(black|crown)) if (board[next[white][pp][d]]==empty) return(false);
-            }
+        /* fall through */
+    case PICK_REST:
+        if (mp->nleft==0) return(-1);
+        b=0;
+        for(i=1;i<mp->nleft;i++) if (mp->score[i]>mp->score[b]) b=i;
+        i=mp->left[b];
+        mp->nleft--;
+        for(;b<mp->nleft;b++) {
+            mp->left[b]=mp->left[b+1];
+            mp->score[b]=mp->score[b+1];
         }
+        return(i);
     }
-    nquietfail++;
-    return(true);
+    return(-1);
 }
 
-int bnc_quiet()
+void findkiller(int level,int nmoves)
 {
-    int ip,p;
+    int i;
+    char temp[32];
 
-    for(ip=44;ip>=0;ip--) {
-        p=map[ip];
-        if (board[p] == (black|man)) {
-            if (board[p+7]==(white|man)) if (board[p+14]==empty) return(false);
-            if (board[p+6]==(white|man)) if (board[p+12]==empty) return(false);
-            if (board[p-7]==(white|man)) if (board[p-14]==empty) return(false);
-            if (board[p-6]==(white|man)) if (board[p-12]==empty) return(false);
+    for(i=0;i<nmoves;i++) if (movecmp(movelist[level][i],killer[level])==0) {
+            movecopy(temp,movelist[level][0]);
+            movecopy(movelist[level][0],movelist[level][i]);
+            movecopy(movelist[level][i],temp);
+            break;
         }
-    }
-    nquietfail++;
-    return(true);
 }
 
-
-int b_quiet()
+int quiet_crown(int p,int color)
 {
-    int ip,p,d,pp;
+    int d,pp,eneman,enecrown;
 
-    if (pieces[white|crown]==0 && pieces[black|crown]==0) return(bnc_quiet());
-    for(ip=49;ip>=0;ip--) {
-        p=map[ip];
-        if (board[p] == (black|man)) {
-            if (board[p+7]==(white|man) || board[p+7]==(white|crown)) if (board[p+14]==empty) return(false);
-            if (board[p+6]==(white|man) || board[p+6]==(white|crown)) if (board[p+12]==empty) return(false);
-            if (board[p-7]==(white|man) || board[p-7]==(white|crown)) if (board[p-14]==empty) return(false);
-            if (board[p-6]==(white|man) || board[p-6]==(white|crown)) if (board[p-12]==empty) return(false);
-        }
-        else if (board[p] ==(black|crown)) {
-            for(d=0;d<4;d++) {
-                pp=p;
-                do pp=next[black][pp][d]; while(board[pp]==empty);
-                if (board[pp]==(white|man) || board[pp]==(white|crown)) if (board[next[black][pp][d]]==empty) return(false);
-            }
-        }
+    eneman=man|!color;enecrown=crown|!color;
+
+    for(d=0;d<4;d++) {
+        pp=p;
+        do pp=next[color][pp][d]; while(board[pp]==empty);
+        if (board[pp]==eneman || board[pp]==enecrown) if (board[next[color][pp][d]]==empty) return(false);
     }
-    nquietfail++;
     return(true);
 }
 
-int quiet(int color)
-/* returns false if color can capture, true otherwise */
-{
-    nquiet++;
-    if (color==white) return(w_quiet());
-    else return(b_quiet());
-    printf("fatal: q\n");
-    return(false);
-}
-
 int active(int target,int color,int cdepth,int depth)
 /* if non-active move available/(non-forced): return true if target is met
    else try achieve target with active moves only
@@ -1066,7 +1536,7 @@ int do_presearch(int cdepth,int nmoves,int color,int depth)
             if (e==UNKNOWN) {
                 e=evalboard(color^1,-INF,INF,&prec);
                 if (prec==true) {
-                    store_eval(color,e);
+                    store_eval(color^1,e);
                 }
                 iterscore[nr]=-e-10*move_list(cdepth+1,color^1);
             }
@@ -1081,8 +1551,8 @@ int do_presearch(int cdepth,int nmoves,int color,int depth)
     return(0);
 }
 
-int giterscore[MAXNM];
-char dummymove[32];
+LOCAL int giterscore[MAXNM];
+LOCAL char dummymove[32];
 
 int solve(int alfa,int beta,int color,int cdepth,int depth)
 {
@@ -1145,13 +1615,17 @@ esc:
 int theo_alfabeta(int alfa,int beta,int color,int cdepth,int depth,int exact)
 {
     int best=-INF,nmoves,nr,tscore;
+    int handle[MAXNM];
+    DBINDEX index[MAXNM];
 
     nmoves=move_list(cdepth,color);
     if (nmoves==0) return(LOSE);
+    if (use_db==true) database_index_batch(color^1,cdepth,0,nmoves,-1,handle,index);
+    else for(nr=0;nr<nmoves;nr++) handle[nr]=-1;
 
     for(nr=0;nr<nmoves;nr++) {
         do_move(movelist[cdepth][nr]);
-        tscore=theoretic(color^1);
+        tscore=theoretic_indexed(color^1,handle[nr],index[nr]);
         if (cdepth==0) {
             movescore[nr].value=-tscore;
             movecopy(movescore[nr].move,movelist[cdepth][nr]);
@@ -1176,7 +1650,7 @@ int doSearchExtend(int color)
 {
     int i1,i2,i3,i4,i5,i6;
     int ip,p;
-    static BTYPE temp[93];
+    static LOCAL BTYPE temp[93];
     BTYPE *local;  /* out local board */
 
     /* makesure we work on a white to move board */
@@ -1330,7 +1804,7 @@ int doSearchExtend(int color)
     }
     return false;
 }
-int moveselect[MAXPLY];
+LOCAL int moveselect[MAXPLY];
 
 int probalfabeta(int alfa,int beta,int color,int cdepth,int depth,int flags,int *exact)
 {
@@ -1570,7 +2044,7 @@ abdone:
     if (best!=-1) {
         goodmove2(cdepth,movelist[cdepth][best],nmoves);
     }
-    if (use_hash && depth>USEHASH && alfa>alfa0) store_hash(color,depth,alfa,alfa,movelist[cdepth][best]);
+    if (use_hash && depth>USEHASH && alfa>alfa0 && best!=-1) store_hash(color,depth,alfa,alfa,movelist[cdepth][best]);
     if (atleastdraw==true && atmostdraw==true) *exact=EXACTDRAW;
     else if (atleastdraw==true) *exact=ATLEASTDRAW;
     else if (atmostdraw==true) *exact=ATMOSTDRAW;
@@ -1588,8 +2062,16 @@ int alfabeta(int alfa,int beta,int color,int cdepth,int depth,int flags,int *exa
     int stop;
     int precise;
     int preciseBefPat;
+    int reduce;
+    int m,first=-1;
+    char *mv;
+    tpMovePick mp;
+    int rootex;
+    int ns,nsearch;  /* moves searched and to search, the excluded root moves left out */
     
     *exact=NOTEXACT;
+    rootex=(cdepth==0 && nexcluded>0);  /* multipv: the root hash entries belong to all moves */
+    if (cdepth>0 && cdepth<maxpv) PV[cdepth][cdepth][0]=0;  /* end the line here until a move is stored */
 
     /* try to determen theoretic value */
     score=theoretic(color);
@@ -1671,6 +2153,7 @@ int alfabeta(int alfa,int beta,int color,int cdepth,int depth,int flags,int *exa
 
     if (use_hash && depth>USEHASH) {
         score=retreive_hash(color,&min,&max,&hd,hashmove);
+        if (rootex==true) score=UNKNOWN;
         if (score!=UNKNOWN && hd>=depth) {
             if (min==max) return(min);
             if (min>=beta) return(min);
@@ -1688,7 +2171,7 @@ int alfabeta(int alfa,int beta,int color,int cdepth,int depth,int flags,int *exa
     /* check for beta cut from hash tables */
     if (nmoves==1) goto nosort;
     
-    if (use_hash && depth>=200) {
+    if (use_hash && depth>=200 && rootex==false) {
         if (stopflag==true) return(alfa);
         for(nr=0; nr<nmoves; nr++) {
             do_move(movelist[cdepth][nr]);
@@ -1706,56 +2189,34 @@ int alfabeta(int alfa,int beta,int color,int cdepth,int depth,int flags,int *exa
         }
     }
 
-    /* move ordering */
-    if (hashmove[0]!=0) sort_viahash(cdepth,nmoves,hashmove,depth,color);
-    else if (depth>=800) {
-        do_presearch(cdepth,nmoves,color,depth);
-    }
-    else {
-        if (kill_method==KILLER) findkiller(cdepth,nmoves);
-        else if (kill_method==PROBKILL) {
-            int lm,mnr;
-            lm=move_nr(movelist[cdepth-1][current_move[cdepth-1]]);
-            for(nr=0;nr<nmoves;nr++) {
-                mnr=move_nr(movelist[cdepth][nr]);
-                giterscore[nr]=2*history[cdepth][mnr][nmoves];
-                giterscore[nr]+=countermove[cdepth&1][lm][mnr];
-            }
-            sort_moves(cdepth,nmoves,giterscore);
-        }
-        else if (kill_method==HISTORY) {
-            for(nr=0;nr<nmoves;nr++) giterscore[nr]=history[cdepth]
-                                                        [ move_nr(movelist[cdepth][nr]) ] [0];
-            sort_moves(cdepth,nmoves,giterscore);
-        }
+    /* internal iterative deepening: without a hash move search this node
+       shallower first, its best move is then found in the hash table */
+    if (hashmove[0]==0 && use_hash && depth>=IIDDEPTH) {
+        alfabeta(alfa,beta,color,cdepth,depth-IIDREDUCE,flags,&oppex);
+        if (stopflag==true) return(alfa);
+        nmoves=move_list(cdepth,color);
+        if (retreive_hash(color,&min,&max,&hd,hashmove)==UNKNOWN) hashmove[0]=0;
     }
 
-    if (depth>=500) goto nosort;
-    /* tactical pattern sort */
-    if (hashmove[0]==0 && depth>=200 && depth<=300) {
-        char temp[MOVEL];
-        int i;
-        
+    /* move ordering: hash move first, without one try a tactical shot */
+    if (hashmove[0]!=0) first=find_hashmove(cdepth,nmoves,hashmove);
+    else if (depth>=200 && depth<=300) {
         pat=npat_find(color,cdepth+1);
-        if (pat==true) {
-            for(i=0;i<nmoves;i++) if (movecmp(movelist[cdepth][i],movelist[cdepth+1][0])==0) {
-                if (i!=0) {
-                    movecopy(temp,movelist[cdepth][0]);
-                    movecopy(movelist[cdepth][0],movelist[cdepth][i]);
-                    movecopy(movelist[cdepth][i],temp);
-                }
-                break;
-            }
-            //display_board();
-            //printf("\n");
-        }        
+        if (pat==true) first=find_move(cdepth,nmoves,movelist[cdepth+1][0]);
     }
 nosort:
+    init_picker(&mp,cdepth,nmoves,first);
+    nsearch=nmoves;
+    if (rootex==true) for(nr=0;nr<nmoves;nr++) if (root_excluded(movelist[cdepth][nr])==true) nsearch--;
     /* start normal alfa-beta search */
-    for(nr=0;nr<nmoves;nr++) {
+    for(nr=0,ns=-1;nr<nmoves;nr++) {
+        m=pick_move(&mp);
+        mv=movelist[cdepth][m];
+        if (rootex==true && root_excluded(mv)==true) continue;
+        ns++;
         newflags=flags;
-        do_move(movelist[cdepth][nr]);
-        if (cdepth<8) current_move[cdepth]=nr;
+        do_move(mv);
+        if (cdepth<8) current_move[cdepth]=m;
         nextdepth=depth-100;
 
         if (depth>100) {
@@ -1774,7 +2235,7 @@ nosort:
             /* extend if previous move was local */
             char *lastmove;
             lastmove=movelist[cdepth-2][current_move[cdepth-2]];
-            if (movelist[cdepth][nr][1]==lastmove[lastmove[0]-1]) {
+            if (mv[1]==lastmove[lastmove[0]-1]) {
                 nextdepth=depth;
             }
         }
@@ -1814,25 +2275,45 @@ nosort:
                 }
             }
         }
-        score=-alfabeta(-beta,-alfa,color ^1,cdepth+1,nextdepth,newflags,&oppex);
-        
+        /* late move reduction: quiet moves picked late by the history
+           and countermove scores, other than the killer, are first
+           searched shallower */
+        reduce=0;
+        if (use_lmr==true && cdepth>0 && ns>=LMRMOVES && depth>=300 && nextdepth==depth-100
+            && mp.stage==PICK_REST && mv[0]==4 && mv[2]==mv[4]
+            && movecmp(mv,killer[cdepth])!=0
+            && quiet(color^1)==true && quiet(color)==true) {
+            reduce=lmr[depth/100<LMRDEPTH?depth/100:LMRDEPTH-1][ns];
+            if (kill_method==PROBKILL && cdepth<20 && nmoves<20
+                && history[cdepth][move_nr(mv)][nmoves]<LMRHIST) reduce+=100;
+            if (beta-alfa>1) reduce-=100;
+            if (reduce>nextdepth-100) reduce=nextdepth-100;
+        }
+        if (reduce>0) {
+            score=-alfabeta(-alfa-1,-alfa,color ^1,cdepth+1,nextdepth-reduce,newflags,&oppex);
+            if (score<=alfa || stopflag==true) goto abdone;
+        }
+        if (use_pvs==true && ns>0 && beta-alfa>1) {
+            /* principal variation search: prove the move is no better
+               than alfa with a null window, search again if it is */
+            score=-alfabeta(-alfa-1,-alfa,color ^1,cdepth+1,nextdepth,newflags,&oppex);
+            if (score>alfa && score<beta && stopflag==false) {
+                score=-alfabeta(-beta,-alfa,color ^1,cdepth+1,nextdepth,newflags,&oppex);
+            }
+        }
+        else score=-alfabeta(-beta,-alfa,color ^1,cdepth+1,nextdepth,newflags,&oppex);
+
         //dprint("ab: %i %i %i %i\n",cdepth,nr,-beta,-alfa);
         //dprint("sc: %i %i %i\n",cdepth,nr,score);
-        //if (eval_type==0 && score>alfa && score<betaOrig && nr>0) { /* research */
-            /*if (cdepth==0) dprint("research: %i\n",score);*/
-          //  score=-alfabeta(-betaOrig,-score,color ^1,cdepth+1,nextdepth,newflags,&oppex);
-       //     dprint("sc2: %i\n",score);
-        
-        //}
         /*score=-alfabeta(-200000,200000,color ^1,cdepth+1,nextdepth,newflags,&oppex);*/
         /*if (cdepth==0) {
-            print_move(movelist[cdepth][nr]);
+            print_move(mv);
             dprint("  %i\n",score);
         }*/
 abdone:
         /* store score for each move (at root only) */
         if (cdepth==0) {
-            movecopy(movescore[nr].move,movelist[cdepth][nr]);
+            movecopy(movescore[nr].move,mv);
             movescore[nr].value=score;
             
             /*printf("%i/%i\r  ",nr,nmoves); fflush(stdout);*/
@@ -1842,13 +2323,13 @@ abdone:
         /*if (cdepth==0) printf("-->%i %i\n",atleastdraw,atmostdraw);*/
         /* beta cut */
         if (score>=beta) {
-            storemove(cdepth,movelist[cdepth][nr]);
-            goodmove(cdepth,movelist[cdepth][nr],nmoves);
-            undo_move(movelist[cdepth][nr]);
-            if (use_hash && depth>USEHASH) store_hash(color,depth,score,INF,movelist[cdepth][nr]);
+            storemove(cdepth,mv);
+            goodmove(cdepth,mv,nmoves);
+            undo_move(mv);
+            if (use_hash && depth>USEHASH && rootex==false) store_hash(color,depth,score,INF,mv);
             if (atleastdraw==true || score==WIN) *exact=ATLEASTDRAW;
             else *exact=NOTEXACT;
-            if (nr==nmoves-1) {
+            if (ns==nsearch-1) {
                 if (atleastdraw==true && atmostdraw==true) *exact=EXACTDRAW;
                 else if (atleastdraw==true) *exact=ATLEASTDRAW;
                 else if (atmostdraw==true) *exact=ATMOSTDRAW;
@@ -1856,18 +2337,18 @@ abdone:
                 /*if (*exact==EXACTDRAW) {printf("%i.",pieces[white|man]+pieces[white|crown]+pieces[black|man]+pieces[black|crown]); if (pieces[white|man]+pieces[white|crown]+pieces[black|man]+pieces[black|crown]>=8) {printf("\n%i\n",color);display_board();}}*/
             }
             return(score);
-        } else badmove(cdepth,movelist[cdepth][nr],nmoves);
-        undo_move(movelist[cdepth][nr]);
+        } else badmove(cdepth,mv,nmoves);
+        undo_move(mv);
         if (score>alfa) {
             alfa=score;
-            best=nr;
-            storemove(cdepth,movelist[cdepth][nr]);
+            best=m;
+            storemove(cdepth,mv);
         }
     }
     if (best!=-1) {
         goodmove2(cdepth,movelist[cdepth][best],nmoves);
     }
-    if (use_hash && depth>USEHASH && alfa>alfa0) store_hash(color,depth,alfa,alfa,movelist[cdepth][best]);
+    if (use_hash && depth>USEHASH && alfa>alfa0 && best!=-1 && rootex==false) store_hash(color,depth,alfa,alfa,movelist[cdepth][best]);
     if (atleastdraw==true && atmostdraw==true) *exact=EXACTDRAW;
     else if (atleastdraw==true) *exact=ATLEASTDRAW;
     else if (atmostdraw==true) *exact=ATMOSTDRAW;
@@ -0,0 +1,298 @@
+/*
+ * Copyright 1996 by Michel D. Grimminck
+ *
+ * All Rights Reserved
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright notice appear in all copies and that
+ * both that copyright notice and this permission notice appear in
+ * supporting documentation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+/* analysis server (dragon -serve {socket} [workers] [-sharehash]). Jobs
+   come in on a Unix domain socket, one JSON object per line:
+     {"id":7,"fen":"W:W31-50:B1-20","time":2.5,"depth":12,"multipv":3}
+   fen is a PDN FEN or W/B and 50 fields as in the hub protocol, time is
+   in seconds and depth in plies; without either a job gets SERVETIME.
+   A pool of engines (engine.c) takes the jobs in the order they arrive.
+   The databases, patterns and tables are loaded once by d_init for all
+   of them, with -sharehash they also use one hash table of workers times
+   the size. Every job is answered on its connection by JSON lines:
+     {"id":7,"type":"info","depth":8,"line":1,"score":0.060,"nodes":123,"time":0.51,"pv":"34-29 17-21"}
+     {"id":7,"type":"done","move":"34-29","ponder":"17-21","score":0.060}
+     {"id":7,"type":"error","message":"bad position"}
+   with an info line for every multipv line of every finished iteration */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "var.h"
+#include "functions.h"
+#if defined(USE_THREADS) && !defined(_WIN32)
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+typedef struct {
+    int fd;
+    int refs;                   /* the reader and the jobs not yet done */
+    volatile int dead;          /* a write failed, the client is gone */
+    pthread_mutex_t mutex;      /* one writer at a time */
+} tpConn;
+
+typedef struct _job {
+    tpConn *conn;
+    char id[SERVEID];           /* as sent, to be echoed */
+    char pos[HUBLINE];
+    float time;
+    int depth,multipv;
+    struct _job *next;
+} tpJob;
+
+static pthread_mutex_t serve_mutex=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t serve_cond=PTHREAD_COND_INITIALIZER;
+static tpJob *job_first=NULL,*job_last=NULL;
+
+static int json_field(char *line,char *key,char *value,int size,int raw)
+/* copy the value of "key" in the flat JSON object line to value. Strings
+   lose their quotes unless raw. False if line has no such key */
+{
+    char *p=line,*q;
+    int n=0,len=strlen(key),match;
+
+    /* every string followed by a colon is a key */
+    while ((p=strchr(p,'"'))!=NULL) {
+        q=++p;
+        while (*p!=0 && *p!='"') if (*p++=='\\' && *p!=0) p++;
+        if (*p==0) return(false);
+        match=(p-q==len && strncmp(q,key,len)==0);
+        p++;
+        while (*p==' ' || *p=='\t') p++;
+        if (*p!=':') continue;
+        p++;
+        if (match==true) break;
+    }
+    if (p==NULL) return(false);
+    while (*p==' ' || *p=='\t') p++;
+    if (*p=='"') {
+        if (raw==true) value[n++]=*p;
+        p++;
+        while (*p!=0 && *p!='"' && n<size-2) {
+            if (*p=='\\' && p[1]!=0) {
+                if (raw==true) value[n++]=*p;
+                p++;
+            }
+            value[n++]=*p++;
+        }
+        if (raw==true) value[n++]='"';
+    }
+    else while (*p!=0 && *p!=',' && *p!='}' && *p!=' ' && *p!='\n' && n<size-1) value[n++]=*p++;
+    value[n]=0;
+    return(true);
+}
+
+static void conn_printf(tpConn *conn,char *format,...)
+/* write a line to the client, the connection is dead once that fails */
+{
+    va_list arglist;
+    char text[MPV*MOVEL*4+512],*p;
+    int n,len;
+
+    va_start(arglist,format);
+    vsnprintf(text,sizeof(text),format,arglist);
+    va_end(arglist);
+    pthread_mutex_lock(&conn->mutex);
+    p=text;
+    len=strlen(text);
+    while (len>0 && conn->dead==false) {
+        n=write(conn->fd,p,len);
+        if (n<=0) conn->dead=true;
+        else {p+=n; len-=n;}
+    }
+    pthread_mutex_unlock(&conn->mutex);
+}
+
+static void conn_release(tpConn *conn)
+/* drop a reference, the last one closes the connection */
+{
+    int refs;
+
+    pthread_mutex_lock(&serve_mutex);
+    refs=--conn->refs;
+    pthread_mutex_unlock(&serve_mutex);
+    if (refs>0) return;
+    close(conn->fd);
+    pthread_mutex_destroy(&conn->mutex);
+    free(conn);
+}
+
+static void serve_report(tpDragon *h,void *data,int depth,int score,double t,INT64 nodes,char *pv)
+/* every finished iteration of a job, on the thread of its engine */
+{
+    tpJob *job=data;
+    char text[MPV*MOVEL*4];
+    int k,s;
+
+    if (job->conn->dead==true) {
+        dragon_stop(h);
+        return;
+    }
+    for(k=0;sprint_multipv(k,text,&s)==true;k++) {
+        conn_printf(job->conn,"{\"id\":%s,\"type\":\"info\",\"depth\":%i,\"line\":%i,\"score\":%.3f,\"nodes\":%llu,\"time\":%.2f,\"pv\":\"%s\"}\n",
+                    job->id,depth/100,k+1,s/1000.0F,nodes,t,text);
+    }
+    if (k==0) {
+        conn_printf(job->conn,"{\"id\":%s,\"type\":\"info\",\"depth\":%i,\"line\":1,\"score\":%.3f,\"nodes\":%llu,\"time\":%.2f,\"pv\":\"%s\"}\n",
+                    job->id,depth/100,score/1000.0F,nodes,t,pv);
+    }
+}
+
+static void *serve_worker(void *arg)
+/* run the queued jobs on one engine */
+{
+    tpDragon *h=arg;
+    tpJob *job;
+    char move[MOVEL*4],ponder[MOVEL*4];
+    int score;
+
+    while (true) {
+        pthread_mutex_lock(&serve_mutex);
+        while (job_first==NULL) pthread_cond_wait(&serve_cond,&serve_mutex);
+        job=job_first;
+        job_first=job->next;
+        if (job_first==NULL) job_last=NULL;
+        pthread_mutex_unlock(&serve_mutex);
+        if (job->conn->dead==false && dragon_set_position(h,job->pos)==false) {
+            conn_printf(job->conn,"{\"id\":%s,\"type\":\"error\",\"message\":\"bad position\"}\n",job->id);
+        }
+        else if (job->conn->dead==false) {
+            dragon_set_multipv(h,job->multipv);
+            dragon_search_async(h,job->time,job->depth,serve_report,job);
+            score=dragon_wait(h,move,ponder);
+            if (move[0]==0) {
+                conn_printf(job->conn,"{\"id\":%s,\"type\":\"done\",\"move\":null,\"score\":%.3f}\n",job->id,LOSE/1000.0F);
+            } else {
+                conn_printf(job->conn,"{\"id\":%s,\"type\":\"done\",\"move\":\"%s\",\"ponder\":\"%s\",\"score\":%.3f}\n",
+                            job->id,move,ponder,score/1000.0F);
+            }
+        }
+        conn_release(job->conn);
+        free(job);
+    }
+    return(NULL);
+}
+
+static void *serve_reader(void *arg)
+/* queue the jobs of one connection */
+{
+    tpConn *conn=arg;
+    tpJob *job;
+    FILE *in;
+    char line[HUBLINE],value[64];
+
+    in=fdopen(dup(conn->fd),"r");
+    while (in!=NULL && fgets(line,HUBLINE,in)!=NULL) {
+        if (strchr(line,'{')==NULL) continue;
+        job=(tpJob *) calloc(1,sizeof(tpJob));
+        if (job==NULL) break;
+        job->conn=conn;
+        if (json_field(line,"id",job->id,SERVEID,true)==false || job->id[0]==0) strcpy(job->id,"null");
+        if (json_field(line,"fen",job->pos,HUBLINE,false)==false) {
+            conn_printf(conn,"{\"id\":%s,\"type\":\"error\",\"message\":\"no fen\"}\n",job->id);
+            free(job);
+            continue;
+        }
+        if (json_field(line,"time",value,64,false)==true) job->time=atof(value);
+        if (json_field(line,"depth",value,64,false)==true) job->depth=atoi(value);
+        job->multipv=1;
+        if (json_field(line,"multipv",value,64,false)==true) job->multipv=atoi(value);
+        if (job->time<=0 && job->depth<=0) job->time=SERVETIME;
+        pthread_mutex_lock(&serve_mutex);
+        conn->refs++;
+        if (job_last==NULL) job_first=job;
+        else job_last->next=job;
+        job_last=job;
+        pthread_cond_signal(&serve_cond);
+        pthread_mutex_unlock(&serve_mutex);
+    }
+    if (in!=NULL) fclose(in);
+    conn_release(conn);
+    return(NULL);
+}
+
+void serve_loop(char *path,int workers,int sharehash)
+/* answer analysis jobs on the Unix domain socket path with workers
+   engines, each with a hash table as big as that of the program */
+{
+    struct sockaddr_un addr;
+    struct stat st;
+    tpDragon *engine[SERVEWORKERS];
+    pthread_t thread;
+    tpConn *conn;
+    int lfd,fd,i;
+
+    if (workers<1) workers=1;
+    if (workers>SERVEWORKERS) workers=SERVEWORKERS;
+    if (strlen(path)>=sizeof(addr.sun_path)) {
+        dprint("serve: socket name too long\n");
+        return;
+    }
+    signal(SIGPIPE,SIG_IGN);
+    lfd=socket(AF_UNIX,SOCK_STREAM,0);
+    if (lfd<0) {dprint("serve: no socket\n"); return;}
+    memset(&addr,0,sizeof(addr));
+    addr.sun_family=AF_UNIX;
+    strcpy(addr.sun_path,path);
+    /* a socket left by an earlier serve, never another kind of file */
+    if (lstat(path,&st)==0 && S_ISSOCK(st.st_mode)) unlink(path);
+    if (bind(lfd,(struct sockaddr *) &addr,sizeof(addr))!=0 || listen(lfd,16)!=0) {
+        dprint("serve: can not listen on %s\n",path);
+        close(lfd);
+        return;
+    }
+    for(i=0;i<workers;i++) {
+        if (sharehash==true) engine[i]=dragon_new(workers*tablesize,i>0 ? engine[0] : NULL);
+        else engine[i]=dragon_new(tablesize,NULL);
+        if (engine[i]==NULL || pthread_create(&thread,NULL,serve_worker,engine[i])!=0) break;
+        pthread_detach(thread);
+    }
+    if (i==0) {
+        dprint("serve: no engines\n");
+        close(lfd);
+        return;
+    }
+    dprint("serve: %i engines on %s\n",i,path);
+    fflush(stdout);
+    while (true) {
+        fd=accept(lfd,NULL,NULL);
+        if (fd<0) continue;
+        conn=(tpConn *) calloc(1,sizeof(tpConn));
+        if (conn==NULL) {close(fd); continue;}
+        conn->fd=fd;
+        conn->refs=1;
+        pthread_mutex_init(&conn->mutex,NULL);
+        if (pthread_create(&thread,NULL,serve_reader,conn)!=0) {
+            close(fd);
+            pthread_mutex_destroy(&conn->mutex);
+            free(conn);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+}
+#else
+void serve_loop(char *path,int workers,int sharehash)
+{
+    dprint("serve: needs USE_THREADS and Unix domain sockets\n");
+}
+#endif
@@ -23,7 +23,6 @@
 #include <unistd.h>
 #include <stdarg.h>
 
-int comNumber=0;
 
 void compress_board(unsigned char *a,BTYPE *b)
 /* stores the board b in a compressed format: a=compress(b) */
@@ -255,6 +254,33 @@ int xparse(char a,char b)
     return(lmap[x][9-y]+1);
 }
 
+double wall_time(void)
+/* monotonic wall-clock time in seconds, unaffected by the load and by
+   other threads (clock() is process cpu time except on Windows) */
+{
+#ifdef _WIN32
+    return((double) clock()/CLOCKS_PER_SEC);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return(ts.tv_sec+ts.tv_nsec*1.0E-9);
+#endif
+}
+
+float tc_alloc(float left,int movestogo,float inc)
+/* time for the next move with left seconds on the clock for movestogo
+   moves (0 if unknown) and inc seconds added per move */
+{
+    float at;
+
+    if (movestogo<=0) movestogo=TCMOVES;
+    at=(left-time_reserve)/(movestogo+2)+inc-operator_time;
+    if (at>.4*left) at=.4*left;
+    if (at<.02) at=.02;
+    return(at);
+}
+
 float alloc_time(int color)
 {
     int ml;
@@ -634,6 +660,98 @@ void init_board(void)
     game_color=white;
 }
 
+int set_board_string(char *s)
+/* sets up a position written as the side to move ('W' or 'B') followed by
+   the 50 fields with e=empty, w/b=man and W/B=crown. Returns the side to
+   move, or -1 if the string is not valid (the board is then unchanged).
+   The game history is left alone */
+{
+    BTYPE temp[93];
+    int i,color;
+
+    if (s[0]=='W' || s[0]=='w') color=white;
+    else if (s[0]=='B' || s[0]=='b') color=black;
+    else return(-1);
+    for(i=0;i<93;i++) temp[i]=invalid;
+    for(i=0;i<50;i++) {
+        switch(s[i+1]) {
+        case 'e': case '.': temp[map[i]]=empty; break;
+        case 'w': temp[map[i]]=white|man; break;
+        case 'b': temp[map[i]]=black|man; break;
+        case 'W': temp[map[i]]=white|crown; break;
+        case 'B': temp[map[i]]=black|crown; break;
+        default: return(-1);
+        }
+    }
+    copy_board(board,temp);
+    set_pieces();
+    return(color);
+}
+
+int set_board_fen(char *fen)
+/* sets up a position from a PDN FEN as written by writeFen, like
+   W:W31-35,K45:B1,2 (side to move, then the pieces per color, K for a
+   crown, ranges allowed). Returns the side to move, or -1 if the FEN is
+   not valid (the board is then unchanged). The game history is left alone */
+{
+    BTYPE temp[93];
+    int i,color,col=-1,piece,from,to,n;
+    char *s=fen;
+
+    if (*s=='"') s++;
+    if (*s=='W') color=white;
+    else if (*s=='B') color=black;
+    else return(-1);
+    s++;
+    for(i=0;i<93;i++) temp[i]=invalid;
+    for(i=0;i<50;i++) temp[map[i]]=empty;
+    while (*s!=0 && strchr(".\"] \t\r\n",*s)==NULL) {
+        if (*s==':') {
+            s++;
+            if (*s=='W') col=white;
+            else if (*s=='B') col=black;
+            else return(-1);
+            s++;
+            continue;
+        }
+        if (*s==',') {s++; continue;}
+        if (col<0) return(-1);
+        piece=man;
+        if (*s=='K') {piece=crown; s++;}
+        if (sscanf(s,"%d%n",&from,&n)!=1) return(-1);
+        s+=n;
+        to=from;
+        if (*s=='-') {
+            s++;
+            if (sscanf(s,"%d%n",&to,&n)!=1) return(-1);
+            s+=n;
+        }
+        if (from<1 || to>50 || from>to) return(-1);
+        for(i=from;i<=to;i++) temp[map[i-1]]=piece|col;
+    }
+    copy_board(board,temp);
+    set_pieces();
+    return(color);
+}
+
+void get_board_string(char *s,int color)
+/* the inverse of set_board_string, s must hold 52 characters */
+{
+    int i;
+
+    s[0]=(color==white) ? 'W' : 'B';
+    for(i=0;i<50;i++) {
+        switch(board[map[i]]) {
+        case white|man: s[i+1]='w'; break;
+        case black|man: s[i+1]='b'; break;
+        case white|crown: s[i+1]='W'; break;
+        case black|crown: s[i+1]='B'; break;
+        default: s[i+1]='e';
+        }
+    }
+    s[51]=0;
+}
+
 void save_board(int color,char *name)
 {
     int p,x,y;
@@ -1073,6 +1191,20 @@ void init_var(void)
     for(i=45;i<50;i++) promote[black][map[i]]=black|crown;
     /* hash randoms */
     for(i=0;i<50;i++) for(j=0;j<6;j++) hash_rnd[i][j]=rnd[i]*j;
+    {
+        unsigned INT64 r=0x9E3779B97F4A7C15ULL;
+
+        for(j=0;j<8;j++) for(i=0;i<93;i++) man_rnd[j][i]=man_bit[j][i]=pos_rnd[j][i]=0;
+        for(i=0;i<50;i++) for(j=white|man;j<=(black|man);j++) {
+            r^=r<<13; r^=r>>7; r^=r<<17;
+            man_rnd[j][map[i]]=r;
+            man_bit[j][map[i]]=1ULL<<i;
+        }
+        for(i=0;i<50;i++) for(j=white|man;j<=(black|crown);j++) {
+            r^=r<<13; r^=r>>7; r^=r<<17;
+            pos_rnd[j][map[i]]=r;
+        }
+    }
     init_stats();
     test_nr=0;
     for(i=0;i<93;i++) xray_w[i]=xray_b[i]=0;
@@ -1092,12 +1224,13 @@ void init_stats(void)
 {
     int i,j,k;
 
-    nsort=neval=ngen=ndat=inhash=outhash=nmat=nmovelist=nquiet=nquietfail=precount=dbfail=ineval=outeval=pat_try=pat_found=pat_succes=0;
+    nsort=neval=ngen=ndat=inhash=outhash=nmat=nmovelist=nquiet=nquietfail=precount=dbfail=ineval=outeval=neprobe=inman=outman=pat_try=pat_found=pat_succes=0;
     for(i=0;i<MAXPLY;i++) deval[i]=0;
     for(i=0;i<MPV;i++) for(j=0;j<MPV;j++) PV[i][j][0]=0;
-    for(i=0;i<4096;i++) db_usage[i]=0;
+    fold_db_usage();
     for(i=0;i<8;i++) pieces[i]=0;
     for(i=0;i<50;i++) pieces[board[map[i]]]++;
+    init_psq();
     for(i=0;i<9;i++) varCount[i]=0;
     
     if (kill_method==PROBKILL) for(k=0;k<20;k++) for(i=0;i<150;i++) for(j=0;j<20;j++) history[k][i][j]=20;
@@ -1110,6 +1243,7 @@ void set_pieces(void)
     int i;
     pieces[2]=pieces[3]=pieces[4]=pieces[5]=0;
     for(i=0;i<50;i++) pieces[board[map[i]]]++;
+    psq_sum();
 }
 
 void print_db_namefromnr(int i)
@@ -1151,7 +1285,7 @@ void print_stats(void)
             printf("\n");
             break;
         }
-    dprint("    #eval:%llu #mat:%llu #preeval %llu #ml:%llu #quiet:%llu (%llu) #ngen:%llu in:%llu out %llu #db:%llu (%.1f%%) #ex:%llu #dbfail:%llu #ine:%llu #oute:%llu  pat:%llu/%llu/%llu\n",neval,nmat,precount,nmovelist,nquiet,nquietfail,ngen,inhash,outhash,ndat,nper,nsort,dbfail,ineval,outeval,pat_try,pat_found,pat_succes);
+    dprint("    #eval:%llu #mat:%llu #preeval %llu #ml:%llu #quiet:%llu (%llu) #ngen:%llu in:%llu out %llu #db:%llu (%.1f%%) #ex:%llu #dbfail:%llu #ine:%llu #oute:%llu (%.1f%%) #man:%llu/%llu pat:%llu/%llu/%llu\n",neval,nmat,precount,nmovelist,nquiet,nquietfail,ngen,inhash,outhash,ndat,nper,nsort,dbfail,ineval,outeval,(neprobe!=0?100.0*outeval/neprobe:0.0),inman,outman,pat_try,pat_found,pat_succes);
     winprint("|");
     /*printf("pieces:%i:%i:%i:%i\n",pieces[2],pieces[3],pieces[4],pieces[5]);*/
 }
@@ -1261,93 +1395,35 @@ void dprint( char* format, ... )
 /* print to both the windows and terminal interface */
 {
     char buffer[4000];
-    char ren[256];
-    int hasNewLine=0;
-    int i;
-    FILE *out;
     va_list arglist;
     va_start( arglist, format );
     vsprintf( buffer,format, arglist );
     printf("%s",buffer);
     va_end( arglist );
     
-    if (windows==true) {
-        /* printing to windows-interface */
-        out=fopen("com/tmp.tmp","a");
-        if (out==NULL) {printf("warning: can not open interface file\n"); return;}
-        fprintf(out,"%s%\000",buffer);
-        fclose(out);
-        for(i=0;buffer[i]!=0;i++) {
-            if (buffer[i]==13 || buffer[i]==10) {
-                hasNewLine=true;
-            }
-    
-        }
-        if (hasNewLine==true) {
-            sprintf(ren,"com/%i.txt",comNumber);
-            rename("com/tmp.tmp",ren);
-            comNumber++;
-        }
-    }
+    if (windows==true) comm_output(buffer);
 }
 
 void winprint( char* format, ... )
 /* print to the windows interface only */
 {
     char buffer[1000];
-    char ren[256];
-    int hasNewLine=0;
-    int i;
 
     if (windows==true) {
-        FILE *out;
         va_list arglist;
         va_start( arglist, format );
         vsprintf( buffer,format, arglist );
         va_end( arglist );
-        
-        /* printing to windows-interface */
-        out=fopen("com/tmp.tmp","a");
-        if (out==NULL) {printf("warning: can not open interface file\n"); return;}
-        fprintf(out,"%s",buffer);
-        fclose(out);
-        for(i=0;buffer[i]!=0;i++) {
-            if (buffer[i]==13 || buffer[i]==10) {
-                hasNewLine=true;
-            }
-        }
-        if (hasNewLine==true) {
-            
-            sprintf(ren,"com/%i.txt",comNumber);
-            rename("com/tmp.tmp",ren);
-            comNumber++;
-        }
+        comm_output(buffer);
     }
 }
 
 void dscanf(char *format, ...)
 /* read from windows/terminal interface */
 {
-    FILE *in;
     va_list arglist;
     va_start( arglist, format );
-    if (windows==false) {
-        vscanf( format, arglist );
-    }
-    else {
-        /* read from windows interface */
-        while(true) {
-            in=fopen("com/win.in","r");
-            if (in==NULL) {
-                usleep(10000);
-                continue;
-            }          
-            vfscanf( in,format, arglist );
-            fclose(in);
-            unlink("com/win.in");
-            break;
-        }
-    }
+    comm_vscanf(format,arglist);
     va_end( arglist );
 }    
 
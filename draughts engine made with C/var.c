@@ -14,7 +14,8 @@
  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
  */
 
-/* global variables */
+/* global variables. LOCAL ones are the state of a search, thread-local
+   with USE_THREADS so that every engine instance has its own */
 
 #include "const.h"
 #ifndef POS
@@ -46,15 +47,24 @@ POS char nextall[2][93][20][20];
     see macro's RBOARD() and LBOARD
  */
 
-POS BTYPE board[93],blocked[93];
+POS LOCAL BTYPE board[93],blocked[93];
 POS char takeback[4][4][4][4][4][4];
 /* see patsearc.init_takeback for documentation */
 
-POS int pieces[8];
+POS LOCAL int pieces[8];
+/* square-table evaluation terms, kept incrementally by do_move/undo_move */
+POS LOCAL int psq_eval[2],psq_center[2],psq_wing[2][4],psq_tempo[2];
+POS LOCAL short psq_tab[8][93][4];
+/* men-only structure: zobrist key and exact bitmasks, kept in the same way */
+POS LOCAL unsigned INT64 man_key,man_bits[2];
+POS unsigned INT64 man_rnd[8][93],man_bit[8][93];
+/* zobrist key of the whole position */
+POS LOCAL unsigned INT64 pos_key;
+POS unsigned INT64 pos_rnd[8][93];
 POS char promote[2][93];
-POS char movelist[MAXPLY][MAXNM][MOVEL];
-POS char killer [MAXPLY][MOVEL];
-POS struct _movescore {
+POS LOCAL char movelist[MAXPLY][MAXNM][MOVEL];
+POS LOCAL char killer [MAXPLY][MOVEL];
+POS LOCAL struct _movescore {
     char move[MOVEL];
     int value;
 } movescore[MAXNM];
@@ -68,15 +78,15 @@ POS struct _tpat
 } tpat[NPAT];
 
 
-POS int tomove;
+POS LOCAL int tomove;
 
-POS INT64 nsort,neval,ngen,ndat,nmat,nmovelist,nquiet,nquietfail,precount,dbfail,pat_try,pat_found,pat_succes;
-POS INT64 tneval;  /* total evaluations during this move */
+POS LOCAL INT64 nsort,neval,ngen,ndat,nmat,nmovelist,nquiet,nquietfail,precount,dbfail,pat_try,pat_found,pat_succes;
+POS LOCAL INT64 tneval;  /* total evaluations during this move */
 POS char workdir[256]=WORKDIR;
 POS char version[128]=VERSION;
-POS char PV[MPV][MPV][MOVEL];
+POS LOCAL char PV[MPV][MPV][MOVEL];
 POS int maxpv=7;
-POS int deval[MAXPLY];
+POS LOCAL int deval[MAXPLY];
 POS int quiescence=true;
 POS int do_order=true;
 POS int do_res=true;
@@ -85,7 +95,7 @@ POS int do_res=true;
 #else
     POS unsigned char *database[4096*81];
 #endif
-POS int db_usage[4096];
+POS LOCAL int db_usage[4096];  /* probes of this thread since init_stats */
 POS int loadDatabaseOnDemand[4096*81];
 POS int dtwStatus[4096*81];   //0= don't know, 1=not available, 2=available
 
@@ -99,22 +109,32 @@ typedef struct  {
     char move[2];
     short int depth;
 } tpTranspos;
-tpTranspos *transpos;
-POS struct _evalcache {
+LOCAL tpTranspos *transpos;
+POS LOCAL struct _evalcache {
     unsigned int hashkey;
     unsigned char board[18];
     int score;
-} evalcache[MAXEVAL],rephash[REPHASH];
-POS int tablesize=NHASH;
+} rephash[REPHASH];
+/* eval cache: power of 2 entries of 32 bit key signature + 32 bit score */
+POS LOCAL unsigned INT64 *evaltable;
+POS LOCAL unsigned INT64 evalmask=0;
+POS LOCAL int tablesize=NHASH;
 POS int use_hash=true;
-POS INT64 inhash,outhash,ineval,outeval;
+POS int use_pvs=true;  /* null window search and aspiration windows */
+POS int use_lmr=true;  /* late move reductions */
+POS int use_shots=true;  /* tactical shot rules of npat_find */
+POS int batch_threads=BATCHTHREADS;  /* most threads of one evaluate_batch */
+POS char dxp_address[40]="127.0.0.1";  /* interface dxp_listen binds, "any" for all */
+POS LOCAL int multipv=1;  /* number of best lines play() and think() report */
+POS LOCAL INT64 inhash,outhash,ineval,outeval,neprobe,inman,outman;
 POS int hash_rnd[50][6];
 POS int eval_type=NORMAL;
 POS int pattern_use[49];
 POS int default_search=800000;
-POS int default_eval=0,stage=0;
-POS unsigned int history[MAXPLY+1][150][20];
-POS unsigned int countermove[2][150][150];
+POS int default_eval=0;
+POS LOCAL int stage=0;
+POS LOCAL unsigned int history[MAXPLY+1][150][20];
+POS LOCAL unsigned int countermove[2][150][150];
 POS int invmap[93] ={
                         -1, -1, -1, -1, -1, -1, -1,
                         -1, -1, -1, -1, -1, -1,
@@ -158,29 +178,30 @@ POS int selective=true;
 POS int predeepning=300;
 POS int usexv=false;
 POS int usecol=true;
-POS int varCount[10];  // various counters
+POS LOCAL int varCount[10];  // various counters
 /* time control variables for time control per game */
-POS float timeUsed[2]={0,0};
+POS LOCAL float timeUsed[2]={0,0};
 POS int timeControlMoves=130;  /* number of half-moves for first time control */
 POS float timeForFirstControl=300;  /* time to reach first time control */
 POS int timeControlMoves2=80;  /* number of half-moves for the second and next controls */
 POS float timeForSecondControl=60;  /* time to reach second and other time controls */
+POS LOCAL double search_deadline=0;  /* wall_time() at which evalboard stops a search without timer thread, 0 for none */
 POS float time_reserve=0;  /* time to keep in reserve before the next time control */
 POS float operator_time=0;  /* time to input move and press the clock in computer-computer games */
 
 
-POS struct _game_history {
+POS LOCAL struct _game_history {
     unsigned char board[25];
     char move[MOVEL];
     char comment[MAXCOMMENT];
     char tmp[MAXCOMMENT];
 } game_history[300];
-POS int game_history_nr=0;
-POS int game_history_max=0;
-POS int game_color=white;
-POS int game_history_firstcolor=0;
+POS LOCAL int game_history_nr=0;
+POS LOCAL int game_history_max=0;
+POS LOCAL int game_color=white;
+POS LOCAL int game_history_firstcolor=0;
 
-POS struct _pdn_info {
+POS LOCAL struct _pdn_info {
     char whitepl[100];
     char blackpl[100];
     char event[100];
@@ -206,20 +227,20 @@ POS int    param_a[100]={0, 8,  10,  3, 10,  9, 10,  0, 35,  60, 20, 40,  3, 20,
 POS int    param_b[100]={0, 11,  15,  11, 10, 14, 10,  0, 35,  60, 20, 32,  3, 20, 34, 28,  4};  // middlegame
 POS int    param_c[100]={0, 11,  18,  11,  2, 22, 10,  0, 35,  60, 30, 25,  3,  0, 70, 25,  8};  // endgame
 
-POS int parameters[100]={0, 70,-19,-78, 30, -1, -1, 69,-52,-23, 87,-37,  7, 33,-16, 25,-91}; /* 186/384 stage b at 5 ply */
+POS LOCAL int parameters[100]={0, 70,-19,-78, 30, -1, -1, 69,-52,-23, 87,-37,  7, 33,-16, 25,-91}; /* 186/384 stage b at 5 ply */
 
 int windows=false;
-int lastSearchDepth;
-int inDatabases;   /* boolean indicating whether the root position is in the databases */
-int ignoreDB1;  /* don't get theoretic value from this database_nr (used when root position is in the databases */
-int ignoreDB2;  /* don't get theoretic value from this database_nr */
+LOCAL int lastSearchDepth;
+LOCAL int inDatabases;   /* boolean indicating whether the root position is in the databases */
+LOCAL int ignoreDB1;  /* don't get theoretic value from this database_nr (used when root position is in the databases */
+LOCAL int ignoreDB2;  /* don't get theoretic value from this database_nr */
 int allowTwoPlyIncrements=true;  /* allows the 'play' engine to increment search depth by 2 ply */
 int blockingPlay=0;  /* >0 mean try to avoid exchanges */
-int useBlockingPlay=false;
-int startMan=0;  /* number of man at beginning of search */
+LOCAL int useBlockingPlay=false;
+LOCAL int startMan=0;  /* number of man at beginning of search */
 int bookMode=1;  /* 0=no book, 1=default, 2=tournament mode */
 char breakThrough[2*128*6561];  /* breakthroug-table */
-int cntPos;
-int xray_w[93],xray_b[93];
+LOCAL int cntPos;
+LOCAL int xray_w[93],xray_b[93];
 
 
@@ -25,16 +25,22 @@ extern int lmap[10][10];
 extern char next[2][93][4];
 extern char nextall[2][93][20][20];
 extern char takeback[4][4][4][4][4][4];
-extern BTYPE board[93],blocked[93];
-extern int pieces[8];
+extern LOCAL BTYPE board[93],blocked[93];
+extern LOCAL int pieces[8];
+extern LOCAL int psq_eval[2],psq_center[2],psq_wing[2][4],psq_tempo[2];
+extern LOCAL short psq_tab[8][93][4];
+extern LOCAL unsigned INT64 man_key,man_bits[2];
+extern unsigned INT64 man_rnd[8][93],man_bit[8][93];
+extern LOCAL unsigned INT64 pos_key;
+extern unsigned INT64 pos_rnd[8][93];
 extern char promote[2][93];
-extern char movelist[MAXPLY][MAXNM][MOVEL];
-extern char killer[MAXPLY][MOVEL];
-extern struct _movescore {
+extern LOCAL char movelist[MAXPLY][MAXNM][MOVEL];
+extern LOCAL char killer[MAXPLY][MOVEL];
+extern LOCAL struct _movescore {
     char move[MOVEL];
     int value;
     } movescore[MAXNM];
-extern int tomove;
+extern LOCAL int tomove;
 extern struct _tpat
 {
   char board[50];
@@ -44,10 +50,10 @@ extern struct _tpat
   char movelist[12][32];
 } tpat[NPAT];
 
-extern INT64 nsort,neval,ngen,ndat,nmat,nmovelist,nquiet,nquietfail,precount,dbfail,pat_try,pat_found,pat_succes;
-extern INT64 tneval;
-extern char PV[MPV][MPV][MOVEL];
-extern int deval[MAXPLY];
+extern LOCAL INT64 nsort,neval,ngen,ndat,nmat,nmovelist,nquiet,nquietfail,precount,dbfail,pat_try,pat_found,pat_succes;
+extern LOCAL INT64 tneval;
+extern LOCAL char PV[MPV][MPV][MOVEL];
+extern LOCAL int deval[MAXPLY];
 extern int quiescence;
 extern int do_order;
 extern int do_res,maxpv;
@@ -56,11 +62,13 @@ extern int do_res,maxpv;
 #else
     extern unsigned char *database[4096*81];
 #endif
-extern int db_usage[4096];
+extern LOCAL int db_usage[4096];
 extern int loadDatabaseOnDemand[4096*81];
 extern int dtwStatus[4096*81];   //0= don't know, 1=not available, 2=available
 extern int use_db;
-typedef struct  {
+extern int db_shared;
+extern char db_shared_dir[256];
+typedef struct _transpos {
     unsigned int hashkey;
     int min_score;
     int max_score;
@@ -69,41 +77,51 @@ typedef struct  {
     char move[2];
     short int depth;
 } tpTranspos;
-extern tpTranspos *transpos;
-extern struct _evalcache {
+extern LOCAL tpTranspos *transpos;
+extern LOCAL struct _evalcache {
     unsigned int hashkey;
     unsigned char board[18];
     int score;
-  } evalcache[MAXEVAL],rephash[REPHASH];
-extern int tablesize;
+  } rephash[REPHASH];
+extern LOCAL unsigned INT64 *evaltable;
+extern LOCAL unsigned INT64 evalmask;
+extern LOCAL int tablesize;
 extern int use_hash;
-extern INT64 inhash,outhash,ineval,outeval;
+extern int use_pvs;
+extern int use_lmr;
+extern int use_shots;
+extern int batch_threads;
+extern char dxp_address[40];
+extern LOCAL int multipv;
+extern LOCAL INT64 inhash,outhash,ineval,outeval,neprobe,inman,outman;
 extern int hash_rnd[50][6];
 extern int eval_type;
 extern int pattern_use[49];
 extern int default_search;
-extern int default_eval,stage;
-extern unsigned int history[20][150][20];
-extern unsigned int countermove[2][150][150];
+extern int default_eval;
+extern LOCAL int stage;
+extern LOCAL unsigned int history[20][150][20];
+extern LOCAL unsigned int countermove[2][150][150];
 extern int invmap[128];
 extern int map[50],reverse_map[50],reverse_color[16];
 extern int kill_method;
 extern double test_nr,test_e,test_e2;
 extern double test_t,test_t2;
-extern int parameters[100],param_a[100],param_b[100],param_c[100];
+extern LOCAL int parameters[100];
+extern int param_a[100],param_b[100],param_c[100];
 extern char pdnfile[100],dcpfile[100];
 extern int search_min,search_max;
 extern float perc;
 extern char ref_board[MAXREF][50];
 extern char ref_move[MAXREF][MOVEL];
 extern int ref_nr;
-extern struct _game_history {
+extern LOCAL struct _game_history {
     unsigned char board[25];
     char move[MOVEL];
     char comment[MAXCOMMENT];
     char tmp[MAXCOMMENT];
 } game_history[200];
-extern struct _pdn_info {
+extern LOCAL struct _pdn_info {
     char whitepl[100];
     char blackpl[100];
     char event[100];
@@ -114,18 +132,21 @@ extern struct _pdn_info {
 } pdn_info;
 extern int progress[50];
 extern char workdir[256],version[128];
-extern int game_history_nr,game_history_max,game_color,game_history_firstcolor;
+extern LOCAL int game_history_nr,game_history_max,game_color,game_history_firstcolor;
 extern int selective,predeepning;
 extern int usexv;
 extern int usecol;
 extern float time_left[2];
 extern float time_incr;
 extern INT64 mem64_diskActivity;
-extern int xray_w[93],xray_b[93];
+extern LOCAL int xray_w[93],xray_b[93];
 extern int windows;
-extern int stopflag;
+extern LOCAL volatile int stopflag;
+extern LOCAL volatile int pondering;
+extern struct _clock *main_clock;
+extern LOCAL double search_deadline;
 
-extern float timeUsed[2];
+extern LOCAL float timeUsed[2];
 extern int timeControlMoves;  /* number of half-moves for first time control */
 extern float timeForFirstControl;  /* time to reach first time control */
 extern int timeControlMoves2;  /* number of half-moves for the second and next controls */
@@ -133,19 +154,19 @@ extern float timeForSecondControl;  /* time to reach second and other time contr
 extern float time_reserve;  /* time to keep in reserve before the next time control */
 extern float operator_time;  /* time to input move and press the clock in computer-computer games */
 
-extern int lastSearchDepth;
-extern int inDatabases;
-extern int ignoreDB1;
-extern int ignoreDB2;
+extern LOCAL int lastSearchDepth;
+extern LOCAL int inDatabases;
+extern LOCAL int ignoreDB1;
+extern LOCAL int ignoreDB2;
 extern int allowTwoPlyIncrements;
 extern int blockingPlay; 
-extern int useBlockingPlay;
-extern int startMan;
+extern LOCAL int useBlockingPlay;
+extern LOCAL int startMan;
 extern int mapTo4[100];
 extern int bookMode;
 extern char breakThrough[2*128*6561];
-extern int cntPos;
-extern int varCount[10];  // various counters
+extern LOCAL int cntPos;
+extern LOCAL int varCount[10];  // various counters
 extern char *db33;
 extern int db33a;
 extern int db33b;